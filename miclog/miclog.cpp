@@ -0,0 +1,236 @@
+// Reads the mute event log of microphone_toggler (mute_events.bin), also
+// while the program is running:
+//
+//   miclog [--file PATH] [--from TIME] [--to TIME] [--device TEXT] [--source NAME] list|daily
+//
+// list prints one "time<TAB>device<TAB>was<TAB>now<TAB>source" line per
+// change, with "<TAB>failed" when the device refused. daily prints
+// "date<TAB>device<TAB>HH:MM:SS", the time each device spent muted per day.
+// TIME is 2026-10-15 or 2026-10-15T09:30:00, days and times are UTC.
+// A device muted at the newest record counts as muted until --to or now.
+// Exit codes: 0 done, 2 bad usage, 3 no readable log.
+
+#include <windows.h>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "../microphone_toggler/mute_event_log.h"
+
+const char* DEFAULT_FILE = "mute_events.bin";
+const int64_t US_PER_SECOND = 1000000;
+const int64_t US_PER_DAY = 86400 * US_PER_SECOND;
+
+enum ExitCode {
+    EXIT_DONE = 0,
+    EXIT_USAGE = 2,
+    EXIT_NO_LOG = 3
+};
+
+struct Filter {
+    int64_t from_us = INT64_MIN;
+    int64_t to_us = INT64_MAX;
+    std::string device;
+    bool any_source = true;
+    MuteSource source = MuteSource::Unknown;
+
+    bool matches_device(const MuteEventRecord& record) const {
+        return device.empty() || mute_event_device(record).find(device) != std::string_view::npos;
+    }
+};
+
+// Days since 1970-01-01 of a proleptic Gregorian date, and back
+static int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = (unsigned)(y - era * 400);
+    unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+static void civil_from_days(int64_t z, int& y, unsigned& m, unsigned& d) {
+    z += 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    unsigned doe = (unsigned)(z - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = (int)(yoe + era * 400 + (m <= 2));
+}
+
+static int64_t floor_div(int64_t a, int64_t b) {
+    return a / b - ((a % b != 0) && ((a < 0) != (b < 0)));
+}
+
+static bool parse_time(const char* text, int64_t& us) {
+    int y, mo, d, h = 0, mi = 0, s = 0;
+    char end = 0;
+    int fields = sscanf_s(text, "%d-%d-%dT%d:%d:%d%c", &y, &mo, &d, &h, &mi, &s, &end, 1);
+    if (fields != 3 && fields != 6 && !(fields == 7 && end == 'Z')) return false;
+    if (mo < 1 || mo > 12 || d < 1 || d > 31 || h > 23 || mi > 59 || s > 59 || h < 0 || mi < 0 || s < 0) return false;
+
+    us = (days_from_civil(y, mo, d) * 86400 + h * 3600 + mi * 60 + s) * US_PER_SECOND;
+    return true;
+}
+
+static std::string format_date(int64_t day) {
+    int y;
+    unsigned m, d;
+    civil_from_days(day, y, m, d);
+    char text[32];
+    snprintf(text, sizeof(text), "%04d-%02u-%02u", y, m, d);
+    return text;
+}
+
+// 2026-10-15T09:12:03.481Z, like the structured log
+static std::string format_time(int64_t us) {
+    int64_t day = floor_div(us, US_PER_DAY);
+    int64_t in_day = us - day * US_PER_DAY;
+    int64_t seconds = in_day / US_PER_SECOND;
+    char text[40];
+    snprintf(text, sizeof(text), "%sT%02d:%02d:%02d.%03dZ", format_date(day).c_str(),
+        (int)(seconds / 3600), (int)(seconds / 60 % 60), (int)(seconds % 60), (int)(in_day % US_PER_SECOND / 1000));
+    return text;
+}
+
+// A copy of the whole file, readable while microphone_toggler writes it
+static bool read_log(const std::string& path, std::string& bytes) {
+    std::wstring wide(path.begin(), path.end());
+    HANDLE file = CreateFileW(wide.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    bool ok = GetFileSizeEx(file, &size) && size.QuadPart == (LONGLONG)MuteEventLog::FILE_SIZE;
+    if (ok) {
+        bytes.resize(MuteEventLog::FILE_SIZE);
+        DWORD read = 0;
+        ok = ReadFile(file, &bytes[0], (DWORD)bytes.size(), &read, nullptr) && read == bytes.size();
+    }
+    CloseHandle(file);
+    return ok;
+}
+
+static int run_list(const std::vector<MuteEventRecord>& records, const Filter& filter) {
+    for (const MuteEventRecord& record : records) {
+        if (record.time_us < filter.from_us || record.time_us >= filter.to_us) continue;
+        if (!filter.matches_device(record)) continue;
+        if (!filter.any_source && record.source != (uint8_t)filter.source) continue;
+
+        printf("%s\t%.*s\t%s\t%s\t%s%s\n", format_time(record.time_us).c_str(),
+            (int)mute_event_device(record).size(), mute_event_device(record).data(),
+            record.was_muted ? "muted" : "unmuted", record.muted ? "muted" : "unmuted",
+            mute_source_name((MuteSource)record.source), (record.flags & MUTE_EVENT_FAILED) ? "\tfailed" : "");
+    }
+    return EXIT_DONE;
+}
+
+// Every change counts, whatever its source: the state is what matters here
+static int run_daily(const std::vector<MuteEventRecord>& records, const Filter& filter) {
+    struct DeviceState {
+        std::string name;
+        bool muted = false;
+        int64_t since = 0;
+    };
+    std::unordered_map<uint32_t, DeviceState> devices;
+    std::map<std::pair<int64_t, std::string>, int64_t> muted_us; // by day and device
+
+    auto add_interval = [&](const std::string& name, int64_t start, int64_t end) {
+        start = start > filter.from_us ? start : filter.from_us;
+        end = end < filter.to_us ? end : filter.to_us;
+        while (start < end) {
+            int64_t day = floor_div(start, US_PER_DAY);
+            int64_t day_end = (day + 1) * US_PER_DAY;
+            int64_t stop = end < day_end ? end : day_end;
+            muted_us[{ day, name }] += stop - start;
+            start = stop;
+        }
+    };
+
+    for (const MuteEventRecord& record : records) {
+        if (!filter.matches_device(record)) continue;
+
+        // Muted before the oldest record kept: since when is unknown, not counted
+        DeviceState& device = devices[record.device_hash];
+        device.name.assign(mute_event_device(record));
+        if (device.muted) add_interval(device.name, device.since, record.time_us);
+        device.muted = record.muted != 0;
+        device.since = record.time_us;
+    }
+
+    int64_t now = mute_event_now_us();
+    for (const auto& entry : devices) {
+        if (entry.second.muted) add_interval(entry.second.name, entry.second.since, now);
+    }
+
+    for (const auto& entry : muted_us) {
+        int64_t seconds = entry.second / US_PER_SECOND;
+        printf("%s\t%s\t%02lld:%02lld:%02lld\n", format_date(entry.first.first).c_str(), entry.first.second.c_str(),
+            (long long)(seconds / 3600), (long long)(seconds / 60 % 60), (long long)(seconds % 60));
+    }
+    return EXIT_DONE;
+}
+
+static bool parse_source(const char* name, MuteSource& source) {
+    for (MuteSource candidate : MUTE_SOURCES) {
+        if (strcmp(name, mute_source_name(candidate)) == 0) {
+            source = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+static int usage() {
+    fprintf(stderr,
+        "usage: miclog [--file PATH] [--from TIME] [--to TIME] [--device TEXT] [--source NAME] <command>\n"
+        "\n"
+        "  list    print every change as time, device, was, now and source\n"
+        "  daily   print the time each device spent muted, per day\n"
+        "\n"
+        "TIME is 2026-10-15 or 2026-10-15T09:30:00 (UTC), --to is exclusive.\n"
+        "NAME is hotkey, tray, control, voice, external, exit or recovery (list only).\n");
+    return EXIT_USAGE;
+}
+
+int main(int argc, char** argv) {
+    std::string path = DEFAULT_FILE;
+    Filter filter;
+    const char* command = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--file") == 0 && has_value) path = argv[++i];
+        else if (strcmp(argv[i], "--from") == 0 && has_value) {
+            if (!parse_time(argv[++i], filter.from_us)) return usage();
+        }
+        else if (strcmp(argv[i], "--to") == 0 && has_value) {
+            if (!parse_time(argv[++i], filter.to_us)) return usage();
+        }
+        else if (strcmp(argv[i], "--device") == 0 && has_value) filter.device = argv[++i];
+        else if (strcmp(argv[i], "--source") == 0 && has_value) {
+            if (!parse_source(argv[++i], filter.source)) return usage();
+            filter.any_source = false;
+        }
+        else if (!command && argv[i][0] != '-') command = argv[i];
+        else return usage();
+    }
+    if (!command || (strcmp(command, "list") != 0 && strcmp(command, "daily") != 0)) return usage();
+
+    std::string bytes;
+    MuteEventReader reader;
+    if (!read_log(path, bytes) || !reader.open(bytes.data(), bytes.size())) {
+        fprintf(stderr, "miclog: '%s' is missing or not a mute event log\n", path.c_str());
+        return EXIT_NO_LOG;
+    }
+
+    std::vector<MuteEventRecord> records = reader.records();
+    if (strcmp(command, "list") == 0) return run_list(records, filter);
+    return run_daily(records, filter);
+}
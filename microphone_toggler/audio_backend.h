@@ -0,0 +1,90 @@
+#pragma once
+
+// Platform-neutral capture endpoint interface.
+// Nothing in here may include platform headers, so the toggle path can be
+// built against the mock backend on any OS.
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Device information structure
+struct AudioDevice {
+    std::string id;
+    std::string name;
+    std::string description;
+    bool is_default = false;
+    bool is_enabled = false;
+};
+
+// Called whenever the endpoint mute state changes.
+// self_initiated is true when the change came from our own set_mute() call.
+// May be invoked from a backend-owned thread.
+using MuteChangeHandler = std::function<void(bool muted, bool self_initiated)>;
+
+// Capture device topology changes reported by the backend
+enum class DeviceEvent {
+    Added,
+    Removed,
+    StateChanged,       // enabled/disabled/unplugged, re-describe to find out
+    DefaultChanged,     // id is the new default, empty when there is none
+    PropertiesChanged   // e.g. the friendly name was edited
+};
+
+// May be invoked from a backend-owned thread, must return quickly
+using DeviceChangeHandler = std::function<void(DeviceEvent event, const std::string& id)>;
+
+// Mono samples in [-1, 1], valid only during the call.
+// Invoked on a backend-owned thread, must not block.
+using CaptureSampleHandler = std::function<void(const float* samples, size_t count)>;
+
+// Live audio from a capture endpoint, for level metering and voice detection
+class CaptureStream {
+public:
+    virtual ~CaptureStream() = default;
+
+    virtual unsigned sample_rate() const = 0;
+
+    // Delivers audio to handler until stop() or destruction
+    virtual bool start(CaptureSampleHandler handler) = 0;
+    virtual void stop() = 0;
+};
+
+// A single opened capture endpoint (one microphone)
+class CaptureEndpoint {
+public:
+    virtual ~CaptureEndpoint() = default;
+
+    virtual const std::string& id() const = 0;
+    virtual bool get_mute(bool& muted) = 0;
+    virtual bool set_mute(bool muted) = 0;
+
+    // Replaces any previously installed handler, pass nullptr to unsubscribe
+    virtual bool subscribe(MuteChangeHandler handler) = 0;
+
+    // nullptr when the backend has no audio to offer
+    virtual std::unique_ptr<CaptureStream> open_stream() { return nullptr; }
+};
+
+class AudioBackend {
+public:
+    virtual ~AudioBackend() = default;
+
+    virtual const char* name() const = 0;
+    virtual bool initialize() = 0;
+    virtual std::vector<AudioDevice> enumerate_devices() = 0;
+    virtual std::unique_ptr<CaptureEndpoint> open_default_device() = 0;
+    virtual std::unique_ptr<CaptureEndpoint> open_device(const std::string& id) = 0;
+
+    // Fills in a single device, false if it is not an active capture device
+    virtual bool describe_device(const std::string& id, AudioDevice& device) = 0;
+    virtual std::string default_device_id() = 0;
+
+    // Replaces any previously installed handler, pass nullptr to unsubscribe
+    virtual bool subscribe_devices(DeviceChangeHandler handler) = 0;
+};
+
+// Backend factory, defined by the application translation unit.
+// Returns nullptr for unknown or unsupported backend names.
+std::unique_ptr<AudioBackend> create_audio_backend(const std::string& name);
@@ -0,0 +1,401 @@
+#pragma once
+
+// Program settings and the schema that describes them.
+// Each setting is one line in CONFIG_SCHEMA: its key, the Config member it
+// fills, type, range, default, comment and the subsystems that depend on it.
+// Parsing, validation, change detection and the written file all come from
+// that table, so adding a setting means adding a member and a schema line.
+// Portable, no platform headers.
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "config_parser.h"
+#include "hotkey_matcher.h"
+
+const int MAX_SOUND_VOLUME = 100;
+const int MIN_SOUND_VOLUME = 0;
+const int MIN_TOGGLE_COOLDOWN = 0;
+const int MAX_TOGGLE_COOLDOWN = 60000;
+const int MIN_RATE_BURST = 1;
+const int MAX_RATE_BURST = 20;
+const int MIN_VAD_THRESHOLD = 3;
+const int MAX_VAD_THRESHOLD = 40;
+const int MAX_VAD_TIME = 600000;
+
+// Subsystems that have to be re-applied after a setting changes
+enum ConfigChange : unsigned {
+    CONFIG_HOTKEY = 1 << 0,
+    CONFIG_DEVICE = 1 << 1,
+    CONFIG_SOUNDS = 1 << 2,
+    CONFIG_OTHER = 1 << 3, // takes effect through the swap alone
+    CONFIG_CAPTURE = 1 << 4, // anything that listens to the microphone
+    CONFIG_CONTROL = 1 << 5,
+    CONFIG_RATE_LIMIT = 1 << 6
+};
+
+// Configuration structure, schema members get their defaults from CONFIG_SCHEMA
+struct Config {
+    unsigned hotkey_mod;
+    unsigned hotkey_vk;
+    bool use_keyboard_hook; // set to false to use RegisterHotKey method
+    bool play_sounds;
+    bool unmute_on_exit;
+    bool use_default_device;
+    int sound_volume; // 0-100
+    int toggle_cooldown; // hotkey toggles: ms per token of the rate limit
+    int toggle_burst;    // ... and how many can be saved up
+    int tray_cooldown;
+    int tray_burst;
+    int control_cooldown;
+    int control_burst;
+    int voice_cooldown;
+    int voice_burst;
+    std::string device_name;  // Specific device name to use
+    std::string device_group; // ';'-separated device names muted together, overrides the two above
+    std::string mute_sound_file;
+    std::string unmute_sound_file;
+    std::string audio_backend; // wasapi or mock
+    std::string control_pipe;  // named pipe for scripts, empty = off
+    HotkeyChord mute_hotkey;    // extra bindings, empty = unbound
+    HotkeyChord unmute_hotkey;
+    HotkeyChord cycle_device_hotkey;
+    HotkeyChord push_to_talk_hotkey;
+    HotkeyChord push_to_mute_hotkey;
+    bool voice_activity; // mute on silence, unmute on speech
+    int vad_threshold_db;
+    int vad_attack_ms;
+    int vad_hangover_ms;
+    int vad_release_ms;
+    bool tray_level_meter; // live input level in the tray icon
+
+    // Not read from the file
+    std::string config_file = "mic_config.txt";
+    std::string devices_list_file = "available_devices.txt";
+    std::string device_cache_file = "device_cache.bin";
+    std::string mute_journal_file = "mute_journal.bin";
+    std::string mute_event_log_file = "mute_events.bin"; // read with miclog
+    std::string latency_stats_file = "latency_stats.csv";
+    std::string log_file = "microphone_toggler.log"; // --headless or --log
+
+    Config();
+};
+
+enum class SettingType : unsigned char {
+    Bool,
+    UInt,
+    Int,
+    Text,
+    Chord // "Ctrl+Shift+F2" style hotkey
+};
+
+struct ConfigSetting {
+    const char* section; // a "=== SECTION ===" banner is written when it changes
+    const char* key;
+    SettingType type;
+    unsigned affects;    // ConfigChange flags
+    bool Config::* bool_member;
+    unsigned Config::* uint_member;
+    int Config::* int_member;
+    std::string Config::* text_member;
+    HotkeyChord Config::* chord_member;
+    long long minimum;   // Int values outside are clamped
+    long long maximum;
+    long long default_number;
+    const char* default_text;
+    const char* comment; // one '#' line per '\n'-separated line
+    uint32_t hash;
+};
+
+constexpr ConfigSetting bool_setting(const char* section, const char* key, bool Config::* member,
+    bool default_value, unsigned affects, const char* comment) {
+    return { section, key, SettingType::Bool, affects, member, nullptr, nullptr, nullptr, nullptr,
+        0, 1, default_value ? 1 : 0, nullptr, comment, config_key_hash(key) };
+}
+
+constexpr ConfigSetting uint_setting(const char* section, const char* key, unsigned Config::* member,
+    unsigned default_value, unsigned affects, const char* comment) {
+    return { section, key, SettingType::UInt, affects, nullptr, member, nullptr, nullptr, nullptr,
+        0, 0xFFFFFFFFll, default_value, nullptr, comment, config_key_hash(key) };
+}
+
+constexpr ConfigSetting int_setting(const char* section, const char* key, int Config::* member,
+    int default_value, int minimum, int maximum, unsigned affects, const char* comment) {
+    return { section, key, SettingType::Int, affects, nullptr, nullptr, member, nullptr, nullptr,
+        minimum, maximum, default_value, nullptr, comment, config_key_hash(key) };
+}
+
+constexpr ConfigSetting text_setting(const char* section, const char* key, std::string Config::* member,
+    const char* default_value, unsigned affects, const char* comment) {
+    return { section, key, SettingType::Text, affects, nullptr, nullptr, nullptr, member, nullptr,
+        0, 0, 0, default_value, comment, config_key_hash(key) };
+}
+
+constexpr ConfigSetting chord_setting(const char* section, const char* key, HotkeyChord Config::* member,
+    const char* default_value, unsigned affects, const char* comment) {
+    return { section, key, SettingType::Chord, affects, nullptr, nullptr, nullptr, nullptr, member,
+        0, 0, 0, default_value, comment, config_key_hash(key) };
+}
+
+// In the order the settings are written to the config file
+inline constexpr ConfigSetting CONFIG_SCHEMA[] = {
+    bool_setting("DEVICE SELECTION", "use_default_device", &Config::use_default_device, true, CONFIG_DEVICE,
+        "Use system default microphone device"),
+    text_setting("DEVICE SELECTION", "device_name", &Config::device_name, "", CONFIG_DEVICE,
+        "Specific device name (only used if use_default_device = false)\n"
+        "Run the program to generate 'available_devices.txt' with available devices\n"
+        "Copy the device name from that file; case, spacing and Windows' \"2- \" renumbering\n"
+        "are forgiven, and an endpoint id in braces is accepted too"),
+    text_setting("DEVICE SELECTION", "device_group", &Config::device_group, "", CONFIG_DEVICE,
+        "Mute several devices together with one hotkey (overrides the two settings above)\n"
+        "Separate device names with ';', use 'default' for the system default device\n"
+        "Example: device_group = default; Microphone (USB Audio Interface); VoiceMeeter Output"),
+
+    uint_setting("HOTKEY CONFIGURATION", "hotkey_mod", &Config::hotkey_mod, HOTKEY_MOD_CONTROL | HOTKEY_MOD_SHIFT, CONFIG_HOTKEY,
+        "Hotkey modifier keys (can be combined by adding values):\n"
+        "  Alt = 1, Control = 2, Shift = 4, Windows Key = 8\n"
+        "  Examples: Control+Shift = 6, Alt+Control = 3, Shift only = 4"),
+    uint_setting("HOTKEY CONFIGURATION", "hotkey_vk", &Config::hotkey_vk, 0x70 /* VK_F1 */, CONFIG_HOTKEY,
+        "Main key for hotkey (virtual key codes):\n"
+        "  Function keys: F1=112, F2=113, F3=114, ..., F12=123\n"
+        "  Letters: A=65, B=66, C=67, ..., Z=90\n"
+        "  Numbers: 0=48, 1=49, 2=50, ..., 9=57\n"
+        "  Other: Space=32, Enter=13, Tab=9"),
+    int_setting("HOTKEY CONFIGURATION", "toggle_cooldown", &Config::toggle_cooldown, 300,
+        MIN_TOGGLE_COOLDOWN, MAX_TOGGLE_COOLDOWN, CONFIG_RATE_LIMIT,
+        "Cooldown for toggling the microphone with a hotkey (0-60000 ms, 0=none)\n"
+        "Presses faster than this are ignored once toggle_burst quick ones are used up"),
+    int_setting("HOTKEY CONFIGURATION", "toggle_burst", &Config::toggle_burst, 2,
+        MIN_RATE_BURST, MAX_RATE_BURST, CONFIG_RATE_LIMIT,
+        "Quick toggles allowed in a row before the cooldown applies (1-20, 2 = double-tap)"),
+    chord_setting("HOTKEY CONFIGURATION", "mute_hotkey", &Config::mute_hotkey, "", CONFIG_HOTKEY,
+        "Extra hotkeys, written as modifiers and a key joined with '+', empty = not used\n"
+        "  Modifiers: Ctrl, Alt, Shift, Win\n"
+        "  Keys: A-Z, 0-9, F1-F24, Space, Enter, Tab, Pause, Insert, Delete, Home, End,\n"
+        "        PageUp, PageDown, Up, Down, Left, Right, or a virtual key code\n"
+        "  Example: mute_hotkey = Ctrl+Shift+F2\n"
+        "Mute only (does nothing if already muted)"),
+    chord_setting("HOTKEY CONFIGURATION", "unmute_hotkey", &Config::unmute_hotkey, "", CONFIG_HOTKEY,
+        "Unmute only"),
+    chord_setting("HOTKEY CONFIGURATION", "cycle_device_hotkey", &Config::cycle_device_hotkey, "", CONFIG_HOTKEY,
+        "Switch to the next available microphone (until the config is reloaded)"),
+    chord_setting("HOTKEY CONFIGURATION", "push_to_talk_hotkey", &Config::push_to_talk_hotkey, "", CONFIG_HOTKEY,
+        "Unmuted only while held, muted again on release (no cooldown)"),
+    chord_setting("HOTKEY CONFIGURATION", "push_to_mute_hotkey", &Config::push_to_mute_hotkey, "", CONFIG_HOTKEY,
+        "Muted only while held, unmuted again on release (no cooldown)"),
+    bool_setting("HOTKEY CONFIGURATION", "use_keyboard_hook", &Config::use_keyboard_hook, true, CONFIG_HOTKEY,
+        "Use low-level keyboard hook for more reliable hotkey detection\n"
+        "(May work better in some apps like Visual Studio)"),
+
+    bool_setting("SOUND SETTINGS", "play_sounds", &Config::play_sounds, true, CONFIG_SOUNDS,
+        "Play notification sounds when muting/unmuting"),
+    int_setting("SOUND SETTINGS", "sound_volume", &Config::sound_volume, 50,
+        MIN_SOUND_VOLUME, MAX_SOUND_VOLUME, CONFIG_SOUNDS,
+        "Volume for notification sounds (0-100, 0=silent, 100=loudest)"),
+    text_setting("SOUND SETTINGS", "mute_sound_file", &Config::mute_sound_file, "mute.wav", CONFIG_SOUNDS,
+        "Sound files (must be WAV format, leave empty to disable specific sounds)\n"
+        "Files should be in the same folder as this program, or you can specify the exact path"),
+    text_setting("SOUND SETTINGS", "unmute_sound_file", &Config::unmute_sound_file, "unmute.wav", CONFIG_SOUNDS,
+        ""),
+
+    bool_setting("VOICE ACTIVITY", "voice_activity", &Config::voice_activity, false, CONFIG_CAPTURE,
+        "Mute automatically after a stretch of silence and unmute when speech starts\n"
+        "Listens to the first selected device. Some drivers deliver only silence while\n"
+        "muted, then use a hotkey to unmute"),
+    int_setting("VOICE ACTIVITY", "vad_threshold_db", &Config::vad_threshold_db, 12,
+        MIN_VAD_THRESHOLD, MAX_VAD_THRESHOLD, CONFIG_CAPTURE,
+        "How far above the background noise speech has to be, in dB (3-40, lower = more sensitive)"),
+    int_setting("VOICE ACTIVITY", "vad_attack_ms", &Config::vad_attack_ms, 30, 0, MAX_VAD_TIME, CONFIG_CAPTURE,
+        "Speech needed before unmuting, in milliseconds"),
+    int_setting("VOICE ACTIVITY", "vad_hangover_ms", &Config::vad_hangover_ms, 300, 0, MAX_VAD_TIME, CONFIG_CAPTURE,
+        "Pauses shorter than this still count as speech, in milliseconds"),
+    int_setting("VOICE ACTIVITY", "vad_release_ms", &Config::vad_release_ms, 3000, 0, MAX_VAD_TIME, CONFIG_CAPTURE,
+        "Silence after the pause above before muting, in milliseconds"),
+
+    bool_setting("TRAY ICON", "tray_level_meter", &Config::tray_level_meter, false, CONFIG_CAPTURE,
+        "Show the live input level of the first selected device in the tray icon"),
+
+    int_setting("RATE LIMITS", "tray_cooldown", &Config::tray_cooldown, 300,
+        MIN_TOGGLE_COOLDOWN, MAX_TOGGLE_COOLDOWN, CONFIG_RATE_LIMIT,
+        "Same as toggle_cooldown and toggle_burst, for clicks on the tray icon"),
+    int_setting("RATE LIMITS", "tray_burst", &Config::tray_burst, 2,
+        MIN_RATE_BURST, MAX_RATE_BURST, CONFIG_RATE_LIMIT, ""),
+    int_setting("RATE LIMITS", "control_cooldown", &Config::control_cooldown, 100,
+        MIN_TOGGLE_COOLDOWN, MAX_TOGGLE_COOLDOWN, CONFIG_RATE_LIMIT,
+        "For toggle commands on the control pipe (mute and unmute are never limited)"),
+    int_setting("RATE LIMITS", "control_burst", &Config::control_burst, 5,
+        MIN_RATE_BURST, MAX_RATE_BURST, CONFIG_RATE_LIMIT, ""),
+    int_setting("RATE LIMITS", "voice_cooldown", &Config::voice_cooldown, 500,
+        MIN_TOGGLE_COOLDOWN, MAX_TOGGLE_COOLDOWN, CONFIG_RATE_LIMIT,
+        "For voice activity. Its changes are delayed instead of ignored, only the newest is kept"),
+    int_setting("RATE LIMITS", "voice_burst", &Config::voice_burst, 2,
+        MIN_RATE_BURST, MAX_RATE_BURST, CONFIG_RATE_LIMIT, ""),
+
+    bool_setting("BEHAVIOR SETTINGS", "unmute_on_exit", &Config::unmute_on_exit, true, CONFIG_OTHER,
+        "Automatically unmute microphone when program exits\n"
+        "Set to false if you want to keep the mute state when closing"),
+    text_setting("BEHAVIOR SETTINGS", "audio_backend", &Config::audio_backend, "wasapi", CONFIG_DEVICE,
+        "Audio backend: wasapi = Windows audio devices, mock = in-memory fake devices for testing"),
+    text_setting("BEHAVIOR SETTINGS", "control_pipe", &Config::control_pipe, "microphone_toggler", CONFIG_CONTROL,
+        "Named pipe (\\\\.\\pipe\\<name>) that scripts and Stream Deck plugins can send\n"
+        "toggle, mute, unmute, get, subscribe and devices commands to, empty = off"),
+};
+
+constexpr bool config_schema_keys_unique() {
+    for (const ConfigSetting& a : CONFIG_SCHEMA) {
+        int same = 0;
+        for (const ConfigSetting& b : CONFIG_SCHEMA) {
+            if (a.hash == b.hash) same++;
+        }
+        if (same != 1) return false;
+    }
+    return true;
+}
+static_assert(config_schema_keys_unique(), "config keys must be unique (and not collide by hash)");
+
+inline Config::Config() {
+    for (const ConfigSetting& s : CONFIG_SCHEMA) {
+        switch (s.type) {
+        case SettingType::Bool: this->*s.bool_member = s.default_number != 0; break;
+        case SettingType::UInt: this->*s.uint_member = (unsigned)s.default_number; break;
+        case SettingType::Int: this->*s.int_member = (int)s.default_number; break;
+        case SettingType::Text: this->*s.text_member = s.default_text; break;
+        case SettingType::Chord: parse_hotkey_chord(s.default_text, this->*s.chord_member); break;
+        }
+    }
+}
+
+constexpr size_t CONFIG_SCHEMA_SIZE = sizeof(CONFIG_SCHEMA) / sizeof(CONFIG_SCHEMA[0]);
+static_assert(CONFIG_SCHEMA_SIZE <= 256, "CONFIG_SCHEMA_BY_HASH stores indices as bytes");
+
+// CONFIG_SCHEMA indices ordered by key hash, sorted at compile time
+constexpr std::array<uint8_t, CONFIG_SCHEMA_SIZE> config_schema_by_hash() {
+    std::array<uint8_t, CONFIG_SCHEMA_SIZE> order = {};
+    for (size_t i = 0; i < CONFIG_SCHEMA_SIZE; i++) {
+        size_t j = i;
+        for (; j > 0 && CONFIG_SCHEMA[order[j - 1]].hash > CONFIG_SCHEMA[i].hash; j--) order[j] = order[j - 1];
+        order[j] = (uint8_t)i;
+    }
+    return order;
+}
+inline constexpr std::array<uint8_t, CONFIG_SCHEMA_SIZE> CONFIG_SCHEMA_BY_HASH = config_schema_by_hash();
+
+// A binary search over the key hashes, then one string compare
+inline const ConfigSetting* find_config_setting(std::string_view key) {
+    uint32_t hash = config_key_hash(key);
+    auto found = std::lower_bound(CONFIG_SCHEMA_BY_HASH.begin(), CONFIG_SCHEMA_BY_HASH.end(), hash,
+        [](uint8_t index, uint32_t value) { return CONFIG_SCHEMA[index].hash < value; });
+    if (found == CONFIG_SCHEMA_BY_HASH.end()) return nullptr;
+    const ConfigSetting& s = CONFIG_SCHEMA[*found];
+    return s.hash == hash && key == s.key ? &s : nullptr;
+}
+
+// Stores one parsed entry, an invalid value is reported and leaves the setting as it was
+inline void apply_config_entry(const ConfigEntry& entry, Config& config,
+    std::vector<ConfigDiagnostic>& diagnostics) {
+    auto report = [&](size_t column, const std::string& problem) {
+        diagnostics.push_back({ entry.line, column, problem });
+    };
+
+    const ConfigSetting* setting = find_config_setting(entry.key);
+    if (!setting) {
+        report(entry.key_column, "unknown setting '" + std::string(entry.key) + "'");
+        return;
+    }
+    const std::string where = "'" + std::string(entry.key) + "': ";
+
+    switch (setting->type) {
+    case SettingType::Bool:
+        if (!parse_config_bool(entry.value, config.*setting->bool_member)) {
+            report(entry.value_column, where + "expected true or false");
+        }
+        break;
+
+    case SettingType::UInt: {
+        unsigned long value;
+        if (!parse_config_uint(entry.value, value) || (long long)value > setting->maximum) {
+            report(entry.value_column, where + "expected a number");
+        }
+        else {
+            config.*setting->uint_member = (unsigned)value;
+        }
+        break;
+    }
+
+    case SettingType::Int: {
+        long value;
+        if (!parse_config_int(entry.value, value)) {
+            report(entry.value_column, where + "expected a number");
+            break;
+        }
+        if (value < setting->minimum || value > setting->maximum) {
+            value = (long)(value < setting->minimum ? setting->minimum : setting->maximum);
+            report(entry.value_column, where + "out of range " + std::to_string(setting->minimum) + "-" +
+                std::to_string(setting->maximum) + ", using " + std::to_string(value));
+        }
+        config.*setting->int_member = (int)value;
+        break;
+    }
+
+    case SettingType::Text:
+        (config.*setting->text_member).assign(entry.value);
+        break;
+
+    case SettingType::Chord:
+        if (!parse_hotkey_chord(entry.value, config.*setting->chord_member)) {
+            report(entry.value_column, where + "expected a hotkey like Ctrl+Shift+F2");
+        }
+        break;
+    }
+}
+
+// ConfigChange flags for every setting that differs
+inline unsigned diff_config(const Config& a, const Config& b) {
+    unsigned changed = 0;
+    for (const ConfigSetting& s : CONFIG_SCHEMA) {
+        bool same = true;
+        switch (s.type) {
+        case SettingType::Bool: same = a.*s.bool_member == b.*s.bool_member; break;
+        case SettingType::UInt: same = a.*s.uint_member == b.*s.uint_member; break;
+        case SettingType::Int: same = a.*s.int_member == b.*s.int_member; break;
+        case SettingType::Text: same = a.*s.text_member == b.*s.text_member; break;
+        case SettingType::Chord: same = a.*s.chord_member == b.*s.chord_member; break;
+        }
+        if (!same) changed |= s.affects;
+    }
+    return changed;
+}
+
+// Every setting with its section banner and comment, in schema order
+inline void write_config_settings(std::ostream& out, const Config& config) {
+    const char* section = nullptr;
+    for (const ConfigSetting& s : CONFIG_SCHEMA) {
+        if (!section || std::string_view(section) != s.section) {
+            section = s.section;
+            out << "=== " << section << " ===\n\n";
+        }
+
+        std::string_view comment = s.comment;
+        while (!comment.empty()) {
+            size_t end = comment.find('\n');
+            out << "# " << comment.substr(0, end) << "\n";
+            if (end == std::string_view::npos) break;
+            comment.remove_prefix(end + 1);
+        }
+
+        out << s.key << " = ";
+        switch (s.type) {
+        case SettingType::Bool: out << (config.*s.bool_member ? "true" : "false"); break;
+        case SettingType::UInt: out << config.*s.uint_member; break;
+        case SettingType::Int: out << config.*s.int_member; break;
+        case SettingType::Text: out << config.*s.text_member; break;
+        case SettingType::Chord: out << format_hotkey_chord(config.*s.chord_member); break;
+        }
+        out << "\n\n";
+    }
+}
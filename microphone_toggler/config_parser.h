@@ -0,0 +1,127 @@
+#pragma once
+
+// Single-pass tokenizer for the 'key = value' config format.
+// The file is read with one call and split in place into string_views,
+// nothing is copied until a value is stored. Entries carry their line and
+// column so a bad value can be reported and skipped on its own.
+// Portable, no platform headers.
+
+#include <charconv>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct ConfigDiagnostic {
+    size_t line;   // 1-based
+    size_t column; // 1-based, in bytes
+    std::string message;
+};
+
+struct ConfigEntry {
+    std::string_view key;
+    std::string_view value;
+    size_t line;
+    size_t key_column;
+    size_t value_column;
+};
+
+inline bool read_text_file(const std::string& path, std::string& text) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) return false;
+
+    std::streamoff size = file.tellg();
+    if (size < 0) return false;
+    text.resize((size_t)size);
+    file.seekg(0);
+    return size == 0 || (bool)file.read(&text[0], size);
+}
+
+inline bool is_config_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Calls handler(const ConfigEntry&) for every 'key = value' line.
+// Blank lines, '#' comments, '=' banners and free text without '=' are skipped.
+template <typename Handler>
+void parse_config_entries(std::string_view text, Handler&& handler) {
+    if (text.substr(0, 3) == "\xEF\xBB\xBF") text.remove_prefix(3); // UTF-8 BOM
+
+    size_t line_number = 0;
+    size_t line_start = 0;
+    while (line_start < text.size()) {
+        size_t line_end = text.find('\n', line_start);
+        if (line_end == std::string_view::npos) line_end = text.size();
+        std::string_view line = text.substr(line_start, line_end - line_start);
+        line_number++;
+
+        size_t first = 0;
+        while (first < line.size() && is_config_space(line[first])) first++;
+        size_t last = line.size();
+        while (last > first && is_config_space(line[last - 1])) last--;
+
+        if (first < last && line[first] != '#' && line[first] != '=') {
+            size_t equals = line.find('=', first);
+            if (equals != std::string_view::npos && equals < last) {
+                size_t key_end = equals;
+                while (key_end > first && is_config_space(line[key_end - 1])) key_end--;
+                size_t value_start = equals + 1;
+                while (value_start < last && is_config_space(line[value_start])) value_start++;
+
+                ConfigEntry entry;
+                entry.key = line.substr(first, key_end - first);
+                entry.value = line.substr(value_start, last - value_start);
+                entry.line = line_number;
+                entry.key_column = first + 1;
+                entry.value_column = value_start + 1;
+                handler(entry);
+            }
+        }
+
+        line_start = line_end + 1;
+    }
+}
+
+// true/false, yes/no, on/off, 1/0 in any case
+inline bool parse_config_bool(std::string_view value, bool& out) {
+    char lower[8];
+    if (value.empty() || value.size() >= sizeof(lower)) return false;
+    for (size_t i = 0; i < value.size(); i++) {
+        char c = value[i];
+        lower[i] = (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+    }
+    std::string_view v(lower, value.size());
+
+    if (v == "1" || v == "true" || v == "yes" || v == "on") { out = true; return true; }
+    if (v == "0" || v == "false" || v == "no" || v == "off") { out = false; return true; }
+    return false;
+}
+
+// Decimal or 0x-prefixed hex, the whole value must be a number
+inline bool parse_config_uint(std::string_view value, unsigned long& out) {
+    int base = 10;
+    if (value.size() > 2 && value[0] == '0' && (value[1] == 'x' || value[1] == 'X')) {
+        value.remove_prefix(2);
+        base = 16;
+    }
+    const char* end = value.data() + value.size();
+    auto result = std::from_chars(value.data(), end, out, base);
+    return !value.empty() && result.ec == std::errc() && result.ptr == end;
+}
+
+inline bool parse_config_int(std::string_view value, long& out) {
+    const char* end = value.data() + value.size();
+    auto result = std::from_chars(value.data(), end, out);
+    return !value.empty() && result.ec == std::errc() && result.ptr == end;
+}
+
+// FNV-1a, constexpr so the schema is hashed and sorted at compile time
+constexpr uint32_t config_key_hash(std::string_view key) {
+    uint32_t hash = 2166136261u;
+    for (char c : key) {
+        hash ^= (unsigned char)c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
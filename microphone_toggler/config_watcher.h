@@ -0,0 +1,141 @@
+#pragma once
+
+// Watches one file for changes with ReadDirectoryChangesW on its folder.
+// Editors often write a file several times in a row, so the handler runs
+// once on the watcher thread after the writes have been quiet for a moment.
+
+#include <windows.h>
+#include <functional>
+#include <string>
+#include <thread>
+
+#include "win_utils.h"
+
+class ConfigWatcher {
+public:
+    using ChangeHandler = std::function<void()>;
+
+    static const DWORD SETTLE_MS = 150;
+
+private:
+    HANDLE directory = INVALID_HANDLE_VALUE;
+    HANDLE stop_event = nullptr;
+    HANDLE read_event = nullptr;
+    std::wstring file_name;
+    ChangeHandler handler;
+    std::thread thread;
+
+    // DWORD-aligned as ReadDirectoryChangesW requires
+    DWORD buffer[2048];
+
+    bool arm(OVERLAPPED& overlapped) {
+        memset(&overlapped, 0, sizeof(OVERLAPPED));
+        overlapped.hEvent = read_event;
+        return ReadDirectoryChangesW(directory, buffer, sizeof(buffer), FALSE,
+            FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE,
+            nullptr, &overlapped, nullptr) != FALSE;
+    }
+
+    // True if any record in the buffer names the watched file
+    bool touches_file(DWORD bytes) const {
+        if (bytes == 0) return true; // buffer overflowed, assume the worst
+
+        const BYTE* cursor = (const BYTE*)buffer;
+        for (;;) {
+            const FILE_NOTIFY_INFORMATION* info = (const FILE_NOTIFY_INFORMATION*)cursor;
+            std::wstring name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+            if (_wcsicmp(name.c_str(), file_name.c_str()) == 0) return true;
+
+            if (info->NextEntryOffset == 0) return false;
+            cursor += info->NextEntryOffset;
+        }
+    }
+
+    void watch_loop() {
+        OVERLAPPED overlapped;
+        bool armed = arm(overlapped);
+        bool pending = false;
+        HANDLE handles[2] = { stop_event, read_event };
+
+        while (armed || pending) {
+            DWORD wait = WaitForMultipleObjects(armed ? 2 : 1, handles, FALSE, pending ? SETTLE_MS : INFINITE);
+            if (wait == WAIT_OBJECT_0) break;
+
+            if (wait == WAIT_TIMEOUT) {
+                pending = false;
+                handler();
+                continue;
+            }
+
+            DWORD bytes = 0;
+            if (!GetOverlappedResult(directory, &overlapped, &bytes, FALSE)) {
+                armed = false; // folder went away, stop watching
+                continue;
+            }
+            if (touches_file(bytes)) pending = true;
+            armed = arm(overlapped);
+        }
+
+        if (armed) {
+            CancelIoEx(directory, &overlapped);
+            DWORD bytes;
+            GetOverlappedResult(directory, &overlapped, &bytes, TRUE);
+        }
+    }
+
+public:
+    ConfigWatcher() = default;
+    ~ConfigWatcher() { stop(); }
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    bool start(const std::string& path, ChangeHandler on_change) {
+        stop();
+
+        std::wstring wide_path = string_to_wstring(path);
+        WCHAR full_path[MAX_PATH];
+        WCHAR* name_part = nullptr;
+        DWORD length = GetFullPathNameW(wide_path.c_str(), MAX_PATH, full_path, &name_part);
+        if (length == 0 || length >= MAX_PATH || !name_part) return false;
+
+        file_name = name_part;
+        std::wstring folder(full_path, name_part - full_path);
+
+        directory = CreateFileW(folder.c_str(), FILE_LIST_DIRECTORY,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+            FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+        if (directory == INVALID_HANDLE_VALUE) return false;
+
+        stop_event = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+        read_event = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+        if (!stop_event || !read_event) {
+            stop();
+            return false;
+        }
+
+        handler = std::move(on_change);
+        thread = std::thread([this] { watch_loop(); });
+        return true;
+    }
+
+    void stop() {
+        if (thread.joinable()) {
+            SetEvent(stop_event);
+            thread.join();
+        }
+        if (directory != INVALID_HANDLE_VALUE) {
+            CloseHandle(directory);
+            directory = INVALID_HANDLE_VALUE;
+        }
+        if (stop_event) {
+            CloseHandle(stop_event);
+            stop_event = nullptr;
+        }
+        if (read_event) {
+            CloseHandle(read_event);
+            read_event = nullptr;
+        }
+        handler = nullptr;
+    }
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+// What the control endpoint queues for its clients, apart from the pipe
+// I/O in control_server.h: replies and events wait behind the write in
+// flight, a state change reaches every subscriber once, repeats of the
+// state last sent are dropped, and a subscriber that stops reading is
+// dropped once MAX_PENDING_OUTPUT bytes are waiting for it instead of
+// being buffered without end. Single-threaded, the server thread owns it.
+// Portable, no platform headers.
+
+#include <cstddef>
+#include <string>
+
+#include "control_protocol.h"
+
+// Output side of one client
+struct ControlClientOutput {
+    std::string output;  // queued behind the write in flight
+    std::string writing; // the write in flight
+    bool subscribed = false;
+
+    size_t unread() const { return output.size() + writing.size(); }
+
+    // Moves the queue into writing, false while a write is in flight or
+    // nothing is queued
+    bool begin_write() {
+        if (!writing.empty() || output.empty()) return false;
+        writing.swap(output);
+        return true;
+    }
+
+    void end_write() { writing.clear(); }
+};
+
+class ControlFanout {
+public:
+    static const size_t MAX_PENDING_OUTPUT = 64 * 1024;
+
+private:
+    int sent_state = -1; // -1 = nothing sent yet
+    std::string event;
+
+public:
+    // A new listener hears the next state whatever it is
+    void reset() { sent_state = -1; }
+
+    // The event line for a state, nullptr when it repeats the last one
+    const std::string* event_for(bool muted) {
+        int state = muted ? 1 : 0;
+        if (state == sent_state) return nullptr;
+        sent_state = state;
+        event.clear();
+        append_control_state(event, "event", muted);
+        return &event;
+    }
+
+    // Queues an event for one subscriber. False when it is over the limit,
+    // the caller drops it.
+    static bool queue(ControlClientOutput& client, const std::string& line) {
+        if (client.unread() > MAX_PENDING_OUTPUT) return false;
+        client.output += line;
+        return true;
+    }
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+// Line protocol of the local control endpoint. Portable, no platform headers.
+// Every request and reply is one '\n'-terminated line of text, so scripts
+// can drive it with nothing more than a pipe and a line reader:
+//
+//   toggle | mute | unmute          -> ok
+//   set muted|unmuted               -> ok           (also on/off, true/false, 1/0)
+//   get                             -> state muted|unmuted
+//   subscribe                       -> state muted|unmuted, then "event muted|unmuted" on every change
+//   unsubscribe                     -> ok
+//   devices                         -> one "device\t<id>\t<name>\t<flags>" line each, then end
+//
+// Anything else gets "error <reason>". Fields are tab-separated because
+// device names contain spaces; flags is a comma-separated list of
+// default and target.
+
+#include <string>
+#include <string_view>
+
+#include "audio_backend.h"
+#include "config_parser.h"
+
+const size_t MAX_CONTROL_LINE = 256; // longer requests are rejected
+
+enum class ControlVerb : unsigned char {
+    Unknown,
+    Toggle,
+    Mute,
+    Unmute,
+    Get,
+    Subscribe,
+    Unsubscribe,
+    Devices
+};
+
+struct ControlCommand {
+    ControlVerb verb = ControlVerb::Unknown;
+    const char* error = nullptr; // set when verb is Unknown
+};
+
+inline std::string_view trim_control_text(std::string_view text) {
+    while (!text.empty() && is_config_space(text.front())) text.remove_prefix(1);
+    while (!text.empty() && is_config_space(text.back())) text.remove_suffix(1);
+    return text;
+}
+
+// One request line without its '\n'
+inline ControlCommand parse_control_line(std::string_view line) {
+    ControlCommand command;
+    line = trim_control_text(line);
+
+    size_t space = line.find(' ');
+    std::string_view verb = line.substr(0, space);
+    std::string_view argument = space == std::string_view::npos ? std::string_view() : trim_control_text(line.substr(space + 1));
+
+    bool takes_argument = (verb == "set");
+    if (!takes_argument && !argument.empty()) {
+        command.error = "unexpected argument";
+        return command;
+    }
+
+    if (verb == "toggle") command.verb = ControlVerb::Toggle;
+    else if (verb == "mute") command.verb = ControlVerb::Mute;
+    else if (verb == "unmute") command.verb = ControlVerb::Unmute;
+    else if (verb == "get") command.verb = ControlVerb::Get;
+    else if (verb == "subscribe") command.verb = ControlVerb::Subscribe;
+    else if (verb == "unsubscribe") command.verb = ControlVerb::Unsubscribe;
+    else if (verb == "devices") command.verb = ControlVerb::Devices;
+    else if (verb == "set") {
+        bool muted;
+        if (argument == "muted") muted = true;
+        else if (argument == "unmuted") muted = false;
+        else if (!parse_config_bool(argument, muted)) {
+            command.error = "expected set muted|unmuted";
+            return command;
+        }
+        command.verb = muted ? ControlVerb::Mute : ControlVerb::Unmute;
+    }
+    else {
+        command.error = verb.empty() ? "empty request" : "unknown command";
+    }
+    return command;
+}
+
+inline void append_control_state(std::string& out, const char* kind, bool muted) {
+    out += kind;
+    out += muted ? " muted\n" : " unmuted\n";
+}
+
+inline void append_control_error(std::string& out, const char* reason) {
+    out += "error ";
+    out += reason;
+    out += '\n';
+}
+
+// Tabs and line breaks inside a field would split it
+inline void append_control_field(std::string& out, const std::string& field) {
+    for (char c : field) out += (c == '\t' || c == '\n' || c == '\r') ? ' ' : c;
+}
+
+inline void append_control_device(std::string& out, const AudioDevice& device, bool target) {
+    out += "device\t";
+    append_control_field(out, device.id);
+    out += '\t';
+    append_control_field(out, device.name);
+    out += '\t';
+    if (device.is_default) out += "default";
+    if (device.is_default && target) out += ',';
+    if (target) out += "target";
+    out += '\n';
+}
@@ -0,0 +1,347 @@
+#pragma once
+
+// Local control endpoint on a named pipe, the protocol is in control_protocol.h
+// and what is queued for each client in control_fanout.h.
+// One thread serves every client through an I/O completion port: connects,
+// reads and writes are all overlapped, so an idle or slow client never holds
+// up the others, and a subscriber costs nothing until there is an event.
+
+#include <windows.h>
+#include <atomic>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "control_fanout.h"
+#include "control_protocol.h"
+#include "win_utils.h"
+
+class ControlServer {
+public:
+    // Runs on the server thread for toggle, mute, unmute and get.
+    // Appends the reply line, must not block.
+    using CommandHandler = std::function<void(ControlVerb verb, std::string& reply)>;
+
+    static const DWORD PIPE_BUFFER = 4096;
+
+private:
+    enum class IoKind : unsigned char {
+        Connect,
+        Read,
+        Write
+    };
+
+    struct Client;
+
+    struct IoOperation {
+        OVERLAPPED overlapped; // first, the port hands this pointer back
+        Client* client;
+        IoKind kind;
+    };
+
+    struct Client : ControlClientOutput {
+        HANDLE pipe = INVALID_HANDLE_VALUE;
+        IoOperation read_op;   // also used for the connect
+        IoOperation write_op;
+        char read_buffer[512];
+        std::string input;     // partial request line
+        int pending = 0;       // operations the port still owes us
+        bool closing = false;
+    };
+
+    static const ULONG_PTR KEY_PIPE = 1;
+    static const ULONG_PTR KEY_WAKE = 2;
+
+    std::wstring pipe_name;
+    HANDLE port = nullptr;
+    std::thread thread;
+    std::atomic<bool> stopping{ false };
+    CommandHandler handler;
+
+    // Server thread only
+    std::list<std::unique_ptr<Client>> clients;
+    bool first_instance = true;
+    ControlFanout fanout;
+
+    // Handed over from other threads, picked up on the next wake
+    std::mutex shared_mutex;
+    std::string device_lines;
+    int published_state = -1; // -1 = nothing new
+
+    static void reset_operation(IoOperation& op, Client* client, IoKind kind) {
+        memset(&op.overlapped, 0, sizeof(OVERLAPPED));
+        op.client = client;
+        op.kind = kind;
+    }
+
+    // Always leaves one instance waiting for the next client
+    bool listen() {
+        auto client = std::make_unique<Client>();
+        DWORD open_mode = PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | (first_instance ? FILE_FLAG_FIRST_PIPE_INSTANCE : 0);
+        client->pipe = CreateNamedPipeW(pipe_name.c_str(), open_mode,
+            PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+            PIPE_UNLIMITED_INSTANCES, PIPE_BUFFER, PIPE_BUFFER, 0, nullptr);
+        if (client->pipe == INVALID_HANDLE_VALUE) return false;
+        first_instance = false;
+
+        if (!CreateIoCompletionPort(client->pipe, port, KEY_PIPE, 0)) {
+            CloseHandle(client->pipe);
+            return false;
+        }
+
+        Client* c = client.get();
+        clients.push_back(std::move(client));
+        reset_operation(c->read_op, c, IoKind::Connect);
+
+        if (!ConnectNamedPipe(c->pipe, &c->read_op.overlapped)) {
+            DWORD error = GetLastError();
+            if (error == ERROR_PIPE_CONNECTED) {
+                // Connected before we asked, the port gets no packet for it
+                PostQueuedCompletionStatus(port, 0, KEY_PIPE, &c->read_op.overlapped);
+            }
+            else if (error != ERROR_IO_PENDING) {
+                close(c);
+                return false;
+            }
+        }
+        c->pending++;
+        return true;
+    }
+
+    void start_read(Client* c) {
+        reset_operation(c->read_op, c, IoKind::Read);
+        if (!ReadFile(c->pipe, c->read_buffer, sizeof(c->read_buffer), nullptr, &c->read_op.overlapped) &&
+            GetLastError() != ERROR_IO_PENDING) {
+            close(c);
+            return;
+        }
+        c->pending++;
+    }
+
+    void flush(Client* c) {
+        if (c->closing || !c->begin_write()) return;
+
+        reset_operation(c->write_op, c, IoKind::Write);
+        if (!WriteFile(c->pipe, c->writing.data(), (DWORD)c->writing.size(), nullptr, &c->write_op.overlapped) &&
+            GetLastError() != ERROR_IO_PENDING) {
+            close(c);
+            return;
+        }
+        c->pending++;
+    }
+
+    // Cancels whatever is in flight, the client is freed once the port returns it all
+    void close(Client* c) {
+        if (c->closing) return;
+        c->closing = true;
+        CloseHandle(c->pipe);
+        c->pipe = INVALID_HANDLE_VALUE;
+    }
+
+    void run_command(Client* c, std::string_view line) {
+        ControlCommand command = parse_control_line(line);
+        switch (command.verb) {
+        case ControlVerb::Unknown:
+            append_control_error(c->output, command.error);
+            break;
+        case ControlVerb::Subscribe:
+            c->subscribed = true;
+            handler(ControlVerb::Get, c->output);
+            break;
+        case ControlVerb::Unsubscribe:
+            c->subscribed = false;
+            c->output += "ok\n";
+            break;
+        case ControlVerb::Devices:
+            {
+                std::lock_guard<std::mutex> lock(shared_mutex);
+                c->output += device_lines;
+            }
+            c->output += "end\n";
+            break;
+        default:
+            handler(command.verb, c->output);
+            break;
+        }
+    }
+
+    void on_input(Client* c, DWORD bytes) {
+        c->input.append(c->read_buffer, bytes);
+
+        size_t start = 0;
+        size_t end;
+        while ((end = c->input.find('\n', start)) != std::string::npos) {
+            run_command(c, std::string_view(c->input).substr(start, end - start));
+            start = end + 1;
+        }
+        c->input.erase(0, start);
+
+        if (c->input.size() > MAX_CONTROL_LINE) {
+            close(c); // not a client of ours
+            return;
+        }
+        flush(c);
+    }
+
+    void on_completion(IoOperation* op, DWORD bytes, bool ok) {
+        Client* c = op->client;
+        c->pending--;
+        if (c->closing) return;
+
+        switch (op->kind) {
+        case IoKind::Connect:
+            if (ok) start_read(c);
+            else close(c);
+            if (!stopping) listen();
+            break;
+        case IoKind::Read:
+            if (!ok || bytes == 0) {
+                close(c); // client went away
+                break;
+            }
+            on_input(c, bytes);
+            if (!c->closing) start_read(c);
+            break;
+        case IoKind::Write:
+            c->end_write();
+            if (ok) flush(c);
+            else close(c);
+            break;
+        }
+    }
+
+    void broadcast() {
+        int state;
+        {
+            std::lock_guard<std::mutex> lock(shared_mutex);
+            state = published_state;
+            published_state = -1;
+        }
+        if (state < 0) return;
+        const std::string* event = fanout.event_for(state != 0);
+        if (!event) return;
+
+        for (auto& client : clients) {
+            Client* c = client.get();
+            if (!c->subscribed || c->closing) continue;
+
+            if (!ControlFanout::queue(*c, *event)) {
+                close(c); // stopped reading
+                continue;
+            }
+            flush(c);
+        }
+    }
+
+    void sweep() {
+        clients.remove_if([](const std::unique_ptr<Client>& c) { return c->closing && c->pending == 0; });
+    }
+
+    void serve() {
+        listen();
+
+        for (;;) {
+            DWORD bytes = 0;
+            ULONG_PTR key = 0;
+            OVERLAPPED* overlapped = nullptr;
+            BOOL ok = GetQueuedCompletionStatus(port, &bytes, &key, &overlapped, INFINITE);
+
+            if (overlapped) {
+                on_completion((IoOperation*)overlapped, bytes, ok != FALSE);
+            }
+            else if (!ok || stopping) {
+                break;
+            }
+            else if (key == KEY_WAKE) {
+                broadcast();
+            }
+            sweep();
+        }
+
+        // The cancelled operations still come back through the port
+        for (auto& client : clients) close(client.get());
+        sweep();
+        while (!clients.empty()) {
+            DWORD bytes = 0;
+            ULONG_PTR key = 0;
+            OVERLAPPED* overlapped = nullptr;
+            GetQueuedCompletionStatus(port, &bytes, &key, &overlapped, 1000);
+            if (!overlapped) break;
+            on_completion((IoOperation*)overlapped, bytes, false);
+            sweep();
+        }
+        clients.clear();
+    }
+
+    void wake() {
+        PostQueuedCompletionStatus(port, 0, KEY_WAKE, nullptr);
+    }
+
+public:
+    ControlServer() = default;
+    ~ControlServer() { stop(); }
+
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    // name is the part after \\.\pipe\. Fails when another process serves it.
+    bool start(const std::string& name, CommandHandler on_command) {
+        stop();
+        if (name.empty() || !on_command) return false;
+
+        pipe_name = L"\\\\.\\pipe\\" + string_to_wstring(name);
+        port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+        if (!port) return false;
+
+        // Probe the name here so a clash is reported to the caller
+        HANDLE probe = CreateNamedPipeW(pipe_name.c_str(), PIPE_ACCESS_DUPLEX | FILE_FLAG_FIRST_PIPE_INSTANCE,
+            PIPE_TYPE_BYTE | PIPE_REJECT_REMOTE_CLIENTS, PIPE_UNLIMITED_INSTANCES, PIPE_BUFFER, PIPE_BUFFER, 0, nullptr);
+        if (probe == INVALID_HANDLE_VALUE) {
+            CloseHandle(port);
+            port = nullptr;
+            return false;
+        }
+        CloseHandle(probe);
+
+        handler = std::move(on_command);
+        stopping = false;
+        first_instance = true;
+        fanout.reset();
+        thread = std::thread([this] { serve(); });
+        return true;
+    }
+
+    void stop() {
+        if (thread.joinable()) {
+            stopping = true;
+            wake();
+            thread.join();
+        }
+        if (port) {
+            CloseHandle(port);
+            port = nullptr;
+        }
+        handler = nullptr;
+    }
+
+    bool running() const { return port != nullptr; }
+
+    // Any thread. Subscribers hear about it once, repeats are dropped.
+    void publish_state(bool muted) {
+        if (!port) return;
+        {
+            std::lock_guard<std::mutex> lock(shared_mutex);
+            published_state = muted ? 1 : 0;
+        }
+        wake();
+    }
+
+    // Any thread, the body of the next "devices" replies
+    void set_devices(std::string lines) {
+        std::lock_guard<std::mutex> lock(shared_mutex);
+        device_lines = std::move(lines);
+    }
+};
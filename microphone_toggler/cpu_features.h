@@ -0,0 +1,48 @@
+#pragma once
+
+// Runtime x86 SIMD feature detection for kernel dispatch
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define MIC_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define MIC_X86 0
+#endif
+
+// Functions using AVX2 intrinsics need an explicit target on GCC/Clang,
+// MSVC accepts them without /arch:AVX2
+#if MIC_X86 && (defined(__GNUC__) || defined(__clang__))
+#define MIC_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define MIC_TARGET_AVX2
+#endif
+
+inline bool cpu_has_avx2() {
+#if !MIC_X86
+    return false;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+
+    // AVX2 also needs the OS to save YMM state
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+// SSE2 is part of the x64 baseline. 32-bit builds assume it too, as does
+// every CPU Windows 10 runs on.
+inline bool cpu_has_sse2() {
+    return MIC_X86 != 0;
+}
@@ -0,0 +1,265 @@
+#pragma once
+
+// Last known capture devices, kept on disk between runs so startup can bind
+// a device by name before the full enumeration has finished. Portable, no
+// platform headers: the file is written and mapped by the caller, this only
+// builds the bytes and reads them in place without copying.
+//
+// Layout, little-endian:
+//   header   magic "MICD", version, reserved (0), device count, string bytes,
+//            FNV-1a checksum of the rest of the header and everything after it
+//   records  one per device: id, name, description and the configured name
+//            it was bound under as offset/length into the string area, plus
+//            the device flags
+//   strings  UTF-8, not terminated
+// A file with another version, a bad checksum or out-of-range offsets is
+// ignored as a whole and rewritten after the next enumeration.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "audio_backend.h"
+
+const uint32_t DEVICE_CACHE_MAGIC = 0x4443494D; // "MICD"
+const uint16_t DEVICE_CACHE_VERSION = 2;
+
+enum DeviceCacheFlags : uint32_t {
+    DEVICE_CACHED_ENABLED = 1 << 0,
+    DEVICE_CACHED_DEFAULT = 1 << 1,
+    DEVICE_CACHED_TARGET = 1 << 2 // bound when the cache was written
+};
+
+struct DeviceCacheHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t device_count;
+    uint32_t string_bytes;
+    uint32_t checksum;
+};
+
+struct DeviceCacheRecord {
+    uint32_t id_offset, id_length;
+    uint32_t name_offset, name_length;
+    uint32_t description_offset, description_length;
+    uint32_t bound_offset, bound_length; // empty unless a target
+    uint32_t flags;
+};
+
+static_assert(sizeof(DeviceCacheHeader) == 20, "DeviceCacheHeader is a file format");
+static_assert(sizeof(DeviceCacheRecord) == 36, "DeviceCacheRecord is a file format");
+
+inline uint32_t device_cache_checksum(const char* data, size_t size, uint32_t hash = 2166136261u) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (uint8_t)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// A controlled device and the device_name (or group entry) that chose it
+struct DeviceCacheTarget {
+    std::string id;
+    std::string configured_name;
+};
+
+// What a cache file holds
+struct DeviceCacheContents {
+    std::vector<AudioDevice> devices;
+    std::vector<DeviceCacheTarget> targets;
+};
+
+inline std::string encode_device_cache(const DeviceCacheContents& contents) {
+    std::string strings;
+    std::vector<DeviceCacheRecord> records;
+    records.reserve(contents.devices.size());
+
+    auto add_string = [&strings](const std::string& text, uint32_t& offset, uint32_t& length) {
+        offset = (uint32_t)strings.size();
+        length = (uint32_t)text.size();
+        strings += text;
+    };
+
+    for (const AudioDevice& device : contents.devices) {
+        DeviceCacheRecord record = {};
+        add_string(device.id, record.id_offset, record.id_length);
+        add_string(device.name, record.name_offset, record.name_length);
+        add_string(device.description, record.description_offset, record.description_length);
+        if (device.is_enabled) record.flags |= DEVICE_CACHED_ENABLED;
+        if (device.is_default) record.flags |= DEVICE_CACHED_DEFAULT;
+
+        std::string bound;
+        for (const DeviceCacheTarget& target : contents.targets) {
+            if (target.id != device.id) continue;
+            record.flags |= DEVICE_CACHED_TARGET;
+            bound = target.configured_name;
+        }
+        add_string(bound, record.bound_offset, record.bound_length);
+        records.push_back(record);
+    }
+
+    size_t body_size = records.size() * sizeof(DeviceCacheRecord) + strings.size();
+    std::string bytes(sizeof(DeviceCacheHeader) + body_size, '\0');
+    char* body = &bytes[sizeof(DeviceCacheHeader)];
+    if (!records.empty()) memcpy(body, records.data(), records.size() * sizeof(DeviceCacheRecord));
+    if (!strings.empty()) memcpy(body + records.size() * sizeof(DeviceCacheRecord), strings.data(), strings.size());
+
+    DeviceCacheHeader header = {};
+    header.magic = DEVICE_CACHE_MAGIC;
+    header.version = DEVICE_CACHE_VERSION;
+    header.device_count = (uint32_t)records.size();
+    header.string_bytes = (uint32_t)strings.size();
+    memcpy(&bytes[0], &header, sizeof(header));
+
+    header.checksum = device_cache_checksum(body, body_size,
+        device_cache_checksum(bytes.data(), offsetof(DeviceCacheHeader, checksum)));
+    memcpy(&bytes[0], &header, sizeof(header));
+    return bytes;
+}
+
+// Reads a cache in place, typically straight from a mapped file.
+// The bytes must outlive the view.
+class DeviceCacheView {
+private:
+    const char* records = nullptr;
+    const char* strings = nullptr;
+    DeviceCacheHeader header = {};
+
+    DeviceCacheRecord record(size_t index) const {
+        DeviceCacheRecord r;
+        memcpy(&r, records + index * sizeof(DeviceCacheRecord), sizeof(r)); // no alignment assumed
+        return r;
+    }
+
+    std::string_view text(uint32_t offset, uint32_t length) const {
+        return std::string_view(strings + offset, length);
+    }
+
+    static bool in_range(uint32_t offset, uint32_t length, uint32_t limit) {
+        return offset <= limit && length <= limit - offset;
+    }
+
+public:
+    // False when the bytes are not a complete cache of this version
+    bool open(const void* data, size_t size) {
+        close();
+        if (!data || size < sizeof(DeviceCacheHeader)) return false;
+
+        DeviceCacheHeader h;
+        memcpy(&h, data, sizeof(h));
+        if (h.magic != DEVICE_CACHE_MAGIC || h.version != DEVICE_CACHE_VERSION) return false;
+
+        size_t body_size = size - sizeof(DeviceCacheHeader);
+        uint64_t expected = (uint64_t)h.device_count * sizeof(DeviceCacheRecord) + h.string_bytes;
+        if (expected != body_size) return false;
+
+        const char* body = (const char*)data + sizeof(DeviceCacheHeader);
+        uint32_t checksum = device_cache_checksum(body, body_size,
+            device_cache_checksum((const char*)data, offsetof(DeviceCacheHeader, checksum)));
+        if (checksum != h.checksum) return false;
+
+        header = h;
+        records = body;
+        strings = body + (size_t)h.device_count * sizeof(DeviceCacheRecord);
+        for (size_t i = 0; i < h.device_count; i++) {
+            DeviceCacheRecord r = record(i);
+            if (!in_range(r.id_offset, r.id_length, h.string_bytes) ||
+                !in_range(r.name_offset, r.name_length, h.string_bytes) ||
+                !in_range(r.description_offset, r.description_length, h.string_bytes) ||
+                !in_range(r.bound_offset, r.bound_length, h.string_bytes)) {
+                close();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void close() {
+        records = strings = nullptr;
+        header = DeviceCacheHeader();
+    }
+
+    bool is_open() const { return records != nullptr; }
+    size_t size() const { return header.device_count; }
+
+    std::string_view id(size_t index) const {
+        DeviceCacheRecord r = record(index);
+        return text(r.id_offset, r.id_length);
+    }
+
+    std::string_view name(size_t index) const {
+        DeviceCacheRecord r = record(index);
+        return text(r.name_offset, r.name_length);
+    }
+
+    uint32_t flags(size_t index) const { return record(index).flags; }
+
+    // Id of the device a configured name was bound to when the cache was
+    // written, even if the device has been renamed since; otherwise of the
+    // first enabled device with exactly that name. Empty if none.
+    std::string_view find_id_by_name(std::string_view configured_name) const {
+        for (size_t i = 0; i < size(); i++) {
+            DeviceCacheRecord r = record(i);
+            if ((r.flags & DEVICE_CACHED_TARGET) && text(r.bound_offset, r.bound_length) == configured_name) return id(i);
+        }
+        for (size_t i = 0; i < size(); i++) {
+            if ((flags(i) & DEVICE_CACHED_ENABLED) && name(i) == configured_name) return id(i);
+        }
+        return std::string_view();
+    }
+
+    std::vector<AudioDevice> devices() const {
+        std::vector<AudioDevice> result(size());
+        for (size_t i = 0; i < size(); i++) {
+            DeviceCacheRecord r = record(i);
+            result[i].id = std::string(text(r.id_offset, r.id_length));
+            result[i].name = std::string(text(r.name_offset, r.name_length));
+            result[i].description = std::string(text(r.description_offset, r.description_length));
+            result[i].is_enabled = (r.flags & DEVICE_CACHED_ENABLED) != 0;
+            result[i].is_default = (r.flags & DEVICE_CACHED_DEFAULT) != 0;
+        }
+        return result;
+    }
+};
+
+// The human-readable available_devices.txt, built in one string
+inline std::string format_device_list(const std::vector<AudioDevice>& devices, const std::string& config_file) {
+    std::string text;
+    text += "=== AVAILABLE AUDIO INPUT DEVICES ===\n\n";
+    text += "Copy the exact device name (including spaces and special characters) to your config file.\n";
+    text += "Use the 'device_name' setting in " + config_file + "\n\n";
+
+    if (devices.empty()) {
+        text += "No active audio input devices found!\n";
+        text += "Make sure your microphone is connected and enabled.\n";
+        return text;
+    }
+
+    for (size_t i = 0; i < devices.size(); i++) {
+        const AudioDevice& device = devices[i];
+        text += "Device " + std::to_string(i + 1) + ":\n";
+        text += "  Name: " + device.name + "\n";
+        text += "  Description: " + device.description + "\n";
+        text += "  Id: " + device.id + "\n";
+        text += device.is_enabled ? "  Status: Active\n" : "  Status: Inactive\n";
+        text += device.is_default ? "  Default: Yes\n\n" : "  Default: No\n\n";
+
+        if (device.is_default) {
+            text += "  *** This is your system's default microphone ***\n\n";
+        }
+    }
+
+    text += "=== CONFIGURATION INSTRUCTIONS ===\n\n";
+    text += "To use a specific device:\n";
+    text += "1. Open " + config_file + "\n";
+    text += "2. Set 'use_default_device = false'\n";
+    text += "3. Set 'device_name = [exact device name from above]'\n\n";
+    text += "Example:\n";
+    text += "use_default_device = false\n";
+    text += "device_name = " + devices[0].name + "\n";
+    return text;
+}
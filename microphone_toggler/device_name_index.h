@@ -0,0 +1,224 @@
+#pragma once
+
+// Finds a capture device by a configured name that no longer matches
+// exactly. Windows renames endpoints when a second device of the same model
+// appears ("Microphone (2- USB Audio)") and users retype names with other
+// spacing or case. Names are matched, in order:
+//   1. exactly
+//   2. normalized: case and whitespace folded, "N- " renumbering removed,
+//      when no other device normalizes to the same name
+//   3. by trigram similarity of the normalized names, when one candidate is
+//      clearly the best and similar enough
+// The index is built once per device list, with flat sorted posting lists
+// per trigram, and a lookup reuses its scratch buffers: exact and normalized
+// matches are one hash lookup, the similarity search touches only devices
+// that share a trigram with the name.
+// Portable, no platform headers.
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+enum class DeviceMatchKind : unsigned char {
+    None,
+    Exact,
+    Normalized,
+    Similar
+};
+
+inline bool is_device_name_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+inline bool is_device_name_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Lowercases ASCII, collapses whitespace (none inside parentheses) and drops
+// "N- " wherever a word starts with it,
+// e.g. "Microphone ( 2- USB  Audio)" -> "microphone (usb audio)"
+inline void normalize_device_name(std::string_view name, std::string& out) {
+    out.clear();
+    size_t i = 0;
+    while (i < name.size()) {
+        char c = name[i];
+        if (is_device_name_space(c)) {
+            if (!out.empty() && out.back() != ' ' && out.back() != '(') out += ' ';
+            i++;
+            continue;
+        }
+        if (c == ')' && !out.empty() && out.back() == ' ') out.pop_back();
+
+        bool word_start = out.empty() || out.back() == ' ' || out.back() == '(';
+        if (word_start && is_device_name_digit(c)) {
+            size_t j = i;
+            while (j < name.size() && is_device_name_digit(name[j])) j++;
+            if (j + 1 < name.size() && name[j] == '-' && is_device_name_space(name[j + 1])) {
+                i = j + 2;
+                while (i < name.size() && is_device_name_space(name[i])) i++;
+                continue;
+            }
+        }
+
+        out += (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+        i++;
+    }
+    if (!out.empty() && out.back() == ' ') out.pop_back();
+}
+
+class DeviceNameIndex {
+public:
+    // Dice coefficient of the trigram sets, 1 = same trigrams
+    static constexpr float MIN_SIMILARITY = 0.6f;
+    // The runner-up must trail by this much, otherwise the name is ambiguous
+    static constexpr float MIN_MARGIN = 0.1f;
+
+    struct Match {
+        size_t index = 0; // position in the list given to build()
+        DeviceMatchKind kind = DeviceMatchKind::None;
+        float similarity = 0.0f;
+    };
+
+private:
+    struct Posting {
+        uint32_t trigram;
+        uint32_t first; // into posting_devices
+        uint32_t count;
+    };
+
+    // Normalized names two devices share map to AMBIGUOUS, neither is picked
+    static const uint32_t AMBIGUOUS = UINT32_MAX;
+
+    std::unordered_map<std::string, uint32_t> exact;
+    std::unordered_map<std::string, uint32_t> normalized;
+    std::vector<Posting> postings;          // sorted by trigram
+    std::vector<uint32_t> posting_devices;
+    std::vector<uint32_t> trigram_counts;   // per device
+
+    // Lookup scratch, kept between calls
+    std::string scratch_name;
+    std::vector<uint32_t> scratch_trigrams;
+    std::vector<uint32_t> shared; // per device, zero between lookups
+    std::vector<uint32_t> candidates;
+
+    // Distinct trigrams of " name ", sorted
+    static void collect_trigrams(const std::string& name, std::vector<uint32_t>& trigrams) {
+        trigrams.clear();
+        size_t padded = name.size() + 2;
+        if (padded < 3) return;
+
+        auto at = [&name](size_t i) -> uint8_t {
+            return (i == 0 || i == name.size() + 1) ? ' ' : (uint8_t)name[i - 1];
+        };
+        for (size_t i = 0; i + 3 <= padded; i++) {
+            trigrams.push_back((uint32_t)at(i) << 16 | (uint32_t)at(i + 1) << 8 | at(i + 2));
+        }
+        std::sort(trigrams.begin(), trigrams.end());
+        trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    }
+
+    const Posting* find_posting(uint32_t trigram) const {
+        auto it = std::lower_bound(postings.begin(), postings.end(), trigram,
+            [](const Posting& p, uint32_t t) { return p.trigram < t; });
+        return (it != postings.end() && it->trigram == trigram) ? &*it : nullptr;
+    }
+
+public:
+    // Names of the devices that may be matched, the match index refers to this list
+    void build(const std::vector<std::string_view>& names) {
+        exact.clear();
+        normalized.clear();
+        postings.clear();
+        posting_devices.clear();
+        trigram_counts.assign(names.size(), 0);
+        shared.assign(names.size(), 0);
+
+        std::vector<std::pair<uint32_t, uint32_t>> pairs; // trigram, device
+        for (uint32_t i = 0; i < (uint32_t)names.size(); i++) {
+            exact.emplace(std::string(names[i]), i);
+            normalize_device_name(names[i], scratch_name);
+            auto added = normalized.emplace(scratch_name, i);
+            if (!added.second) added.first->second = AMBIGUOUS;
+
+            collect_trigrams(scratch_name, scratch_trigrams);
+            trigram_counts[i] = (uint32_t)scratch_trigrams.size();
+            for (uint32_t trigram : scratch_trigrams) pairs.emplace_back(trigram, i);
+        }
+
+        std::sort(pairs.begin(), pairs.end());
+        for (const auto& pair : pairs) {
+            if (postings.empty() || postings.back().trigram != pair.first) {
+                postings.push_back({ pair.first, (uint32_t)posting_devices.size(), 0 });
+            }
+            postings.back().count++;
+            posting_devices.push_back(pair.second);
+        }
+    }
+
+    Match lookup(std::string_view name) {
+        Match match;
+
+        // Heterogeneous lookup is C++20, the exact map needs a key
+        scratch_name.assign(name.data(), name.size());
+        auto hit = exact.find(scratch_name);
+        if (hit != exact.end()) {
+            match.index = hit->second;
+            match.kind = DeviceMatchKind::Exact;
+            match.similarity = 1.0f;
+            return match;
+        }
+
+        normalize_device_name(name, scratch_name);
+        hit = normalized.find(scratch_name);
+        if (hit != normalized.end()) {
+            // Identical normalized names are as similar as names get, no
+            // trigram margin can separate them either
+            if (hit->second == AMBIGUOUS) return match;
+            match.index = hit->second;
+            match.kind = DeviceMatchKind::Normalized;
+            match.similarity = 1.0f;
+            return match;
+        }
+
+        collect_trigrams(scratch_name, scratch_trigrams);
+        size_t query = scratch_trigrams.size();
+        if (query == 0) return match;
+
+        // Count shared trigrams, each device is touched once per trigram it shares
+        candidates.clear();
+        for (uint32_t trigram : scratch_trigrams) {
+            const Posting* list = find_posting(trigram);
+            if (!list) continue;
+            const uint32_t* device = posting_devices.data() + list->first;
+            for (uint32_t k = 0; k < list->count; k++) {
+                if (shared[device[k]]++ == 0) candidates.push_back(device[k]);
+            }
+        }
+
+        float best = 0.0f;
+        float runner_up = 0.0f;
+        uint32_t best_device = 0;
+        for (uint32_t device : candidates) {
+            float similarity = 2.0f * shared[device] / (float)(trigram_counts[device] + query);
+            shared[device] = 0;
+            if (similarity > best) {
+                runner_up = best;
+                best = similarity;
+                best_device = device;
+            }
+            else if (similarity > runner_up) {
+                runner_up = similarity;
+            }
+        }
+
+        if (best >= MIN_SIMILARITY && best - runner_up >= MIN_MARGIN) {
+            match.index = best_device;
+            match.kind = DeviceMatchKind::Similar;
+            match.similarity = best;
+        }
+        return match;
+    }
+};
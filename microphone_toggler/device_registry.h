@@ -0,0 +1,218 @@
+#pragma once
+
+// Persistent view of the capture devices, filled once by a full
+// enumeration and then kept current from backend device events.
+// The enumeration is lazy: until it has run (or a background scan has
+// been adopted) only the default device is looked up, so binding it at
+// startup does not wait for every endpoint to be described.
+// Entries cache their opened endpoint so switching devices does not
+// re-activate anything. Not thread-safe: owned by the UI thread.
+// Portable, no platform headers.
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "audio_backend.h"
+#include "device_name_index.h"
+
+class DeviceRegistry {
+private:
+    struct Entry {
+        AudioDevice info;
+        std::shared_ptr<CaptureEndpoint> endpoint; // opened lazily
+    };
+
+    AudioBackend* backend = nullptr;
+    std::unordered_map<std::string, Entry> entries;
+    std::vector<std::string> order; // enumeration/arrival order for listing
+    std::string default_id;
+    bool populated = false;
+
+    // Enabled devices by name, rebuilt on the first lookup after a change
+    DeviceNameIndex name_index;
+    std::vector<std::string> indexed_ids;
+    bool index_stale = true;
+
+    void erase(const std::string& id) {
+        if (entries.erase(id)) {
+            order.erase(std::remove(order.begin(), order.end(), id), order.end());
+            index_stale = true;
+        }
+    }
+
+    void rebuild_index() {
+        indexed_ids.clear();
+        std::vector<std::string_view> names;
+        for (const auto& id : order) {
+            const AudioDevice& info = entries.at(id).info;
+            if (!info.is_enabled) continue;
+            indexed_ids.push_back(id);
+            names.push_back(info.name);
+        }
+        name_index.build(names);
+        index_stale = false;
+    }
+
+    // Re-reads one device, dropping it if it is gone or disabled.
+    // Keeps a cached endpoint when the device is still the same one.
+    void refresh_device(const std::string& id) {
+        AudioDevice info;
+        if (!backend->describe_device(id, info)) {
+            erase(id);
+            return;
+        }
+
+        info.is_default = (id == default_id);
+        index_stale = true;
+        auto it = entries.find(id);
+        if (it != entries.end()) {
+            it->second.info = info;
+        }
+        else {
+            entries[id].info = info;
+            order.push_back(id);
+        }
+    }
+
+public:
+    void attach(AudioBackend* b) {
+        if (backend != b) {
+            clear();
+            backend = b;
+        }
+    }
+
+    void clear() {
+        entries.clear();
+        order.clear();
+        default_id.clear();
+        populated = false;
+        index_stale = true;
+    }
+
+    bool is_populated() const { return populated; }
+
+    // Full enumeration on the calling thread, only needed once per backend
+    void populate() {
+        if (backend) adopt(backend->enumerate_devices());
+    }
+
+    // Takes over a full enumeration, possibly made by another instance of the
+    // backend on a background thread. Endpoints already opened stay cached.
+    void adopt(std::vector<AudioDevice> devices) {
+        std::unordered_map<std::string, Entry> previous;
+        previous.swap(entries);
+        order.clear();
+        default_id.clear();
+
+        for (auto& device : devices) {
+            if (device.is_default) default_id = device.id;
+            order.push_back(device.id);
+
+            Entry& entry = entries[device.id];
+            auto old = previous.find(device.id);
+            if (old != previous.end()) entry.endpoint = std::move(old->second.endpoint);
+            entry.info = std::move(device);
+        }
+        populated = true;
+        index_stale = true;
+    }
+
+    // Incremental update from a backend notification.
+    // Returns true if the device list or the default device changed.
+    bool apply_event(DeviceEvent event, const std::string& id) {
+        if (!backend || !populated) return false;
+
+        switch (event) {
+        case DeviceEvent::Removed:
+            if (!entries.count(id)) return false;
+            erase(id);
+            return true;
+
+        case DeviceEvent::Added:
+        case DeviceEvent::StateChanged:
+        case DeviceEvent::PropertiesChanged: {
+            bool known = entries.count(id) != 0;
+            refresh_device(id);
+            return known || entries.count(id) != 0;
+        }
+
+        case DeviceEvent::DefaultChanged: {
+            if (id == default_id) return false;
+
+            auto old_default = entries.find(default_id);
+            if (old_default != entries.end()) old_default->second.info.is_default = false;
+
+            default_id = id;
+            auto new_default = entries.find(id);
+            if (new_default != entries.end()) new_default->second.info.is_default = true;
+            return true;
+        }
+        }
+        return false;
+    }
+
+    // Before the enumeration this describes the default device alone
+    const std::string& get_default_id() {
+        if (!populated && default_id.empty() && backend) {
+            default_id = backend->default_device_id();
+            if (!default_id.empty()) refresh_device(default_id);
+        }
+        return default_id;
+    }
+
+    const AudioDevice* find(const std::string& id) const {
+        auto it = entries.find(id);
+        return it != entries.end() ? &it->second.info : nullptr;
+    }
+
+    // One device without the full enumeration, e.g. an id remembered from
+    // the last run. Once populated this is a plain lookup.
+    const AudioDevice* describe(const std::string& id) {
+        if (!backend) return nullptr;
+        if (!populated) refresh_device(id);
+        return find(id);
+    }
+
+    // Names can only be matched against the full list, enumerated here if needed.
+    // Falls back to a normalized or similar name, see DeviceNameIndex.
+    const AudioDevice* find_by_name(const std::string& name, DeviceNameIndex::Match* how = nullptr) {
+        if (!populated) populate();
+        if (index_stale) rebuild_index();
+
+        DeviceNameIndex::Match match = name_index.lookup(name);
+        if (how) *how = match;
+        if (match.kind == DeviceMatchKind::None) return nullptr;
+        return find(indexed_ids[match.index]);
+    }
+
+    // Returns the cached endpoint, opening it on first use
+    std::shared_ptr<CaptureEndpoint> acquire(const std::string& id) {
+        auto it = entries.find(id);
+        if (it == entries.end()) return nullptr;
+
+        Entry& entry = it->second;
+        if (!entry.endpoint) {
+            entry.endpoint = backend->open_device(id);
+        }
+        return entry.endpoint;
+    }
+
+    // Drops a cached endpoint that stopped working, the next acquire reopens it
+    void invalidate(const std::string& id) {
+        auto it = entries.find(id);
+        if (it != entries.end()) it->second.endpoint.reset();
+    }
+
+    std::vector<AudioDevice> devices() const {
+        std::vector<AudioDevice> result;
+        result.reserve(order.size());
+        for (const auto& id : order) {
+            result.push_back(entries.at(id).info);
+        }
+        return result;
+    }
+};
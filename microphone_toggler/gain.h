@@ -0,0 +1,89 @@
+#pragma once
+
+// Software gain for 16-bit PCM buffers. Portable, no platform headers.
+// apply_gain_int16 picks the widest kernel the CPU supports on first use,
+// all kernels truncate toward zero and saturate so their output matches.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "cpu_features.h"
+
+typedef void (*GainKernel)(int16_t* samples, size_t count, float gain);
+
+inline void gain_int16_scalar(int16_t* samples, size_t count, float gain) {
+    for (size_t i = 0; i < count; i++) {
+        float v = samples[i] * gain;
+        if (v > 32767.0f) v = 32767.0f;
+        else if (v < -32768.0f) v = -32768.0f;
+        samples[i] = (int16_t)v;
+    }
+}
+
+#if MIC_X86
+inline void gain_int16_sse2(int16_t* samples, size_t count, float gain) {
+    const __m128 g = _mm_set1_ps(gain);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(samples + i));
+
+        // Sign-extend 8 x int16 to two halves of 4 x int32
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+
+        __m128 flo = _mm_mul_ps(_mm_cvtepi32_ps(lo), g);
+        __m128 fhi = _mm_mul_ps(_mm_cvtepi32_ps(hi), g);
+
+        // Saturating pack back to int16
+        __m128i out = _mm_packs_epi32(_mm_cvttps_epi32(flo), _mm_cvttps_epi32(fhi));
+        _mm_storeu_si128((__m128i*)(samples + i), out);
+    }
+
+    gain_int16_scalar(samples + i, count - i, gain);
+}
+
+MIC_TARGET_AVX2
+inline void gain_int16_avx2(int16_t* samples, size_t count, float gain) {
+    const __m256 g = _mm256_set1_ps(gain);
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(samples + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(samples + i + 8));
+
+        __m256 fa = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(a)), g);
+        __m256 fb = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(b)), g);
+
+        // packs works per 128-bit lane, restore sample order afterwards
+        __m256i packed = _mm256_packs_epi32(_mm256_cvttps_epi32(fa), _mm256_cvttps_epi32(fb));
+        packed = _mm256_permute4x64_epi64(packed, 0xD8);
+        _mm256_storeu_si256((__m256i*)(samples + i), packed);
+    }
+
+    gain_int16_sse2(samples + i, count - i, gain);
+}
+#endif
+
+inline GainKernel select_gain_kernel() {
+#if MIC_X86
+    if (cpu_has_avx2()) return gain_int16_avx2;
+    if (cpu_has_sse2()) return gain_int16_sse2;
+#endif
+    return gain_int16_scalar;
+}
+
+// Scales samples in place by gain (1.0 = unchanged), saturating to int16
+inline void apply_gain_int16(int16_t* samples, size_t count, float gain) {
+    if (gain == 1.0f) return;
+
+    static const GainKernel kernel = select_gain_kernel();
+    kernel(samples, count, gain);
+}
+
+// Maps a 0-100 volume setting to a linear gain
+inline float volume_to_gain(int volume) {
+    if (volume <= 0) return 0.0f;
+    if (volume >= 100) return 1.0f;
+    return volume / 100.0f;
+}
@@ -0,0 +1,309 @@
+#pragma once
+
+// Hotkey chords and a constant-time matcher for a low-level key stream.
+// Modifier state is tracked from the key events themselves in a small
+// bitset, and every bound chord lives in a table indexed by virtual-key
+// code and modifier mask, so one key event costs one lookup no matter how
+// many bindings exist. Auto-repeat is dropped and a bound key reports its
+// release, which push-to-talk needs. Portable, no platform headers: key
+// codes below are the Windows virtual-key values, modifier bits match
+// RegisterHotKey's MOD_*.
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+const unsigned HOTKEY_MOD_ALT = 0x1;
+const unsigned HOTKEY_MOD_CONTROL = 0x2;
+const unsigned HOTKEY_MOD_SHIFT = 0x4;
+const unsigned HOTKEY_MOD_WIN = 0x8;
+const unsigned HOTKEY_MOD_MASK = 0xF;
+
+enum class HotkeyAction : unsigned char {
+    None,
+    Toggle,
+    Mute,
+    Unmute,
+    CycleDevice,
+    PushToTalk, // unmuted while held
+    PushToMute  // muted while held
+};
+
+inline bool is_hold_action(HotkeyAction action) {
+    return action == HotkeyAction::PushToTalk || action == HotkeyAction::PushToMute;
+}
+
+enum class HotkeyEdge : unsigned char {
+    Press,
+    Release
+};
+
+struct HotkeyEvent {
+    HotkeyAction action = HotkeyAction::None;
+    HotkeyEdge edge = HotkeyEdge::Press;
+    bool swallow = false; // the key belongs to a binding, hide it from other apps
+};
+
+struct HotkeyChord {
+    unsigned mods = 0; // HOTKEY_MOD_* bits
+    unsigned vk = 0;   // 0 = unbound
+
+    bool empty() const { return vk == 0; }
+    bool operator==(const HotkeyChord& other) const { return mods == other.mods && vk == other.vk; }
+    bool operator!=(const HotkeyChord& other) const { return !(*this == other); }
+};
+
+struct HotkeyKeyName {
+    const char* name;
+    unsigned vk;
+};
+
+// Named keys besides letters, digits and F1-F24
+inline const HotkeyKeyName* hotkey_key_names(size_t& count) {
+    static const HotkeyKeyName names[] = {
+        { "Space", 0x20 }, { "Enter", 0x0D }, { "Tab", 0x09 }, { "Escape", 0x1B },
+        { "Backspace", 0x08 }, { "Pause", 0x13 }, { "ScrollLock", 0x91 },
+        { "Insert", 0x2D }, { "Delete", 0x2E }, { "Home", 0x24 }, { "End", 0x23 },
+        { "PageUp", 0x21 }, { "PageDown", 0x22 },
+        { "Left", 0x25 }, { "Up", 0x26 }, { "Right", 0x27 }, { "Down", 0x28 },
+        { "MediaPlayPause", 0xB3 }, { "VolumeMute", 0xAD },
+    };
+    count = sizeof(names) / sizeof(names[0]);
+    return names;
+}
+
+inline bool hotkey_name_equals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        char x = a[i], y = b[i];
+        if (x >= 'A' && x <= 'Z') x = (char)(x - 'A' + 'a');
+        if (y >= 'A' && y <= 'Z') y = (char)(y - 'A' + 'a');
+        if (x != y) return false;
+    }
+    return true;
+}
+
+inline unsigned hotkey_key_from_name(std::string_view name) {
+    if (name.size() == 1) {
+        char c = name[0];
+        if (c >= 'a' && c <= 'z') c = (char)(c - 'a' + 'A');
+        if ((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) return (unsigned)c;
+    }
+
+    if (name.size() >= 2 && (name[0] == 'F' || name[0] == 'f')) {
+        unsigned n = 0;
+        bool digits = name.size() <= 3;
+        for (size_t i = 1; i < name.size() && digits; i++) {
+            if (name[i] < '0' || name[i] > '9') digits = false;
+            else n = n * 10 + (unsigned)(name[i] - '0');
+        }
+        if (digits && n >= 1 && n <= 24) return 0x70 + n - 1;
+    }
+
+    size_t count;
+    const HotkeyKeyName* names = hotkey_key_names(count);
+    for (size_t i = 0; i < count; i++) {
+        if (hotkey_name_equals(name, names[i].name)) return names[i].vk;
+    }
+
+    // Raw virtual-key code for anything without a name
+    unsigned code = 0;
+    if (name.empty() || name.size() > 3) return 0;
+    for (char c : name) {
+        if (c < '0' || c > '9') return 0;
+        code = code * 10 + (unsigned)(c - '0');
+    }
+    return code < 256 ? code : 0;
+}
+
+inline std::string hotkey_key_to_name(unsigned vk) {
+    if ((vk >= 'A' && vk <= 'Z') || (vk >= '0' && vk <= '9')) return std::string(1, (char)vk);
+    if (vk >= 0x70 && vk <= 0x87) return "F" + std::to_string(vk - 0x70 + 1);
+
+    size_t count;
+    const HotkeyKeyName* names = hotkey_key_names(count);
+    for (size_t i = 0; i < count; i++) {
+        if (names[i].vk == vk) return names[i].name;
+    }
+    // Two digits at least, a lone digit would read back as that digit's key
+    return (vk < 10 ? "0" : "") + std::to_string(vk);
+}
+
+// "Ctrl+Shift+F2", "Alt+M", "Win+Space", "Ctrl+145". Empty text unbinds.
+inline bool parse_hotkey_chord(std::string_view text, HotkeyChord& chord) {
+    HotkeyChord result;
+    while (!text.empty()) {
+        size_t plus = text.find('+');
+        std::string_view part = text.substr(0, plus);
+        while (!part.empty() && (part.front() == ' ' || part.front() == '\t')) part.remove_prefix(1);
+        while (!part.empty() && (part.back() == ' ' || part.back() == '\t')) part.remove_suffix(1);
+
+        if (plus == std::string_view::npos) {
+            result.vk = hotkey_key_from_name(part);
+            if (result.vk == 0) return false;
+            break;
+        }
+
+        if (hotkey_name_equals(part, "ctrl") || hotkey_name_equals(part, "control")) result.mods |= HOTKEY_MOD_CONTROL;
+        else if (hotkey_name_equals(part, "alt")) result.mods |= HOTKEY_MOD_ALT;
+        else if (hotkey_name_equals(part, "shift")) result.mods |= HOTKEY_MOD_SHIFT;
+        else if (hotkey_name_equals(part, "win")) result.mods |= HOTKEY_MOD_WIN;
+        else return false;
+
+        text.remove_prefix(plus + 1);
+        if (text.empty()) return false; // trailing '+'
+    }
+
+    chord = result;
+    return true;
+}
+
+inline std::string format_hotkey_chord(const HotkeyChord& chord) {
+    if (chord.empty()) return "";
+
+    std::string text;
+    if (chord.mods & HOTKEY_MOD_CONTROL) text += "Ctrl+";
+    if (chord.mods & HOTKEY_MOD_ALT) text += "Alt+";
+    if (chord.mods & HOTKEY_MOD_SHIFT) text += "Shift+";
+    if (chord.mods & HOTKEY_MOD_WIN) text += "Win+";
+    return text + hotkey_key_to_name(chord.vk);
+}
+
+class HotkeyMatcher {
+private:
+    // Left and right keys are held separately, released independently
+    enum HeldModifier : uint8_t {
+        HELD_LCONTROL = 1 << 0, HELD_RCONTROL = 1 << 1,
+        HELD_LALT = 1 << 2, HELD_RALT = 1 << 3,
+        HELD_LSHIFT = 1 << 4, HELD_RSHIFT = 1 << 5,
+        HELD_LWIN = 1 << 6, HELD_RWIN = 1 << 7
+    };
+
+    // held bit per virtual-key code, 0 for non-modifier keys
+    uint8_t modifier_bits[256];
+    uint8_t held = 0;
+
+    // actions[vk][mods], with bound[vk] as a one-byte early out
+    HotkeyAction actions[256][HOTKEY_MOD_MASK + 1];
+    bool bound[256];
+
+    // Per bound key: is it down, and which action its press matched.
+    // The release goes to that action whatever the modifiers are by then.
+    bool pressed[256];
+    HotkeyAction active[256];
+
+    static unsigned fold(uint8_t held_bits) {
+        unsigned mods = 0;
+        if (held_bits & (HELD_LCONTROL | HELD_RCONTROL)) mods |= HOTKEY_MOD_CONTROL;
+        if (held_bits & (HELD_LALT | HELD_RALT)) mods |= HOTKEY_MOD_ALT;
+        if (held_bits & (HELD_LSHIFT | HELD_RSHIFT)) mods |= HOTKEY_MOD_SHIFT;
+        if (held_bits & (HELD_LWIN | HELD_RWIN)) mods |= HOTKEY_MOD_WIN;
+        return mods;
+    }
+
+public:
+    HotkeyMatcher() {
+        memset(modifier_bits, 0, sizeof(modifier_bits));
+        // Generic codes count as the left key
+        modifier_bits[0x10] = HELD_LSHIFT;   // VK_SHIFT
+        modifier_bits[0x11] = HELD_LCONTROL; // VK_CONTROL
+        modifier_bits[0x12] = HELD_LALT;     // VK_MENU
+        modifier_bits[0xA0] = HELD_LSHIFT;
+        modifier_bits[0xA1] = HELD_RSHIFT;
+        modifier_bits[0xA2] = HELD_LCONTROL;
+        modifier_bits[0xA3] = HELD_RCONTROL;
+        modifier_bits[0xA4] = HELD_LALT;
+        modifier_bits[0xA5] = HELD_RALT;
+        modifier_bits[0x5B] = HELD_LWIN;
+        modifier_bits[0x5C] = HELD_RWIN;
+        clear();
+        reset_key_state();
+    }
+
+    // Drops the bindings, a key held right now still reports its release
+    void clear() {
+        memset(actions, 0, sizeof(actions));
+        memset(bound, 0, sizeof(bound));
+    }
+
+    // A later binding of the same chord replaces the earlier one
+    void bind(const HotkeyChord& chord, HotkeyAction action) {
+        if (chord.empty() || chord.vk > 255) return;
+        actions[chord.vk][chord.mods & HOTKEY_MOD_MASK] = action;
+        bound[chord.vk] = true;
+    }
+
+    // Call for every key event. A key-down whose modifiers match a binding
+    // exactly reports Press, its key-up reports Release for the same action.
+    // Auto-repeated key-downs report nothing but are still swallowed.
+    HotkeyEvent on_key(unsigned vk, bool down) {
+        HotkeyEvent event;
+        if (vk > 255) return event;
+
+        uint8_t bit = modifier_bits[vk];
+        if (bit) {
+            held = down ? (uint8_t)(held | bit) : (uint8_t)(held & ~bit);
+        }
+
+        if (down) {
+            if (pressed[vk]) {
+                event.swallow = active[vk] != HotkeyAction::None; // auto-repeat
+                return event;
+            }
+            if (!bound[vk]) return event;
+
+            pressed[vk] = true;
+            active[vk] = actions[vk][fold(held)];
+            event.action = active[vk];
+        }
+        else {
+            if (!pressed[vk]) return event;
+
+            pressed[vk] = false;
+            event.action = active[vk];
+            event.edge = HotkeyEdge::Release;
+            active[vk] = HotkeyAction::None;
+        }
+
+        event.swallow = event.action != HotkeyAction::None;
+        return event;
+    }
+
+    unsigned modifiers() const { return fold(held); }
+
+    // For when key-ups may have been missed, e.g. the hook was reinstalled
+    void reset_key_state() {
+        held = 0;
+        memset(pressed, 0, sizeof(pressed));
+        memset(active, 0, sizeof(active));
+    }
+};
+
+// Push-to-talk / push-to-mute. The most recently pressed hold key decides,
+// releasing it returns to that key's resting state: muted for push-to-talk,
+// unmuted for push-to-mute. Releasing an overridden hold key does nothing.
+class HoldStateMachine {
+private:
+    HotkeyAction holding = HotkeyAction::None;
+
+public:
+    // True when the event asks for a mute state, which is stored in muted
+    bool on_event(const HotkeyEvent& event, bool& muted) {
+        if (!is_hold_action(event.action)) return false;
+
+        if (event.edge == HotkeyEdge::Press) {
+            holding = event.action;
+            muted = (event.action == HotkeyAction::PushToMute);
+            return true;
+        }
+
+        if (event.action != holding) return false;
+        holding = HotkeyAction::None;
+        muted = (event.action == HotkeyAction::PushToTalk);
+        return true;
+    }
+
+    bool is_holding() const { return holding != HotkeyAction::None; }
+    HotkeyAction current() const { return holding; }
+};
@@ -0,0 +1,255 @@
+#pragma once
+
+// Toggle latency instrumentation. Portable, no platform headers.
+// Every toggle gets a trace slot in a fixed ring; each stage stores one
+// timestamp there with a relaxed atomic, so recording is a clock read and
+// a store. The UI thread folds finished traces into log-linear (HDR-style)
+// histograms, one per stage, measured from the moment the hotkey arrived.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+
+enum LatencyStage {
+    STAGE_HOOK_RECEIVED, // hotkey seen by the hook/window procedure
+    STAGE_DISPATCHED,    // picked up by the mute worker
+    STAGE_BACKEND_DONE,  // SetMute returned for the whole group
+    STAGE_SOUND_STARTED, // notification sound handed to the device
+    STAGE_TRAY_UPDATED,  // tray icon shows the new state
+    STAGE_COUNT
+};
+
+inline const char* latency_stage_name(int stage) {
+    static const char* const names[STAGE_COUNT] = {
+        "hook_received", "dispatched", "backend_done", "sound_started", "tray_updated"
+    };
+    return stage >= 0 && stage < STAGE_COUNT ? names[stage] : "unknown";
+}
+
+inline uint64_t latency_now_ns() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Log-linear buckets: exact below 32 ns, then 16 buckets per power of two,
+// so every recorded value is within ~6% of its bucket's bounds
+class LatencyHistogram {
+public:
+    static const int SUB_BUCKET_BITS = 5;
+    static const uint64_t SUB_BUCKETS = 1ull << SUB_BUCKET_BITS;
+    static const uint64_t HALF_BUCKETS = SUB_BUCKETS / 2;
+    static const size_t BUCKET_COUNT = SUB_BUCKETS + (64 - SUB_BUCKET_BITS) * HALF_BUCKETS;
+
+private:
+    uint64_t counts[BUCKET_COUNT] = {};
+    uint64_t total = 0;
+    uint64_t lowest_value = UINT64_MAX;
+    uint64_t highest_value = 0;
+
+    static int highest_bit(uint64_t v) {
+        int bit = 0;
+        if (v >> 32) { v >>= 32; bit += 32; }
+        if (v >> 16) { v >>= 16; bit += 16; }
+        if (v >> 8) { v >>= 8; bit += 8; }
+        if (v >> 4) { v >>= 4; bit += 4; }
+        if (v >> 2) { v >>= 2; bit += 2; }
+        if (v >> 1) { bit += 1; }
+        return bit;
+    }
+
+    static size_t bucket_index(uint64_t v) {
+        if (v < SUB_BUCKETS) return (size_t)v;
+        int shift = highest_bit(v) - (SUB_BUCKET_BITS - 1);
+        return (size_t)(SUB_BUCKETS + (shift - 1) * HALF_BUCKETS + ((v >> shift) - HALF_BUCKETS));
+    }
+
+    // Largest value that lands in the bucket
+    static uint64_t bucket_upper(size_t index) {
+        if (index < SUB_BUCKETS) return index;
+        size_t shift = (index - SUB_BUCKETS) / HALF_BUCKETS + 1;
+        uint64_t base = HALF_BUCKETS + (index - SUB_BUCKETS) % HALF_BUCKETS;
+        return ((base + 1) << shift) - 1;
+    }
+
+public:
+    void record(uint64_t value) {
+        counts[bucket_index(value)]++;
+        total++;
+        if (value < lowest_value) lowest_value = value;
+        if (value > highest_value) highest_value = value;
+    }
+
+    void reset() { *this = LatencyHistogram(); }
+
+    uint64_t count() const { return total; }
+    uint64_t lowest() const { return total ? lowest_value : 0; }
+    uint64_t highest() const { return highest_value; }
+
+    // percentile in [0, 100], reported as the bucket's upper bound
+    uint64_t percentile(double p) const {
+        if (total == 0) return 0;
+        uint64_t rank = (uint64_t)(p / 100.0 * total + 0.5);
+        if (rank < 1) rank = 1;
+        if (rank > total) rank = total;
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; i++) {
+            seen += counts[i];
+            if (seen >= rank) {
+                uint64_t upper = bucket_upper(i);
+                return upper < highest_value ? upper : highest_value;
+            }
+        }
+        return highest_value;
+    }
+};
+
+class LatencyRecorder {
+public:
+    typedef uint32_t TraceId; // 0 = not traced
+
+    // More than this many toggles in flight overwrite the oldest traces
+    static const uint32_t TRACE_SLOTS = 256;
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> trace;
+        std::atomic<uint64_t> stamps[STAGE_COUNT];
+    };
+
+    Slot slots[TRACE_SLOTS];
+    std::atomic<uint32_t> next_trace{ 1 };
+
+    // Owned by the thread that calls complete(), normally the UI thread
+    LatencyHistogram histograms[STAGE_COUNT];
+    std::atomic<uint64_t> dropped{ 0 }; // abandon() may run on any thread
+
+    Slot& slot(TraceId trace) { return slots[trace % TRACE_SLOTS]; }
+
+public:
+    LatencyRecorder() {
+        for (auto& s : slots) {
+            s.trace.store(0, std::memory_order_relaxed);
+            for (auto& stamp : s.stamps) stamp.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    LatencyRecorder(const LatencyRecorder&) = delete;
+    LatencyRecorder& operator=(const LatencyRecorder&) = delete;
+
+    // Opens a trace whose first stage happened at received_ns
+    TraceId begin(uint64_t received_ns) {
+        TraceId trace = next_trace.fetch_add(1, std::memory_order_relaxed);
+        if (trace == 0) trace = next_trace.fetch_add(1, std::memory_order_relaxed);
+
+        Slot& s = slot(trace);
+        for (int i = 1; i < STAGE_COUNT; i++) s.stamps[i].store(0, std::memory_order_relaxed);
+        s.stamps[STAGE_HOOK_RECEIVED].store(received_ns, std::memory_order_relaxed);
+        s.trace.store(trace, std::memory_order_release);
+        return trace;
+    }
+
+    void mark(TraceId trace, LatencyStage stage) {
+        if (trace == 0) return;
+        slot(trace).stamps[stage].store(latency_now_ns(), std::memory_order_relaxed);
+    }
+
+    // Folds a finished trace into the histograms. Stages that never ran
+    // (no sound, coalesced request) are left out of their histogram.
+    void complete(TraceId trace) {
+        if (trace == 0) return;
+        Slot& s = slot(trace);
+        if (s.trace.load(std::memory_order_acquire) != trace) {
+            dropped.fetch_add(1, std::memory_order_relaxed); // slot reused before the UI thread got to it
+            return;
+        }
+
+        uint64_t start = s.stamps[STAGE_HOOK_RECEIVED].load(std::memory_order_relaxed);
+        for (int i = STAGE_HOOK_RECEIVED + 1; i < STAGE_COUNT; i++) {
+            uint64_t stamp = s.stamps[i].load(std::memory_order_relaxed);
+            if (stamp >= start && stamp != 0) histograms[i].record(stamp - start);
+        }
+        histograms[STAGE_HOOK_RECEIVED].record(0);
+    }
+
+    // For a trace that will never be completed: folded into a newer request,
+    // nothing to change, or the request never reached the worker. Counted as
+    // dropped. Any thread.
+    void abandon(TraceId trace) {
+        if (trace == 0) return;
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const LatencyHistogram& histogram(LatencyStage stage) const { return histograms[stage]; }
+    uint64_t completed() const { return histograms[STAGE_HOOK_RECEIVED].count(); }
+    uint64_t dropped_traces() const { return dropped.load(std::memory_order_relaxed); }
+
+    void reset() {
+        for (auto& h : histograms) h.reset();
+        dropped.store(0, std::memory_order_relaxed);
+    }
+
+    // One row per stage, latencies in microseconds since the hotkey arrived
+    void write_csv(std::ostream& out) const {
+        out << "stage,count,min_us,p50_us,p99_us,p999_us,max_us\n";
+        for (int i = STAGE_HOOK_RECEIVED + 1; i < STAGE_COUNT; i++) {
+            const LatencyHistogram& h = histograms[i];
+            char row[160];
+            snprintf(row, sizeof(row), "%s,%llu,%.1f,%.1f,%.1f,%.1f,%.1f\n",
+                latency_stage_name(i), (unsigned long long)h.count(),
+                h.lowest() / 1000.0, h.percentile(50) / 1000.0, h.percentile(99) / 1000.0,
+                h.percentile(99.9) / 1000.0, h.highest() / 1000.0);
+            out << row;
+        }
+    }
+
+    // Human-readable p50/p99/p999 per stage
+    void write_summary(std::ostream& out) const {
+        out << "Toggles measured: " << completed() << ", not completed: " << dropped_traces() << "\n";
+        for (int i = STAGE_HOOK_RECEIVED + 1; i < STAGE_COUNT; i++) {
+            const LatencyHistogram& h = histograms[i];
+            char row[160];
+            snprintf(row, sizeof(row), "%-14s p50 %8.1f us  p99 %8.1f us  p999 %8.1f us\n",
+                latency_stage_name(i), h.percentile(50) / 1000.0,
+                h.percentile(99) / 1000.0, h.percentile(99.9) / 1000.0);
+            out << row;
+        }
+    }
+};
+
+// Where startup time goes: the UI thread marks the end of each phase,
+// one clock read per mark, and the phases are logged once it is ready
+class StartupTrace {
+public:
+    static const size_t MAX_PHASES = 16;
+
+    struct Phase {
+        const char* name;
+        uint64_t duration_ns;
+    };
+
+private:
+    uint64_t origin_ns = latency_now_ns();
+    uint64_t last_ns = origin_ns;
+    Phase phases[MAX_PHASES] = {};
+    size_t phase_count = 0;
+
+public:
+    void restart() {
+        origin_ns = last_ns = latency_now_ns();
+        phase_count = 0;
+    }
+
+    // Ends the phase that started at the previous mark
+    void mark(const char* name) {
+        uint64_t now = latency_now_ns();
+        if (phase_count < MAX_PHASES) phases[phase_count++] = { name, now - last_ns };
+        last_ns = now;
+    }
+
+    size_t size() const { return phase_count; }
+    const Phase& phase(size_t i) const { return phases[i]; }
+    uint64_t total_ns() const { return last_ns - origin_ns; }
+};
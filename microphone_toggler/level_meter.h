@@ -0,0 +1,214 @@
+#pragma once
+
+// Input level meter for the tray icon. Portable, no platform headers.
+// Capture buffers are reduced to peak and sum of squares by the widest
+// kernel the CPU supports. Every METER_WINDOW_MS the window is turned into
+// a small quantized level, and only a level that differs from the last one
+// is reported, so the icon is redrawn at most 1000 / METER_WINDOW_MS times
+// a second and not at all while the input stays put.
+
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "cpu_features.h"
+
+struct LevelStats {
+    float peak = 0.0f;  // largest absolute sample
+    double energy = 0.0; // sum of squares
+};
+
+typedef void (*LevelKernel)(const float* samples, size_t count, LevelStats& stats);
+
+inline void level_stats_scalar(const float* samples, size_t count, LevelStats& stats) {
+    float peak = stats.peak;
+    float energy = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        float v = samples[i];
+        float magnitude = std::fabs(v);
+        if (magnitude > peak) peak = magnitude;
+        energy += v * v;
+    }
+    stats.peak = peak;
+    stats.energy += energy;
+}
+
+#if MIC_X86
+inline void level_stats_sse2(const float* samples, size_t count, LevelStats& stats) {
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 peak = _mm_set1_ps(stats.peak);
+    __m128 sum = _mm_setzero_ps();
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 v = _mm_loadu_ps(samples + i);
+        peak = _mm_max_ps(peak, _mm_andnot_ps(sign, v));
+        sum = _mm_add_ps(sum, _mm_mul_ps(v, v));
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, peak);
+    float p = lanes[0];
+    for (int lane = 1; lane < 4; lane++) {
+        if (lanes[lane] > p) p = lanes[lane];
+    }
+    _mm_storeu_ps(lanes, sum);
+    stats.peak = p;
+    stats.energy += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    level_stats_scalar(samples + i, count - i, stats);
+}
+
+MIC_TARGET_AVX2
+inline void level_stats_avx2(const float* samples, size_t count, LevelStats& stats) {
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    __m256 peak = _mm256_set1_ps(stats.peak);
+    __m256 sum = _mm256_setzero_ps();
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256 v = _mm256_loadu_ps(samples + i);
+        peak = _mm256_max_ps(peak, _mm256_andnot_ps(sign, v));
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(v, v));
+    }
+
+    __m128 peak4 = _mm_max_ps(_mm256_castps256_ps128(peak), _mm256_extractf128_ps(peak, 1));
+    __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+    float lanes[4];
+    _mm_storeu_ps(lanes, peak4);
+    float p = lanes[0];
+    for (int lane = 1; lane < 4; lane++) {
+        if (lanes[lane] > p) p = lanes[lane];
+    }
+    _mm_storeu_ps(lanes, sum4);
+    stats.peak = p;
+    stats.energy += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    level_stats_scalar(samples + i, count - i, stats);
+}
+#endif
+
+inline LevelKernel select_level_kernel() {
+#if MIC_X86
+    if (cpu_has_avx2()) return level_stats_avx2;
+    if (cpu_has_sse2()) return level_stats_sse2;
+#endif
+    return level_stats_scalar;
+}
+
+// A quantized meter reading, RMS for the bar and a decaying peak tick.
+// 0 = below the bottom of the scale, LEVEL_STEPS = full scale.
+struct MeterLevel {
+    uint8_t rms = 0;
+    uint8_t peak = 0;
+
+    bool operator==(const MeterLevel& other) const { return rms == other.rms && peak == other.peak; }
+    bool operator!=(const MeterLevel& other) const { return !(*this == other); }
+};
+
+class LevelMeter {
+public:
+    static const unsigned LEVEL_STEPS = 8;
+    static const unsigned METER_WINDOW_MS = 50;
+    static constexpr float BOTTOM_DB = -48.0f; // each step is 6 dB
+
+private:
+    LevelKernel kernel = select_level_kernel();
+    unsigned window_samples = 2400;
+
+    // Capture thread only
+    LevelStats window;
+    unsigned window_fill = 0;
+    MeterLevel last;
+
+    // Written by the capture thread, read by the UI thread
+    std::atomic<uint16_t> published{ 0 };
+
+    static uint8_t quantize(float db) {
+        float step = (db - BOTTOM_DB) / (-BOTTOM_DB / LEVEL_STEPS);
+        if (!(step > 0.0f)) return 0;
+        if (step >= LEVEL_STEPS) return LEVEL_STEPS;
+        return (uint8_t)step;
+    }
+
+    // True when the quantized level changed
+    bool finish_window() {
+        MeterLevel level;
+        level.rms = quantize(10.0f * std::log10((float)(window.energy / window_samples) + 1e-12f));
+        level.peak = quantize(20.0f * std::log10(window.peak + 1e-6f));
+
+        // The tick falls one step per window so short peaks stay visible
+        if (last.peak > 0 && level.peak < last.peak - 1) level.peak = (uint8_t)(last.peak - 1);
+        if (level.peak < level.rms) level.peak = level.rms;
+
+        window = LevelStats();
+        window_fill = 0;
+        if (level == last) return false;
+
+        last = level;
+        published.store((uint16_t)(level.rms | (level.peak << 8)), std::memory_order_relaxed);
+        return true;
+    }
+
+public:
+    void configure(unsigned sample_rate) {
+        window_samples = sample_rate * METER_WINDOW_MS / 1000;
+        if (window_samples == 0) window_samples = 1;
+        reset();
+    }
+
+    void reset() {
+        window = LevelStats();
+        window_fill = 0;
+        last = MeterLevel();
+        published.store(0, std::memory_order_relaxed);
+    }
+
+    // Capture thread. Mono samples in [-1, 1], true when level() changed.
+    bool process(const float* samples, size_t count) {
+        bool changed = false;
+        while (count > 0) {
+            size_t take = window_samples - window_fill;
+            if (take > count) take = count;
+
+            kernel(samples, take, window);
+            window_fill += (unsigned)take;
+            samples += take;
+            count -= take;
+
+            if (window_fill == window_samples && finish_window()) changed = true;
+        }
+        return changed;
+    }
+
+    // Any thread, the latest published level
+    MeterLevel level() const {
+        uint16_t packed = published.load(std::memory_order_relaxed);
+        MeterLevel result;
+        result.rms = (uint8_t)(packed & 0xFF);
+        result.peak = (uint8_t)(packed >> 8);
+        return result;
+    }
+};
+
+// Paints the meter as a vertical bar along the right edge of a top-down
+// 32-bit BGRA image with straight alpha, such as an icon's color bitmap
+inline void draw_level_bar(uint32_t* pixels, int width, int height, const MeterLevel& level) {
+    const uint32_t BACKGROUND = 0xFF303030;
+    const uint32_t LOW = 0xFF30C040;  // green
+    const uint32_t HIGH = 0xFFE03030; // red, the top step means clipping is near
+    const uint32_t TICK = 0xFFF0F0F0;
+
+    int bar_width = width / 6 < 2 ? 2 : width / 6;
+    int left = width - bar_width;
+
+    for (int y = 0; y < height; y++) {
+        // Step covering this row, counted from the bottom, 1-based
+        unsigned step = (unsigned)((height - y) * LevelMeter::LEVEL_STEPS + height - 1) / height;
+
+        uint32_t color = BACKGROUND;
+        if (step == level.peak && level.peak > level.rms) color = TICK;
+        else if (step <= level.rms) color = (step == LevelMeter::LEVEL_STEPS) ? HIGH : LOW;
+
+        for (int x = left; x < width; x++) pixels[y * width + x] = color;
+    }
+}
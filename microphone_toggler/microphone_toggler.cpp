@@ -1,21 +1,42 @@
 ﻿#include <windows.h>
-#include <mmdeviceapi.h>
-#include <endpointvolume.h>
-#include <audiopolicy.h>
 #include <commctrl.h>
 #include <shellapi.h>
 #include <mmsystem.h>
-#include <functiondiscoverykeys_devpkey.h>
 #include <fstream>
+#include <sstream>
 #include <string>
-#include <map>
 #include <iostream>
 #include <memory>
 #include <algorithm>
 #include <vector>
 #include <chrono>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 #include "resource.h"  // Required because (UN)MUTEICON is used below
+#include "audio_backend.h"
+#include "config.h"
+#include "config_parser.h"
+#include "config_watcher.h"
+#include "control_server.h"
+#include "device_cache.h"
+#include "device_registry.h"
+#include "latency_stats.h"
+#include "level_meter.h"
+#include "mock_backend.h"
+#include "mute_event_log.h"
+#include "mute_group.h"
+#include "mute_intent.h"
+#include "mute_journal.h"
+#include "rate_limiter.h"
+#include "sound_player.h"
+#include "spsc_queue.h"
+#include "structured_log.h"
+#include "voice_activity.h"
+#include "wasapi_backend.h"
+#include "win_utils.h"
 
 #pragma comment(lib, "ole32.lib")
 #pragma comment(lib, "user32.lib")
@@ -26,138 +47,197 @@
 
 // Constants
 const int WM_TRAYICON = WM_USER + 1;
+const int WM_MUTE_STATE_CHANGED = WM_USER + 2;
+const int WM_DEVICES_CHANGED = WM_USER + 3;
+const int WM_CONFIG_CHANGED = WM_USER + 4;
 const int ID_TRAY_EXIT = 1001;
 const int ID_TRAY_TOGGLE = 1002;
 const int ID_TRAY_CONFIG = 1003;
 const int ID_TRAY_RELOAD_CONFIG = 1004;
 const int ID_TRAY_LIST_DEVICES = 1005;
-const int HOTKEY_ID = 1;
-const int MAX_SOUND_VOLUME = 100;
-const int MIN_SOUND_VOLUME = 0;
-const int MIN_TOGGLE_COOLDOWN = 0;
-const int MAX_TOGGLE_COOLDOWN = 60000;
-
-// Configuration structure
-struct Config {
-    UINT hotkey_mod = MOD_CONTROL | MOD_SHIFT;
-    UINT hotkey_vk = VK_F1;
-    bool use_keyboard_hook = true; // Default to true (set to false to use RegisterHotKey method)
-    bool play_sounds = true;
-    bool unmute_on_exit = true;
-    bool use_default_device = true;
-    int sound_volume = 50; // 0-100
-    int toggle_cooldown = 1000; // Cooldown between each toggle of the program
-    std::string device_name = "";  // Specific device name to use
-    std::string mute_sound_file = "mute.wav";
-    std::string unmute_sound_file = "unmute.wav";
-    std::string config_file = "mic_config.txt";
-    std::string devices_list_file = "available_devices.txt";
+const int ID_TRAY_EXPORT_LATENCY = 1006;
+const int WM_CYCLE_DEVICE = WM_USER + 5;
+const int WM_VOICE_ACTIVITY = WM_USER + 6;
+const int WM_LEVEL_CHANGED = WM_USER + 7;
+const int WM_CONTROL_COMMAND = WM_USER + 8;
+const int WM_BACKGROUND_INIT = WM_USER + 9;
+const int MAX_HOTKEY_ID = 0xBFFF; // application hotkey ids are 0x0000-0xBFFF
+const UINT_PTR HOLD_RELEASE_TIMER_ID = 1;
+const UINT HOLD_RELEASE_POLL_MS = 5; // release latency bound without the keyboard hook
+const UINT_PTR AUTOMATIC_CHANGE_TIMER_ID = 2;
+
+// A freshly parsed config with its sounds already decoded,
+// everything slow about a reload happens while building this
+struct ConfigUpdate {
+    Config config;
+    std::vector<ConfigDiagnostic> diagnostics;
+    PcmSound sounds[SoundPlayer::SOUND_COUNT];
 };
 
-// Device information structure
-struct AudioDevice {
-    std::string id;
-    std::string name;
-    std::string description;
-    bool is_default;
-    bool is_enabled;
+std::unique_ptr<AudioBackend> create_audio_backend(const std::string& name) {
+    if (name == "wasapi") return std::make_unique<WasapiAudioBackend>();
+    if (name == "mock") return std::make_unique<MockAudioBackend>();
+    return nullptr;
+}
+
+// Startup work the hotkey does not wait for, done on a thread of its own
+// and handed to the UI thread. Results for a backend or sound settings that
+// were replaced in the meantime are dropped.
+struct BackgroundInit {
+    bool startup = false;
+    uint64_t backend_generation = 0;
+    uint64_t sounds_generation = 0;
+    bool scanned = false;
+    std::vector<AudioDevice> devices;
+    bool decoded = false;
+    PcmSound sounds[SoundPlayer::SOUND_COUNT];
+    uint64_t scan_ns = 0;
+    uint64_t decode_ns = 0;
 };
 
-// RAII wrapper for COM interfaces
-template<typename T>
-class ComPtr {
-private:
-    T* ptr;
-
-public:
-    ComPtr() : ptr(nullptr) {}
-    ComPtr(T* p) : ptr(p) {}
-    ~ComPtr() { Release(); }
-
-    // Move constructor
-    ComPtr(ComPtr&& other) noexcept : ptr(other.ptr) {
-        other.ptr = nullptr;
-    }
-
-    // Move assignment
-    ComPtr& operator=(ComPtr&& other) noexcept {
-        if (this != &other) {
-            Release();
-            ptr = other.ptr;
-            other.ptr = nullptr;
-        }
-        return *this;
-    }
-
-    // Disable copy
-    ComPtr(const ComPtr&) = delete;
-    ComPtr& operator=(const ComPtr&) = delete;
-
-    void Release() {
-        if (ptr) {
-            ptr->Release();
-            ptr = nullptr;
-        }
-    }
-
-    T* Get() const { return ptr; }
-    T** GetAddressOf() { Release(); return &ptr; }
-    T* operator->() const { return ptr; }
-    operator bool() const { return ptr != nullptr; }
+struct MuteRequest {
+    MuteIntent intent;
+    MuteSource source;
+    LatencyRecorder::TraceId trace; // 0 when the request is not timed
 };
 
 class MicrophoneController {
 private:
-    HWND main_hwnd;
+    std::atomic<HWND> main_hwnd; // read by the mute worker and endpoint callbacks
     NOTIFYICONDATA notification_icon_data;
-    ComPtr<IMMDeviceEnumerator> device_enumerator;
-    ComPtr<IMMDevice> current_device;
-    ComPtr<IAudioEndpointVolume> endpoint_volume;
-    bool is_muted;
+    std::unique_ptr<AudioBackend> audio_backend;
+    MuteGroup mute_group; // the controlled devices, endpoints owned by device_registry's cache
+    DeviceRegistry device_registry;
+    size_t group_missing_devices = 0; // configured but not currently present
+    bool target_uses_default = false;
+    std::atomic<size_t> failed_devices{ 0 }; // from the last toggle
+
+    // Tray state prebuilt for both mute states whenever the device changes,
+    // so a toggle never loads icons or formats strings. Index 1 = muted.
+    static const size_t TOOLTIP_CAPACITY = sizeof(NOTIFYICONDATA::szTip) / sizeof(WCHAR);
+    HICON tray_icons[2] = {};
+    WCHAR tray_tooltips[2][TOOLTIP_CAPACITY] = {};
+    std::atomic<bool> is_muted;
     bool initial_mute_state;
     Config config;
     bool com_initialized;
-    bool hotkey_registered;
     bool tray_icon_added;
     HHOOK keyboard_hook = nullptr;
-    bool use_keyboard_hook = false;
-    DWORD sound_flags;
-    std::vector<AudioDevice> available_devices;
+    SoundPlayer sound_player;
     std::string current_device_name;
 
+    // Mute worker: SetMute, sounds and tray updates never run on the hook thread
+    SpscQueue<MuteRequest, 64> mute_requests;
+    std::thread mute_worker;
+    HANDLE mute_worker_wake = nullptr;
+    std::atomic<bool> mute_worker_stop{ false };
+
+    // Per-stage toggle timings, traces are completed on the UI thread
+    LatencyRecorder latency;
+    bool dump_latency_on_exit = false;
+
+    // Config file edits are parsed on the watcher thread, applied on the UI thread
+    ConfigWatcher config_watcher;
+    std::mutex config_update_mutex;
+    std::unique_ptr<ConfigUpdate> pending_config_update;
+
+    // Hotkeys are matched in the keyboard hook, or registered one by one with RegisterHotKey
+    struct HotkeyBinding {
+        HotkeyChord chord;
+        HotkeyAction action;
+    };
+    struct RegisteredHotkey {
+        int id;
+        HotkeyChord chord;
+        HotkeyAction action;
+    };
+    HotkeyMatcher hotkey_matcher;
+    std::vector<RegisteredHotkey> registered_hotkeys;
+    int next_hotkey_id = 1;
+
+    // Push-to-talk state, UI thread only. RegisterHotKey reports no key-up,
+    // so a held key is polled for its release on a short timer instead.
+    HoldStateMachine hold_state;
+    HotkeyChord polled_hold_chord;
+    HotkeyAction polled_hold_action = HotkeyAction::None;
+
+    // Voice activity and the level meter share one stream of the first target
+    // device. Both run on the capture thread and post only when something changed.
+    std::unique_ptr<CaptureStream> capture_stream;
+    VoiceActivityDetector voice_detector;
+    LevelMeter level_meter;
+    std::atomic<bool> level_post_pending{ false }; // one WM_LEVEL_CHANGED in flight at most
+    bool level_meter_active = false;
+
+    // Scripts talk to this, commands are posted over to the UI thread
+    ControlServer control_server;
+
+    // Headless runs (--headless) have no tray icon and no dialogs, the log is
+    // the only place problems show up. --log keeps one next to the tray too.
+    bool headless = false;
+    StructuredLog log;
+    StartupTrace startup_trace;
+
+    // Full device enumeration and sound decoding run after startup, see BackgroundInit
+    std::thread background_init;
+    std::mutex background_mutex;
+    std::unique_ptr<BackgroundInit> background_result;
+    uint64_t backend_generation = 0; // bumped for every new backend
+    uint64_t sounds_generation = 0;  // bumped whenever sounds are installed
+
+    // Devices from the last run, mapped until the full enumeration lands
+    MappedFile device_cache_mapping;
+    DeviceCacheView device_cache;
+    // Endpoint id each configured device name was bound to, so a device
+    // renamed by Windows keeps its binding for the rest of the run
+    std::unordered_map<std::string, std::string> resolved_ids;
+
+    // What the devices were and are, for the start after a crash, see mute_journal.h
+    WritableMapping mute_journal_mapping;
+    MuteJournal mute_journal;
+    std::unordered_map<std::string, bool> original_mute; // by endpoint id, as first seen
+
+    // Every change of every device with its source, see mute_event_log.h
+    WritableMapping event_log_mapping;
+    MuteEventLog event_log;
+
+    // Meter icons, drawn once per mute state and quantized level, then reused.
+    // The plain icons are read once when the meter starts, a new level only
+    // copies them into its bitmap and paints the bar.
+    HICON level_icons[2][LevelMeter::LEVEL_STEPS + 1][LevelMeter::LEVEL_STEPS + 1] = {};
+    struct IconPixels {
+        std::vector<uint32_t> pixels; // top-down, with alpha
+        int width = 0;
+        int height = 0;
+    };
+    IconPixels level_icon_bases[2];
+    RateLimiter rate_limiter; // by MuteSource, the hook thread checks it too
+    MuteIntent pending_automatic = MuteIntent::Toggle; // waiting for the voice bucket
+    bool automatic_pending = false;
+    std::wstring config_problems; // from the startup load, shown once the tray exists
+    std::mutex audio_mutex; // guards mute_group and config against the worker
+    bool mute_events_active = false; // is_muted follows endpoint notifications
+
+    // Device notifications arrive on a backend thread and are applied on the UI thread
+    std::mutex device_events_mutex;
+    std::vector<std::pair<DeviceEvent, std::string>> pending_device_events;
+
+    // Resolved once when the hook is installed, read by keyboard_hook_proc
+    static std::atomic<MicrophoneController*> hook_controller;
+
 public:
     MicrophoneController() : main_hwnd(nullptr),
+        mute_group([] { CoInitializeEx(nullptr, COINIT_MULTITHREADED); }, [] { CoUninitialize(); }),
         is_muted(false), initial_mute_state(false),
-        com_initialized(false), hotkey_registered(false),
+        com_initialized(false),
         tray_icon_added(false) {
         memset(&notification_icon_data, 0, sizeof(NOTIFYICONDATA));
-
-        // Pre-calculate sound flags for better performance
-        sound_flags = SND_FILENAME | SND_ASYNC | SND_NODEFAULT | SND_NOSTOP;
     }
 
     ~MicrophoneController() {
         cleanup();
     }
 
-    std::string wstring_to_string(const std::wstring& wstr) {
-        if (wstr.empty()) return std::string();
-
-        int size = WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), -1, nullptr, 0, nullptr, nullptr);
-        std::string result(size - 1, 0);
-        WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), -1, &result[0], size, nullptr, nullptr);
-        return result;
-    }
-
-    std::wstring string_to_wstring(const std::string& str) {
-        if (str.empty()) return std::wstring();
-
-        int size = MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, nullptr, 0);
-        std::wstring result(size - 1, 0);
-        MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, &result[0], size);
-        return result;
-    }
-
     bool initialize_system() {
         // Initialize COM with better error handling
         HRESULT hr = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE);
@@ -165,199 +245,414 @@ public:
             return false;
         }
         com_initialized = true;
+        return true;
+    }
 
-        // Initialize common controls (only what we need)
+    // Nothing on the startup path needs these, done once the hotkey is live
+    void initialize_common_controls() {
         INITCOMMONCONTROLSEX icex;
         icex.dwSize = sizeof(INITCOMMONCONTROLSEX);
         icex.dwICC = ICC_WIN95_CLASSES;
-        if (!InitCommonControlsEx(&icex)) {
+        InitCommonControlsEx(&icex);
+    }
+
+    bool ensure_audio_backend() {
+        if (audio_backend) return true;
+
+        audio_backend = create_audio_backend(config.audio_backend);
+        if (!audio_backend) {
+            // Unknown backend name in config, fall back to the platform one
+            audio_backend = create_audio_backend("wasapi");
+        }
+        if (!audio_backend->initialize()) {
+            audio_backend.reset();
             return false;
         }
 
+        // Subscribe before the full enumeration so no hot-plug is missed.
+        // The enumeration itself is left to the background scan, or to the
+        // first lookup by name, whichever comes first.
+        audio_backend->subscribe_devices([this](DeviceEvent event, const std::string& id) {
+            on_device_event(event, id);
+        });
+        device_registry.attach(audio_backend.get());
+        backend_generation++;
         return true;
     }
 
     std::vector<AudioDevice> enumerate_audio_devices() {
-        std::vector<AudioDevice> devices;
+        if (!ensure_audio_backend()) return {};
+        if (!device_registry.is_populated()) device_registry.populate();
+        return device_registry.devices();
+    }
+
+    // Decodes the sounds and enumerates the devices on another backend
+    // instance, then posts WM_BACKGROUND_INIT. Replaces a run in progress.
+    void start_background_init(bool startup, bool scan, bool decode) {
+        join_background_init();
+        finish_background_init(); // a result not picked up yet
+
+        auto work = std::make_unique<BackgroundInit>();
+        work->startup = startup;
+        work->backend_generation = backend_generation;
+        work->sounds_generation = sounds_generation;
+        Config settings = config; // the thread never reads config itself
+        std::string backend_name = audio_backend ? audio_backend->name() : config.audio_backend;
+
+        background_init = std::thread([this, scan, decode, settings, backend_name, work = std::move(work)]() mutable {
+            if (decode && settings.play_sounds && settings.sound_volume > MIN_SOUND_VOLUME) {
+                uint64_t start = latency_now_ns();
+                float gain = volume_to_gain(settings.sound_volume);
+                SoundPlayer::decode(settings.mute_sound_file, gain, work->sounds[SoundPlayer::MUTE_SOUND]);
+                SoundPlayer::decode(settings.unmute_sound_file, gain, work->sounds[SoundPlayer::UNMUTE_SOUND]);
+                work->decoded = true;
+                work->decode_ns = latency_now_ns() - start;
+            }
+
+            if (scan) {
+                uint64_t start = latency_now_ns();
+                HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+                {
+                    std::unique_ptr<AudioBackend> backend = create_audio_backend(backend_name);
+                    if (backend && backend->initialize()) {
+                        work->devices = backend->enumerate_devices();
+                        work->scanned = true;
+                    }
+                }
+                if (SUCCEEDED(hr)) CoUninitialize();
+                work->scan_ns = latency_now_ns() - start;
+            }
 
-        if (!device_enumerator) {
-            HRESULT hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL,
-                __uuidof(IMMDeviceEnumerator), (void**)device_enumerator.GetAddressOf());
-            if (FAILED(hr)) return devices;
+            {
+                std::lock_guard<std::mutex> lock(background_mutex);
+                background_result = std::move(work);
+            }
+            HWND hwnd = main_hwnd;
+            if (hwnd) PostMessage(hwnd, WM_BACKGROUND_INIT, 0, 0);
+        });
+    }
+
+    void join_background_init() {
+        if (background_init.joinable()) background_init.join();
+    }
+
+    // UI thread
+    void finish_background_init() {
+        std::unique_ptr<BackgroundInit> work;
+        {
+            std::lock_guard<std::mutex> lock(background_mutex);
+            work.swap(background_result);
         }
+        if (!work) return;
 
-        ComPtr<IMMDeviceCollection> device_collection;
-        HRESULT hr = device_enumerator->EnumAudioEndpoints(eCapture, DEVICE_STATE_ACTIVE, device_collection.GetAddressOf());
-        if (FAILED(hr)) return devices;
+        if (work->decoded && work->sounds_generation == sounds_generation) {
+            std::lock_guard<std::mutex> lock(audio_mutex);
+            install_sounds(work->sounds);
+        }
 
-        // Get default device for comparison
-        ComPtr<IMMDevice> default_device;
-        device_enumerator->GetDefaultAudioEndpoint(eCapture, eConsole, default_device.GetAddressOf());
+        if (audio_backend && work->backend_generation == backend_generation) {
+            // Populated on demand in the meantime and kept current by device
+            // events since, the scan is older than that and is dropped
+            if (!device_registry.is_populated()) {
+                if (work->scanned) device_registry.adopt(std::move(work->devices));
+                else device_registry.populate(); // scan failed, try here
+            }
+            save_device_cache();
+        }
 
-        UINT count;
-        device_collection->GetCount(&count);
+        if (work->startup) {
+            initialize_common_controls();
+            restart_capture();
+        }
 
-        for (UINT i = 0; i < count; i++) {
-            ComPtr<IMMDevice> device;
-            if (SUCCEEDED(device_collection->Item(i, device.GetAddressOf()))) {
-                AudioDevice audio_device;
+        // Replays the device events held back while the list was partial
+        process_device_events();
 
-                // Get device ID
-                LPWSTR device_id;
-                if (SUCCEEDED(device->GetId(&device_id))) {
-                    audio_device.id = wstring_to_string(device_id);
-                    CoTaskMemFree(device_id);
-                }
+        char scan_ms[32], decode_ms[32];
+        snprintf(scan_ms, sizeof(scan_ms), "%.2f", work->scan_ns / 1e6);
+        snprintf(decode_ms, sizeof(decode_ms), "%.2f", work->decode_ns / 1e6);
+        log.write(LogLevel::Info, "background_init", {
+            { "devices", std::to_string(device_registry.devices().size()) },
+            { "scan_ms", scan_ms },
+            { "sounds_ms", decode_ms } });
+    }
 
-                // Get device properties
-                ComPtr<IPropertyStore> property_store;
-                if (SUCCEEDED(device->OpenPropertyStore(STGM_READ, property_store.GetAddressOf()))) {
-                    PROPVARIANT prop_var;
-                    PropVariantInit(&prop_var);
-
-                    // Get friendly name
-                    if (SUCCEEDED(property_store->GetValue(PKEY_Device_FriendlyName, &prop_var))) {
-                        if (prop_var.vt == VT_LPWSTR) {
-                            audio_device.name = wstring_to_string(prop_var.pwszVal);
-                        }
-                        PropVariantClear(&prop_var);
-                    }
+    // Called from a backend thread
+    void on_device_event(DeviceEvent event, const std::string& id) {
+        {
+            std::lock_guard<std::mutex> lock(device_events_mutex);
+            pending_device_events.emplace_back(event, id);
+        }
 
-                    // Get device description
-                    if (SUCCEEDED(property_store->GetValue(PKEY_Device_DeviceDesc, &prop_var))) {
-                        if (prop_var.vt == VT_LPWSTR) {
-                            audio_device.description = wstring_to_string(prop_var.pwszVal);
-                        }
-                        PropVariantClear(&prop_var);
-                    }
-                }
+        HWND hwnd = main_hwnd;
+        if (hwnd) PostMessage(hwnd, WM_DEVICES_CHANGED, 0, 0);
+    }
 
-                // Check if this is the default device
-                audio_device.is_default = false;
-                if (default_device) {
-                    LPWSTR default_id;
-                    if (SUCCEEDED(default_device->GetId(&default_id))) {
-                        audio_device.is_default = (audio_device.id == wstring_to_string(default_id));
-                        CoTaskMemFree(default_id);
-                    }
-                }
+    // UI thread: keep the registry current and re-bind the target device
+    // when it disappears, comes back or the default changes
+    void process_device_events() {
+        // Held back until the full list has landed, the scan may predate them
+        if (!device_registry.is_populated()) return;
 
-                // Check device state
-                DWORD state;
-                audio_device.is_enabled = SUCCEEDED(device->GetState(&state)) && (state == DEVICE_STATE_ACTIVE);
+        std::vector<std::pair<DeviceEvent, std::string>> events;
+        {
+            std::lock_guard<std::mutex> lock(device_events_mutex);
+            events.swap(pending_device_events);
+        }
 
-                devices.push_back(audio_device);
+        bool reselect = false;
+        bool listed = false;
+        for (const auto& event : events) {
+            if (!device_registry.apply_event(event.first, event.second)) continue;
+            listed = true;
+
+            bool target_lost = mute_group.contains(event.second) && !device_registry.find(event.second);
+            bool default_moved = target_uses_default && event.first == DeviceEvent::DefaultChanged;
+            bool incomplete = mute_group.empty() || group_missing_devices > 0;
+            if (incomplete || target_lost || default_moved) {
+                reselect = true;
             }
         }
 
-        return devices;
+        publish_device_list(); // names, defaults and additions, even without a reselect
+        if (!reselect) {
+            if (listed) save_device_cache();
+            return;
+        }
+
+        bool device_ready;
+        {
+            std::lock_guard<std::mutex> lock(audio_mutex);
+            device_ready = find_and_set_target_device();
+        }
+        if (!device_ready) {
+            current_device_name = "No device connected";
+        }
+        refresh_tray_device();
+        restart_capture();
+        save_device_cache();
+    }
+
+    void open_device_cache() {
+        if (device_cache_mapping.open(config.device_cache_file) &&
+            device_cache.open(device_cache_mapping.data(), device_cache_mapping.size())) {
+            return;
+        }
+        close_device_cache(); // missing, or from another version
     }
 
+    void close_device_cache() {
+        device_cache.close();
+        device_cache_mapping.close();
+    }
+
+    // Full list and targets, for the next startup. Needs the enumeration.
+    bool save_device_cache() {
+        if (!device_registry.is_populated()) return false;
+
+        DeviceCacheContents contents;
+        contents.devices = device_registry.devices();
+        for (const auto& binding : resolved_ids) {
+            if (mute_group.contains(binding.second)) contents.targets.push_back({ binding.second, binding.first });
+        }
+
+        close_device_cache(); // a mapped file cannot be replaced
+        return write_file_atomically(config.device_cache_file, encode_device_cache(contents));
+    }
+
+    // available_devices.txt, generated from the cache on request
     void save_devices_list() {
-        available_devices = enumerate_audio_devices();
+        enumerate_audio_devices();
+        save_device_cache();
 
-        std::ofstream file(config.devices_list_file);
-        if (file.is_open()) {
-            file << "=== AVAILABLE AUDIO INPUT DEVICES ===\n\n";
-            file << "Copy the exact device name (including spaces and special characters) to your config file.\n";
-            file << "Use the 'device_name' setting in " << config.config_file << "\n\n";
+        MappedFile mapping;
+        DeviceCacheView cache;
+        std::vector<AudioDevice> devices;
+        if (mapping.open(config.device_cache_file) && cache.open(mapping.data(), mapping.size())) {
+            devices = cache.devices();
+        }
+        else {
+            devices = device_registry.devices(); // cache not writable, list what we have
+        }
+        write_file_atomically(config.devices_list_file, format_device_list(devices, config.config_file));
+    }
 
-            if (available_devices.empty()) {
-                file << "No active audio input devices found!\n";
-                file << "Make sure your microphone is connected and enabled.\n";
-            }
-            else {
-                for (size_t i = 0; i < available_devices.size(); i++) {
-                    const auto& device = available_devices[i];
-                    file << "Device " << (i + 1) << ":\n";
-                    file << "  Name: " << device.name << "\n";
-                    file << "  Description: " << device.description << "\n";
-                    file << "  Status: " << (device.is_enabled ? "Active" : "Inactive") << "\n";
-                    file << "  Default: " << (device.is_default ? "Yes" : "No") << "\n";
-                    file << "\n";
-
-                    if (device.is_default) {
-                        file << "  *** This is your system's default microphone ***\n\n";
-                    }
-                }
+    // Splits device_group on ';' and trims each name
+    static std::vector<std::string> split_device_group(const std::string& group) {
+        std::vector<std::string> names;
+        size_t start = 0;
+        while (start <= group.size()) {
+            size_t end = group.find(';', start);
+            if (end == std::string::npos) end = group.size();
 
-                file << "=== CONFIGURATION INSTRUCTIONS ===\n\n";
-                file << "To use a specific device:\n";
-                file << "1. Open " << config.config_file << "\n";
-                file << "2. Set 'use_default_device = false'\n";
-                file << "3. Set 'device_name = [exact device name from above]'\n\n";
-                file << "Example:\n";
-                file << "use_default_device = false\n";
-                if (!available_devices.empty()) {
-                    file << "device_name = " << available_devices[0].name << "\n";
-                }
-            }
+            std::string name = group.substr(start, end - start);
+            name.erase(0, name.find_first_not_of(" \t"));
+            name.erase(name.find_last_not_of(" \t") + 1);
+            if (!name.empty()) names.push_back(name);
+
+            start = end + 1;
         }
+        return names;
     }
 
-    bool find_and_set_target_device() {
-        if (!device_enumerator) {
-            HRESULT hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL,
-                __uuidof(IMMDeviceEnumerator), (void**)device_enumerator.GetAddressOf());
-            if (FAILED(hr)) return false;
+    static const char* device_match_name(DeviceMatchKind kind) {
+        switch (kind) {
+        case DeviceMatchKind::Exact: return "exact";
+        case DeviceMatchKind::Normalized: return "normalized";
+        case DeviceMatchKind::Similar: return "similar";
+        default: return "none";
+        }
+    }
+
+    // A configured name is tried as an endpoint id ("{0.0.1.00000000}.{...}"),
+    // then as the device it was bound to before (this run or the cache, even
+    // if renamed since), then by name through the registry's index
+    const AudioDevice* resolve_device_name(const std::string& name) {
+        auto usable = [](const AudioDevice* device) { return device && device->is_enabled ? device : nullptr; };
+
+        if (name[0] == '{') {
+            if (const AudioDevice* device = usable(device_registry.describe(name))) return device;
         }
 
-        current_device.Release();
-        endpoint_volume.Release();
+        std::string remembered;
+        auto it = resolved_ids.find(name);
+        if (it != resolved_ids.end()) remembered = it->second;
+        else if (device_cache.is_open()) remembered = std::string(device_cache.find_id_by_name(name));
+        if (!remembered.empty()) {
+            if (const AudioDevice* device = usable(device_registry.describe(remembered))) return device;
+        }
 
-        if (config.use_default_device) {
-            // Use default device
-            HRESULT hr = device_enumerator->GetDefaultAudioEndpoint(eCapture, eConsole, current_device.GetAddressOf());
-            if (FAILED(hr)) return false;
+        DeviceNameIndex::Match match;
+        const AudioDevice* device = device_registry.find_by_name(name, &match);
+        if (device && match.kind != DeviceMatchKind::Exact) {
+            log.write(LogLevel::Warning, "device_name_matched", {
+                { "configured", name },
+                { "device", device->name },
+                { "match", device_match_name(match.kind) },
+                { "similarity", std::to_string(match.similarity) } });
+        }
+        return device;
+    }
 
-            current_device_name = "Default Device";
+    // "default" stands for the system default capture device
+    bool add_target_device(const std::string& name) {
+        std::string device_id;
+        std::string display_name;
+        if (name == "default") {
+            device_id = device_registry.get_default_id();
+            display_name = "Default Device";
+            target_uses_default = true;
         }
         else {
-            // Find specific device by name
-            if (config.device_name.empty()) {
-                return false; // No device name specified
-            }
+            const AudioDevice* device = resolve_device_name(name);
+            if (!device) return false;
+            device_id = device->id;
+            display_name = device->name;
+            resolved_ids[name] = device_id;
+        }
 
-            available_devices = enumerate_audio_devices();
-            bool device_found = false;
-
-            for (const auto& device : available_devices) {
-                if (device.name == config.device_name && device.is_enabled) {
-                    // Get the device by ID
-                    std::wstring device_id_wide = string_to_wstring(device.id);
-                    HRESULT hr = device_enumerator->GetDevice(device_id_wide.c_str(), current_device.GetAddressOf());
-                    if (SUCCEEDED(hr)) {
-                        current_device_name = device.name;
-                        device_found = true;
-                        break;
-                    }
-                }
-            }
+        auto endpoint = device_registry.acquire(device_id);
+        if (!endpoint) return false;
 
-            if (!device_found) {
+        // Get initial mute state
+        bool muted;
+        if (!endpoint->get_mute(muted)) {
+            // Cached handle went stale (device was replugged), reopen once
+            device_registry.invalidate(device_id);
+            endpoint = device_registry.acquire(device_id);
+            if (!endpoint || !endpoint->get_mute(muted)) {
                 return false;
             }
         }
 
-        // Get endpoint volume interface
-        HRESULT hr = current_device->Activate(__uuidof(IAudioEndpointVolume), CLSCTX_ALL,
-            nullptr, (void**)endpoint_volume.GetAddressOf());
-        if (FAILED(hr)) return false;
+        mute_group.add(std::move(endpoint), display_name, muted);
+        return true;
+    }
 
-        // Get initial mute state and store it
-        BOOL muted;
-        hr = endpoint_volume->GetMute(&muted);
-        if (FAILED(hr)) return false;
+    bool find_and_set_target_device() {
+        if (!ensure_audio_backend()) return false;
+
+        // Cached endpoints outlive the selection, clear() stops listening on them
+        mute_group.clear();
+        mute_events_active = false;
+        group_missing_devices = 0;
+        target_uses_default = false;
+        failed_devices = 0;
+
+        std::vector<std::string> names;
+        if (!config.device_group.empty()) {
+            names = split_device_group(config.device_group);
+        }
+        else if (config.use_default_device) {
+            names.push_back("default");
+        }
+        else if (!config.device_name.empty()) {
+            names.push_back(config.device_name);
+        }
+
+        for (const auto& name : names) {
+            if (!add_target_device(name)) group_missing_devices++;
+        }
+        bind_mute_journal();
+        if (mute_group.empty()) return false; // none found, or no device name specified
+
+        if (names.size() == 1) {
+            current_device_name = mute_group.name(0);
+        }
+        else {
+            current_device_name = "Group: " + std::to_string(mute_group.size()) + "/" +
+                std::to_string(names.size()) + " devices";
+        }
 
-        is_muted = muted;
-        initial_mute_state = muted;
+        // Store initial mute state
+        is_muted = mute_group.all_muted();
+        initial_mute_state = is_muted;
+
+        // Track changes made by other applications (Discord, Windows mixer, ...)
+        mute_events_active = true;
+        for (size_t i = 0; i < mute_group.size(); i++) {
+            bool subscribed = mute_group.endpoint(i).subscribe([this, i](bool now_muted, bool self_initiated) {
+                on_endpoint_mute_changed(i, now_muted, self_initiated);
+            });
+            mute_events_active = mute_events_active && subscribed;
+        }
 
         return true;
     }
 
+    // Called from a backend thread, must not take audio_mutex
+    void on_endpoint_mute_changed(size_t index, bool muted, bool self_initiated) {
+        bool was_muted = mute_group.is_member_muted(index);
+        mute_group.note_mute(index, muted);
+        mute_journal.note(index, muted);
+        if (!self_initiated && was_muted != muted) {
+            log_mute_event(index, was_muted, muted, MuteSource::External);
+        }
+        is_muted = mute_group.all_muted();
+
+        // Our own changes are already reported by the mute worker
+        HWND hwnd = main_hwnd;
+        if (!self_initiated && hwnd) {
+            PostMessage(hwnd, WM_MUTE_STATE_CHANGED, is_muted, 0);
+        }
+    }
+
     bool initialize_audio() {
         if (!find_and_set_target_device()) {
-            if (!config.use_default_device && !config.device_name.empty()) {
+            if (!config.device_group.empty()) {
+                // None of the group members were found
+                save_devices_list();
+
+                std::wstring error_msg = L"Could not find any device listed in device_group: '";
+                error_msg += string_to_wstring(config.device_group);
+                error_msg += L"'\n\nA list of available devices has been saved to '";
+                error_msg += string_to_wstring(config.devices_list_file);
+                error_msg += L"'.\n\nPlease check this file and update your configuration.";
+
+                report(LogLevel::Error, "group_not_found", L"Device Not Found", error_msg, MB_ICONWARNING);
+                return false;
+            }
+            else if (!config.use_default_device && !config.device_name.empty()) {
                 // Specific device not found, save device list for user
                 save_devices_list();
 
@@ -367,7 +662,7 @@ public:
                 error_msg += string_to_wstring(config.devices_list_file);
                 error_msg += L"'.\n\nPlease check this file and update your configuration.";
 
-                MessageBox(nullptr, error_msg.c_str(), L"Device Not Found", MB_OK | MB_ICONWARNING);
+                report(LogLevel::Error, "device_not_found", L"Device Not Found", error_msg, MB_ICONWARNING);
                 return false;
             }
             else if (!config.use_default_device && config.device_name.empty()) {
@@ -379,7 +674,7 @@ public:
                 error_msg += string_to_wstring(config.devices_list_file);
                 error_msg += L"'.\n\nPlease choose a device from the list and update your configuration.";
 
-                MessageBox(nullptr, error_msg.c_str(), L"Configuration Required", MB_OK | MB_ICONINFORMATION);
+                report(LogLevel::Error, "device_not_configured", L"Configuration Required", error_msg, MB_ICONINFORMATION);
                 return false;
             }
             else {
@@ -395,7 +690,7 @@ public:
                 error_msg += string_to_wstring(config.devices_list_file);
                 error_msg += L"' for reference.";
 
-                MessageBox(nullptr, error_msg.c_str(), L"Audio System Error", MB_OK | MB_ICONSTOP);
+                report(LogLevel::Error, "default_device_unavailable", L"Audio System Error", error_msg, MB_ICONSTOP);
                 return false;
             }
         }
@@ -404,68 +699,58 @@ public:
     }
 
     void load_config() {
-        std::ifstream file(config.config_file);
-        if (!file.is_open()) {
+        std::vector<ConfigDiagnostic> diagnostics;
+        if (!read_config_file(config.config_file, config, diagnostics)) {
             save_config(); // Create default config
-            return;
         }
+        config_problems = format_config_diagnostics(config.config_file, diagnostics);
+    }
 
-        std::string line;
-        std::map<std::string, std::string> settings;
-
-        while (std::getline(file, line)) {
-            // Trim whitespace
-            line.erase(0, line.find_first_not_of(" \t\r\n"));
-            line.erase(line.find_last_not_of(" \t\r\n") + 1);
-
-            // Skip comments and empty lines
-            if (line.empty() || line[0] == '#' || line[0] == '=') continue;
-
-            size_t pos = line.find('=');
-            if (pos != std::string::npos) {
-                std::string key = line.substr(0, pos);
-                std::string value = line.substr(pos + 1);
-
-                // Trim key and value
-                key.erase(key.find_last_not_of(" \t") + 1);
-                value.erase(0, value.find_first_not_of(" \t"));
-                value.erase(value.find_last_not_of(" \t") + 1);
-
-                settings[key] = value;
-            }
+    // Overlays the settings found in the file onto config, any thread.
+    // Invalid values are reported and skipped, they never drop other settings.
+    static bool read_config_file(const std::string& path, Config& config,
+        std::vector<ConfigDiagnostic>& diagnostics) {
+        std::string text;
+        if (!read_text_file(path, text)) {
+            return false;
         }
 
-        // Parse settings with validation
-        try {
-            auto parse_bool = [](const std::string& val) {
-                std::string lower;
-                lower.reserve(val.size());
-                std::transform(val.begin(), val.end(), std::back_inserter(lower), ::tolower);
-                return (lower == "1" || lower == "true" || lower == "yes" || lower == "on");
-                };
-
-            auto parse_uint = [](const std::string& val) { return std::stoul(val); };
-            auto parse_int_clamped = [](const std::string& val, int min, int max) {
-                return max(min, min(max, std::stoi(val)));
-                };
+        parse_config_entries(text, [&](const ConfigEntry& entry) {
+            apply_config_entry(entry, config, diagnostics);
+        });
+        return true;
+    }
 
-            const auto& s = settings; // alias for brevity
+    // "file:line:column: problem" lines for a dialog or tray balloon
+    static std::wstring format_config_diagnostics(const std::string& path,
+        const std::vector<ConfigDiagnostic>& diagnostics) {
+        const size_t MAX_SHOWN = 4;
 
-            if (s.find("hotkey_mod") != s.end()) config.hotkey_mod = parse_uint(s.at("hotkey_mod"));
-            if (s.find("hotkey_vk") != s.end()) config.hotkey_vk = parse_uint(s.at("hotkey_vk"));
-            if (s.find("toggle_cooldown") != s.end()) config.toggle_cooldown = parse_int_clamped(s.at("toggle_cooldown"), MIN_TOGGLE_COOLDOWN, MAX_TOGGLE_COOLDOWN);
-            if (s.find("use_keyboard_hook") != s.end()) config.use_keyboard_hook = parse_bool(s.at("use_keyboard_hook"));
-            if (s.find("play_sounds") != s.end()) config.play_sounds = parse_bool(s.at("play_sounds"));
-            if (s.find("unmute_on_exit") != s.end()) config.unmute_on_exit = parse_bool(s.at("unmute_on_exit"));
-            if (s.find("use_default_device") != s.end()) config.use_default_device = parse_bool(s.at("use_default_device"));
-            if (s.find("sound_volume") != s.end()) config.sound_volume = parse_int_clamped(s.at("sound_volume"), MIN_SOUND_VOLUME, MAX_SOUND_VOLUME);
-            if (s.find("device_name") != s.end()) config.device_name = s.at("device_name");
-            if (s.find("mute_sound_file") != s.end()) config.mute_sound_file = s.at("mute_sound_file");
-            if (s.find("unmute_sound_file") != s.end()) config.unmute_sound_file = s.at("unmute_sound_file");
+        std::wstring text;
+        for (size_t i = 0; i < diagnostics.size() && i < MAX_SHOWN; i++) {
+            const ConfigDiagnostic& d = diagnostics[i];
+            text += string_to_wstring(path + ":" + std::to_string(d.line) + ":" +
+                std::to_string(d.column) + ": " + d.message) + L"\n";
+        }
+        if (diagnostics.size() > MAX_SHOWN) {
+            text += L"... and " + std::to_wstring(diagnostics.size() - MAX_SHOWN) + L" more\n";
         }
-        catch (const std::exception&) {
-            // If parsing fails, keep default values
+        return text;
+    }
+
+    // Watcher thread or UI thread, touches no controller state
+    static bool build_config_update(const std::string& path, ConfigUpdate& update) {
+        update.config = Config();
+        update.config.config_file = path;
+        if (!read_config_file(path, update.config, update.diagnostics)) return false;
+
+        const Config& c = update.config;
+        if (c.play_sounds && c.sound_volume > MIN_SOUND_VOLUME) {
+            float gain = volume_to_gain(c.sound_volume);
+            SoundPlayer::decode(c.mute_sound_file, gain, update.sounds[SoundPlayer::MUTE_SOUND]);
+            SoundPlayer::decode(c.unmute_sound_file, gain, update.sounds[SoundPlayer::UNMUTE_SOUND]);
         }
+        return true;
     }
 
     void save_config() {
@@ -478,51 +763,7 @@ public:
             file << "# Lines starting with # are comments\n";
             file << "# Boolean values: true/false, yes/no, 1/0, on/off\n\n";
 
-            file << "=== DEVICE SELECTION ===\n\n";
-            file << "# Use system default microphone device\n";
-            file << "use_default_device = " << (config.use_default_device ? "true" : "false") << "\n\n";
-
-            file << "# Specific device name (only used if use_default_device = false)\n";
-            file << "# Run the program to generate '" << config.devices_list_file << "' with available devices\n";
-            file << "# Copy the exact device name from that file\n";
-            file << "device_name = " << config.device_name << "\n\n";
-
-            file << "=== HOTKEY CONFIGURATION ===\n\n";
-            file << "# Hotkey modifier keys (can be combined by adding values):\n";
-            file << "#   Alt = 1, Control = 2, Shift = 4, Windows Key = 8\n";
-            file << "#   Examples: Control+Shift = 6, Alt+Control = 3, Shift only = 4\n";
-            file << "hotkey_mod = " << config.hotkey_mod << "\n\n";
-
-            file << "# Main key for hotkey (virtual key codes):\n";
-            file << "#   Function keys: F1=112, F2=113, F3=114, ..., F12=123\n";
-            file << "#   Letters: A=65, B=66, C=67, ..., Z=90\n";
-            file << "#   Numbers: 0=48, 1=49, 2=50, ..., 9=57\n";
-            file << "#   Other: Space=32, Enter=13, Tab=9\n";
-            file << "hotkey_vk = " << config.hotkey_vk << "\n\n";
-
-            file << "# Cooldown for toggling the microphone (0-60000, 0=none, 500=half a second, 1000=second)\n";
-            file << "toggle_cooldown = " << config.toggle_cooldown << "\n\n";
-
-            file << "# Use low-level keyboard hook for more reliable hotkey detection\n";
-            file << "# (May work better in some apps like Visual Studio)\n";
-            file << "use_keyboard_hook = " << (config.use_keyboard_hook ? "true" : "false") << "\n\n";
-
-            file << "=== SOUND SETTINGS ===\n\n";
-            file << "# Play notification sounds when muting/unmuting\n";
-            file << "play_sounds = " << (config.play_sounds ? "true" : "false") << "\n\n";
-
-            file << "# Volume for notification sounds (0-100, 0=silent, 100=loudest)\n";
-            file << "sound_volume = " << config.sound_volume << "\n\n";
-
-            file << "# Sound files (must be WAV format, leave empty to disable specific sounds)\n";
-            file << "# Files should be in the same folder as this program, or you can specify the exact path\n";
-            file << "mute_sound_file = " << config.mute_sound_file << "\n";
-            file << "unmute_sound_file = " << config.unmute_sound_file << "\n\n";
-
-            file << "=== BEHAVIOR SETTINGS ===\n\n";
-            file << "# Automatically unmute microphone when program exits\n";
-            file << "# Set to false if you want to keep the mute state when closing\n";
-            file << "unmute_on_exit = " << (config.unmute_on_exit ? "true" : "false") << "\n\n";
+            write_config_settings(file, config);
 
             file << "===============================================\n";
             file << "                QUICK SETUP\n";
@@ -530,52 +771,30 @@ public:
             file << "1. Run this program to generate device list\n";
             file << "2. Check '" << config.devices_list_file << "' for available microphones\n";
             file << "3. Edit this config file with your preferred settings\n";
-            file << "4. Right-click tray icon -> 'Reload Config' to apply changes\n\n";
+            file << "4. Save the file, changes are applied automatically\n";
+            file << "   (Right-click tray icon -> 'Reload Config' also re-opens the devices)\n\n";
             file << "Default hotkey: Ctrl+Shift+F1\n";
             file << "Left-click tray icon: Toggle mute\n";
             file << "Right-click tray icon: Show menu\n\n";
         }
     }
 
-    void play_sound(const std::string& sound_file) {
-        // Validate configuration and inputs
-        if (!config.play_sounds || sound_file.empty()) {
+    // Sounds decoded by a config update or the background init, audio_mutex held
+    void install_sounds(PcmSound (&sounds)[SoundPlayer::SOUND_COUNT]) {
+        sounds_generation++;
+        if (!config.play_sounds || config.sound_volume <= MIN_SOUND_VOLUME) {
+            sound_player.close();
             return;
         }
+        if (!sound_player.open()) return;
 
-        // Clamp volume to valid range (0-100)
-        int clamped_volume = config.sound_volume;
-        if (clamped_volume < 0) {
-            clamped_volume = 0;
-        }
-        else if (clamped_volume > 100) {
-            clamped_volume = 100;
-        }
-
-        // Early exit if volume is zero (silent)
-        if (clamped_volume == 0) {
-            return;
-        }
-
-        // Check if file exists (more efficient than trying to play)
-        DWORD file_attributes = GetFileAttributesA(sound_file.c_str());
-        if (file_attributes == INVALID_FILE_ATTRIBUTES) {
-            return; // File doesn't exist, silently skip
-        }
-
-        // Stop any currently playing sound before starting a new one
-        PlaySoundA(nullptr, nullptr, 0); // Stop any currently playing sound
-
-        // Set system volume for sound effects if volume is not 100%
-        if (clamped_volume != 100) {
-            // Calculate volume (Windows expects 0-0xFFFF range)
-            DWORD volume = (DWORD)((clamped_volume / 100.0) * 0xFFFF);
-            DWORD stereo_volume = (volume << 16) | volume;
-            waveOutSetVolume(nullptr, stereo_volume);
-        }
+        sound_player.load_decoded(SoundPlayer::MUTE_SOUND, std::move(sounds[SoundPlayer::MUTE_SOUND]));
+        sound_player.load_decoded(SoundPlayer::UNMUTE_SOUND, std::move(sounds[SoundPlayer::UNMUTE_SOUND]));
+    }
 
-        // Play sound asynchronously with flags to allow interruption
-        PlaySoundA(sound_file.c_str(), nullptr, SND_ASYNC | SND_FILENAME | SND_NODEFAULT);
+    bool play_sound(SoundPlayer::SoundId sound) {
+        if (!config.play_sounds) return false;
+        return sound_player.play(sound);
     }
 
     bool create_main_window() {
@@ -608,7 +827,7 @@ public:
             L"Microphone Controller",
             WS_POPUP,       // Minimal window style
             0, 0, 1, 1,     // Minimal size
-            nullptr,        // No parent
+            headless ? HWND_MESSAGE : nullptr, // message-only without a tray icon
             nullptr,        // No menu
             hinstance,
             this            // Pass this pointer
@@ -624,12 +843,13 @@ public:
         notification_icon_data.uFlags = NIF_ICON | NIF_MESSAGE | NIF_TIP;
         notification_icon_data.uCallbackMessage = WM_TRAYICON;
 
-        // Load appropriate icon
-        notification_icon_data.hIcon = LoadIcon(GetModuleHandle(NULL), is_muted ? MAKEINTRESOURCE(MUTEICON) : MAKEINTRESOURCE(UNMUTEICON));
+        // Load both icons once, shared resource icons never need freeing
+        HINSTANCE hinstance = GetModuleHandle(NULL);
+        tray_icons[0] = LoadIcon(hinstance, MAKEINTRESOURCE(UNMUTEICON));
+        tray_icons[1] = LoadIcon(hinstance, MAKEINTRESOURCE(MUTEICON));
 
-        std::wstring tooltip = is_muted ? L"🔇 MUTED" : L"🎤 UNMUTED";
-        tooltip += L" - " + string_to_wstring(current_device_name);
-        wcscpy_s(notification_icon_data.szTip, tooltip.c_str());
+        rebuild_tray_tooltips();
+        fill_tray_state();
 
         bool success = Shell_NotifyIcon(NIM_ADD, &notification_icon_data);
         if (success) {
@@ -638,151 +858,879 @@ public:
         return success;
     }
 
+    // Copies at most capacity - 1 characters and always terminates
+    static size_t copy_tooltip(WCHAR* dst, size_t capacity, const WCHAR* src) {
+        size_t i = 0;
+        for (; i + 1 < capacity && src[i]; i++) dst[i] = src[i];
+        dst[i] = L'\0';
+        return i;
+    }
+
+    // Call whenever current_device_name changes
+    void rebuild_tray_tooltips() {
+        std::wstring device = L" - " + string_to_wstring(current_device_name);
+        copy_tooltip(tray_tooltips[0], TOOLTIP_CAPACITY, (L"🎤 UNMUTED" + device).c_str());
+        copy_tooltip(tray_tooltips[1], TOOLTIP_CAPACITY, (L"🔇 MUTED" + device).c_str());
+    }
+
+    // Allocation-free: picks the prebuilt icon and tooltip. A meter level
+    // seen for the first time draws its icon once.
+    void fill_tray_state() {
+        int state = is_muted ? 1 : 0;
+        notification_icon_data.hIcon = level_meter_active ? level_icon(state, level_meter.level()) : tray_icons[state];
+
+        size_t failed = failed_devices;
+        if (failed == 0) {
+            memcpy(notification_icon_data.szTip, tray_tooltips[state], sizeof(notification_icon_data.szTip));
+        }
+        else {
+            // Rare error path, still formatted on the stack
+            WCHAR suffix[32];
+            int suffix_len = swprintf(suffix, 32, L" (%zu failed)", failed);
+            if (suffix_len < 0) suffix_len = 0;
+            size_t len = copy_tooltip(notification_icon_data.szTip, TOOLTIP_CAPACITY - suffix_len, tray_tooltips[state]);
+            copy_tooltip(notification_icon_data.szTip + len, TOOLTIP_CAPACITY - len, suffix);
+        }
+    }
+
     void update_tray_icon() {
         if (!tray_icon_added) return;
 
-        notification_icon_data.hIcon = LoadIcon(GetModuleHandle(NULL), is_muted ? MAKEINTRESOURCE(MUTEICON) : MAKEINTRESOURCE(UNMUTEICON));
-        std::wstring tooltip = is_muted ? L"🔇 MUTED" : L"🎤 UNMUTED";
-        tooltip += L" - " + string_to_wstring(current_device_name);
-        wcscpy_s(notification_icon_data.szTip, tooltip.c_str());
+        fill_tray_state();
         Shell_NotifyIcon(NIM_MODIFY, &notification_icon_data);
     }
 
-    bool register_global_hotkey() {
-        bool success = RegisterHotKey(main_hwnd, HOTKEY_ID, config.hotkey_mod, config.hotkey_vk);
-        if (success) {
-            hotkey_registered = true;
+    void refresh_tray_device() {
+        rebuild_tray_tooltips();
+        update_tray_icon();
+        publish_device_list();
+    }
+
+    // Server thread: only reads atomics and posts, never touches the devices
+    void on_control_command(ControlVerb verb, std::string& reply) {
+        MuteIntent intent;
+        switch (verb) {
+        case ControlVerb::Get:
+            append_control_state(reply, "state", is_muted);
+            return;
+        case ControlVerb::Toggle: intent = MuteIntent::Toggle; break;
+        case ControlVerb::Mute: intent = MuteIntent::Mute; break;
+        case ControlVerb::Unmute: intent = MuteIntent::Unmute; break;
+        default:
+            append_control_error(reply, "unsupported");
+            return;
         }
-        return success;
+
+        HWND hwnd = main_hwnd;
+        if (!hwnd || !PostMessage(hwnd, WM_CONTROL_COMMAND, (WPARAM)intent, 0)) {
+            append_control_error(reply, "not ready");
+            return;
+        }
+        reply += "ok\n";
     }
 
-    bool should_handle_hotkey(KBDLLHOOKSTRUCT* kbStruct, WPARAM wParam) {
-        // Only react to key down events
-        if (wParam != WM_KEYDOWN && wParam != WM_SYSKEYDOWN) {
-            return false;
+    void start_control_server() {
+        control_server.stop();
+        if (config.control_pipe.empty()) return;
+
+        bool started = control_server.start(config.control_pipe, [this](ControlVerb verb, std::string& reply) {
+            on_control_command(verb, reply);
+        });
+        if (started) {
+            publish_device_list();
+            control_server.publish_state(is_muted);
         }
+        else {
+            show_tray_notice(L"Control pipe unavailable",
+                L"Another program already serves '" + string_to_wstring(config.control_pipe) + L"'.");
+        }
+    }
 
-        // Check if the main key matches
-        if (kbStruct->vkCode != config.hotkey_vk) {
-            return false;
+    void publish_device_list() {
+        if (!control_server.running()) return;
+
+        std::string lines;
+        for (const auto& device : device_registry.devices()) {
+            append_control_device(lines, device, mute_group.contains(device.id));
         }
+        control_server.set_devices(std::move(lines));
+    }
 
-        // Get current modifier states
-        BYTE keyboardState[256];
-        GetKeyboardState(keyboardState);
+    // Balloon instead of a modal dialog, for problems nobody is waiting on
+    void show_tray_notice(const wchar_t* title, const std::wstring& text) {
+        log.write(LogLevel::Warning, "notice", { { "title", wstring_to_string(title) }, { "message", wstring_to_string(text) } });
+        if (!tray_icon_added) return;
 
-        // Check each modifier key state
-        bool ctrl_pressed = (keyboardState[VK_CONTROL] & 0x80) != 0;
-        bool alt_pressed = (keyboardState[VK_MENU] & 0x80) != 0;
-        bool shift_pressed = (keyboardState[VK_SHIFT] & 0x80) != 0;
-        bool win_pressed = (keyboardState[VK_LWIN] & 0x80) != 0 ||
-            (keyboardState[VK_RWIN] & 0x80) != 0;
+        NOTIFYICONDATA notice = notification_icon_data;
+        notice.uFlags = NIF_INFO;
+        notice.dwInfoFlags = NIIF_WARNING;
+        copy_tooltip(notice.szInfoTitle, sizeof(notice.szInfoTitle) / sizeof(WCHAR), title);
+        copy_tooltip(notice.szInfo, sizeof(notice.szInfo) / sizeof(WCHAR), text.c_str());
+        Shell_NotifyIcon(NIM_MODIFY, &notice);
+    }
+
+    // The classic hotkey_mod/hotkey_vk pair toggles, the rest are optional
+    std::vector<HotkeyBinding> hotkey_bindings() const {
+        HotkeyChord toggle;
+        toggle.mods = config.hotkey_mod & HOTKEY_MOD_MASK;
+        toggle.vk = config.hotkey_vk;
+        return {
+            { toggle, HotkeyAction::Toggle },
+            { config.mute_hotkey, HotkeyAction::Mute },
+            { config.unmute_hotkey, HotkeyAction::Unmute },
+            { config.cycle_device_hotkey, HotkeyAction::CycleDevice },
+            { config.push_to_talk_hotkey, HotkeyAction::PushToTalk },
+            { config.push_to_mute_hotkey, HotkeyAction::PushToMute },
+        };
+    }
 
-        // Determine which modifiers are required by config
-        bool ctrl_required = (config.hotkey_mod & MOD_CONTROL) != 0;
-        bool alt_required = (config.hotkey_mod & MOD_ALT) != 0;
-        bool shift_required = (config.hotkey_mod & MOD_SHIFT) != 0;
-        bool win_required = (config.hotkey_mod & MOD_WIN) != 0;
+    void rebuild_hotkey_matcher() {
+        hotkey_matcher.clear();
+        for (const auto& binding : hotkey_bindings()) {
+            hotkey_matcher.bind(binding.chord, binding.action);
+        }
+    }
+
+    // Registers every binding with RegisterHotKey. A chord that is already
+    // registered keeps its id so it never goes dead, and a chord that fails
+    // to register leaves the previous hotkey of that action in place.
+    bool register_global_hotkeys() {
+        std::vector<RegisteredHotkey> kept;
+        bool all_registered = true;
+
+        for (const auto& binding : hotkey_bindings()) {
+            if (binding.chord.empty()) continue;
+
+            auto same_chord = std::find_if(registered_hotkeys.begin(), registered_hotkeys.end(),
+                [&](const RegisteredHotkey& h) { return h.chord == binding.chord; });
+            if (same_chord != registered_hotkeys.end()) {
+                same_chord->action = binding.action;
+                kept.push_back(*same_chord);
+                registered_hotkeys.erase(same_chord);
+                continue;
+            }
 
-        // Check exact modifier match - no extra keys pressed
-        bool exact_match = (ctrl_pressed == ctrl_required) &&
-            (alt_pressed == alt_required) &&
-            (shift_pressed == shift_required) &&
-            (win_pressed == win_required);
+            int id = next_hotkey_id;
+            next_hotkey_id = (next_hotkey_id == MAX_HOTKEY_ID) ? 1 : next_hotkey_id + 1;
+            if (RegisterHotKey(main_hwnd, id, binding.chord.mods | MOD_NOREPEAT, binding.chord.vk)) {
+                kept.push_back({ id, binding.chord, binding.action });
+                continue;
+            }
 
-        // Special case: If no modifiers are required, we need to verify no modifiers are pressed
-        if (config.hotkey_mod == 0) {
-            return exact_match && !ctrl_pressed && !alt_pressed &&
-                !shift_pressed && !win_pressed;
+            all_registered = false;
+            auto same_action = std::find_if(registered_hotkeys.begin(), registered_hotkeys.end(),
+                [&](const RegisteredHotkey& h) { return h.action == binding.action; });
+            if (same_action != registered_hotkeys.end()) {
+                kept.push_back(*same_action);
+                registered_hotkeys.erase(same_action);
+            }
         }
 
-        return exact_match;
+        unregister_global_hotkeys(); // whatever was not carried over
+        registered_hotkeys.swap(kept);
+        return all_registered;
+    }
+
+    void unregister_global_hotkeys() {
+        for (const auto& hotkey : registered_hotkeys) {
+            if (hotkey.chord == polled_hold_chord) stop_hold_release_poll();
+            UnregisterHotKey(main_hwnd, hotkey.id);
+        }
+        registered_hotkeys.clear();
     }
 
     static LRESULT CALLBACK keyboard_hook_proc(int nCode, WPARAM wParam, LPARAM lParam) {
         if (nCode >= HC_ACTION) {
             KBDLLHOOKSTRUCT* kbStruct = (KBDLLHOOKSTRUCT*)lParam;
-
-            // Get the controller instance (stored in window property)
-            HWND hwnd = FindWindow(L"MicController_MultiDevice_Enhanced", nullptr);
-            if (hwnd) {
-                MicrophoneController* controller = (MicrophoneController*)GetWindowLongPtr(hwnd, GWLP_USERDATA);
-                if (controller && controller->should_handle_hotkey(kbStruct, wParam)) {
-                    controller->toggle_microphone_mute();
-                    return 1; // Block the key from reaching other apps
+            MicrophoneController* controller = hook_controller.load(std::memory_order_acquire);
+            if (controller) {
+                // One table lookup per key, modifiers are tracked from this same stream
+                bool down = (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN);
+                HotkeyEvent event = controller->hotkey_matcher.on_key(kbStruct->vkCode, down);
+                if (event.action != HotkeyAction::None) {
+                    controller->handle_hotkey_event(event, latency_now_ns());
+                }
+                if (event.swallow) {
+                    return 1; // Block the key, its repeats and its release from reaching other apps
                 }
             }
         }
         return CallNextHookEx(nullptr, nCode, wParam, lParam);
     }
 
-    void toggle_microphone_mute() {
-        static std::chrono::steady_clock::time_point last_toggle_time;
-        const std::chrono::milliseconds cooldown(config.toggle_cooldown);
+    // Seeds the matcher with modifiers already held when the hook starts
+    void sync_hotkey_modifiers() {
+        static const int modifier_keys[] = {
+            VK_LSHIFT, VK_RSHIFT, VK_LCONTROL, VK_RCONTROL, VK_LMENU, VK_RMENU, VK_LWIN, VK_RWIN
+        };
+        hotkey_matcher.reset_key_state();
+        for (int vk : modifier_keys) {
+            if (GetAsyncKeyState(vk) & 0x8000) hotkey_matcher.on_key(vk, true);
+        }
+    }
 
-        auto now = std::chrono::steady_clock::now();
-        if (now - last_toggle_time < cooldown) {
-            return; // Still in cooldown, ignore input
+    bool install_keyboard_hook() {
+        sync_hotkey_modifiers();
+        hook_controller.store(this, std::memory_order_release);
+
+        keyboard_hook = SetWindowsHookEx(WH_KEYBOARD_LL, keyboard_hook_proc, GetModuleHandle(nullptr), 0);
+        if (!keyboard_hook) {
+            hook_controller.store(nullptr, std::memory_order_release);
+            return false;
         }
-        last_toggle_time = now;
+        return true;
+    }
 
-        if (!endpoint_volume) return;
+    void uninstall_keyboard_hook() {
+        if (keyboard_hook) {
+            UnhookWindowsHookEx(keyboard_hook);
+            keyboard_hook = nullptr;
+        }
+        hook_controller.store(nullptr, std::memory_order_release);
+    }
 
-        is_muted = !is_muted;
-        HRESULT hr = endpoint_volume->SetMute(is_muted, nullptr);
+    // Runs inside the keyboard hook: only enqueues or posts, never blocks.
+    // Hold keys act on both edges and skip the cooldown, the rest on press.
+    void handle_hotkey_event(const HotkeyEvent& event, uint64_t received_ns) {
+        bool muted;
+        if (hold_state.on_event(event, muted)) {
+            request_mute_change(muted ? MuteIntent::Mute : MuteIntent::Unmute, MuteSource::Hotkey, latency.begin(received_ns));
+            return;
+        }
+        if (event.edge != HotkeyEdge::Press) return;
 
-        if (SUCCEEDED(hr)) {
-            // Play appropriate sound
-            if (is_muted) {
-                play_sound(config.mute_sound_file);
+        switch (event.action) {
+        case HotkeyAction::Toggle:
+            toggle_microphone_mute(MuteSource::Hotkey, received_ns);
+            break;
+        case HotkeyAction::Mute:
+            request_mute_change(MuteIntent::Mute, MuteSource::Hotkey, latency.begin(received_ns));
+            break;
+        case HotkeyAction::Unmute:
+            request_mute_change(MuteIntent::Unmute, MuteSource::Hotkey, latency.begin(received_ns));
+            break;
+        case HotkeyAction::CycleDevice:
+            PostMessage(main_hwnd, WM_CYCLE_DEVICE, 0, 0);
+            break;
+        case HotkeyAction::PushToTalk:
+        case HotkeyAction::PushToMute:
+        case HotkeyAction::None:
+            break;
+        }
+    }
+
+    // WM_HOTKEY only reports the press of a registered hold key
+    void start_hold_release_poll(const RegisteredHotkey& hotkey) {
+        stop_hold_release_poll(); // a newer hold key takes over
+        polled_hold_chord = hotkey.chord;
+        polled_hold_action = hotkey.action;
+        SetTimer(main_hwnd, HOLD_RELEASE_TIMER_ID, HOLD_RELEASE_POLL_MS, nullptr);
+    }
+
+    void stop_hold_release_poll() {
+        if (polled_hold_action == HotkeyAction::None) return;
+        KillTimer(main_hwnd, HOLD_RELEASE_TIMER_ID);
+        polled_hold_action = HotkeyAction::None;
+    }
+
+    void poll_hold_release() {
+        if (polled_hold_action == HotkeyAction::None) return;
+        if (GetAsyncKeyState(polled_hold_chord.vk) & 0x8000) return;
+
+        HotkeyEvent release;
+        release.action = polled_hold_action;
+        release.edge = HotkeyEdge::Release;
+        stop_hold_release_poll();
+        handle_hotkey_event(release, latency_now_ns());
+    }
+
+    // Push-to-talk rests muted, so mute as soon as it gets bound
+    void enter_hold_rest_state(const HotkeyChord& previous_push_to_talk) {
+        if (!config.push_to_talk_hotkey.empty() && previous_push_to_talk.empty() && !hold_state.is_holding()) {
+            request_mute_change(MuteIntent::Mute, MuteSource::Hotkey);
+        }
+    }
+
+    // Moves the target to the next capture device. Runtime only, the
+    // config file is not touched and a reload goes back to its device.
+    void cycle_target_device() {
+        std::vector<AudioDevice> devices = enumerate_audio_devices();
+        if (devices.empty()) return;
+
+        size_t next = 0;
+        if (!mute_group.empty()) {
+            const std::string& current_id = mute_group.endpoint(0).id();
+            for (size_t i = 0; i < devices.size(); i++) {
+                if (devices[i].id == current_id) {
+                    next = (i + 1) % devices.size();
+                    break;
+                }
             }
-            else {
-                play_sound(config.unmute_sound_file);
+        }
+
+        bool device_ready;
+        {
+            std::lock_guard<std::mutex> lock(audio_mutex);
+            config.use_default_device = false;
+            config.device_group.clear();
+            config.device_name = devices[next].name;
+            device_ready = find_and_set_target_device();
+        }
+        if (!device_ready) {
+            current_device_name = "No device connected";
+        }
+        refresh_tray_device();
+        restart_capture();
+    }
+
+    // Listens to the first device of the group. The stream keeps its own
+    // reference to the device, so it is reopened after every reselect.
+    void restart_capture() {
+        stop_capture();
+
+        bool voice = config.voice_activity;
+        bool meter = config.tray_level_meter;
+        if ((!voice && !meter) || mute_group.empty()) return;
+
+        capture_stream = mute_group.endpoint(0).open_stream();
+        if (!capture_stream) return;
+
+        VadSettings settings;
+        settings.threshold_db = config.vad_threshold_db;
+        settings.attack_ms = config.vad_attack_ms;
+        settings.hangover_ms = config.vad_hangover_ms;
+        settings.release_ms = config.vad_release_ms;
+        voice_detector.configure(capture_stream->sample_rate(), settings);
+        level_meter.configure(capture_stream->sample_rate());
+
+        // Capture thread: no locks, no allocation, a post only when something changed
+        bool started = capture_stream->start([this, voice, meter](const float* samples, size_t count) {
+            HWND hwnd = main_hwnd;
+            if (voice && voice_detector.process(samples, count) && hwnd) {
+                PostMessage(hwnd, WM_VOICE_ACTIVITY, voice_detector.gate_open(), 0);
+            }
+            if (meter && level_meter.process(samples, count) && hwnd &&
+                !level_post_pending.exchange(true, std::memory_order_acq_rel)) {
+                PostMessage(hwnd, WM_LEVEL_CHANGED, 0, 0);
             }
+        });
+        if (!started) {
+            capture_stream.reset();
+            return;
+        }
 
+        level_meter_active = meter;
+        if (meter) {
+            read_level_icon_bases();
             update_tray_icon();
         }
     }
 
+    void stop_capture() {
+        if (capture_stream) {
+            capture_stream->stop();
+            capture_stream.reset();
+        }
+        if (level_meter_active) {
+            level_meter_active = false;
+            level_meter.reset();
+            update_tray_icon(); // back to the plain icon
+        }
+    }
+
+    // The icon as 32-bit pixels, icons without an alpha channel are
+    // transparent where the mask is set
+    static bool read_icon_pixels(HICON source, IconPixels& out) {
+        ICONINFO info;
+        if (!GetIconInfo(source, &info)) return false;
+
+        bool read = false;
+        BITMAP bitmap;
+        if (info.hbmColor && GetObject(info.hbmColor, sizeof(bitmap), &bitmap)) {
+            int width = bitmap.bmWidth;
+            int height = bitmap.bmHeight;
+
+            BITMAPINFO bitmap_info = {};
+            bitmap_info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+            bitmap_info.bmiHeader.biWidth = width;
+            bitmap_info.bmiHeader.biHeight = -height; // top-down
+            bitmap_info.bmiHeader.biPlanes = 1;
+            bitmap_info.bmiHeader.biBitCount = 32;
+            bitmap_info.bmiHeader.biCompression = BI_RGB;
+
+            std::vector<uint32_t> pixels((size_t)width * height);
+            std::vector<uint32_t> mask((size_t)width * height);
+            HDC screen = GetDC(nullptr);
+            read = GetDIBits(screen, info.hbmColor, 0, height, pixels.data(), &bitmap_info, DIB_RGB_COLORS) == height &&
+                GetDIBits(screen, info.hbmMask, 0, height, mask.data(), &bitmap_info, DIB_RGB_COLORS) == height;
+            ReleaseDC(nullptr, screen);
+
+            if (read) {
+                bool has_alpha = false;
+                for (uint32_t pixel : pixels) has_alpha = has_alpha || (pixel >> 24) != 0;
+                if (!has_alpha) {
+                    for (size_t i = 0; i < pixels.size(); i++) {
+                        if ((mask[i] & 0xFFFFFF) == 0) pixels[i] |= 0xFF000000;
+                    }
+                }
+                out.pixels = std::move(pixels);
+                out.width = width;
+                out.height = height;
+            }
+        }
+
+        if (info.hbmColor) DeleteObject(info.hbmColor);
+        if (info.hbmMask) DeleteObject(info.hbmMask);
+        return read;
+    }
+
+    // Called when the meter starts, the pixels are kept until exit
+    void read_level_icon_bases() {
+        for (int state = 0; state < 2; state++) {
+            if (level_icon_bases[state].pixels.empty()) read_icon_pixels(tray_icons[state], level_icon_bases[state]);
+        }
+    }
+
+    // The plain icon with the meter painted over its right edge, drawn
+    // straight into the new bitmap
+    static HICON create_level_icon(const IconPixels& base, const MeterLevel& level) {
+        if (base.pixels.empty()) return nullptr;
+
+        BITMAPINFO bitmap_info = {};
+        bitmap_info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+        bitmap_info.bmiHeader.biWidth = base.width;
+        bitmap_info.bmiHeader.biHeight = -base.height; // top-down
+        bitmap_info.bmiHeader.biPlanes = 1;
+        bitmap_info.bmiHeader.biBitCount = 32;
+        bitmap_info.bmiHeader.biCompression = BI_RGB;
+
+        HICON icon = nullptr;
+        void* bits = nullptr;
+        HBITMAP color = CreateDIBSection(nullptr, &bitmap_info, DIB_RGB_COLORS, &bits, nullptr, 0);
+        HBITMAP opaque_mask = CreateBitmap(base.width, base.height, 1, 1, nullptr); // alpha decides
+        if (color && bits && opaque_mask) {
+            memcpy(bits, base.pixels.data(), base.pixels.size() * sizeof(uint32_t));
+            draw_level_bar((uint32_t*)bits, base.width, base.height, level);
+            GdiFlush();
+
+            ICONINFO level_info = {};
+            level_info.fIcon = TRUE;
+            level_info.hbmColor = color;
+            level_info.hbmMask = opaque_mask;
+            icon = CreateIconIndirect(&level_info);
+        }
+        if (color) DeleteObject(color);
+        if (opaque_mask) DeleteObject(opaque_mask);
+        return icon;
+    }
+
+    // Drawn on first use, so an unchanging level never draws anything
+    HICON level_icon(int state, const MeterLevel& level) {
+        HICON& icon = level_icons[state][level.rms][level.peak];
+        if (!icon) icon = create_level_icon(level_icon_bases[state], level);
+        return icon ? icon : tray_icons[state];
+    }
+
+    void destroy_level_icons() {
+        for (auto& by_rms : level_icons) {
+            for (auto& by_peak : by_rms) {
+                for (HICON& icon : by_peak) {
+                    if (icon) DestroyIcon(icon);
+                    icon = nullptr;
+                }
+            }
+        }
+    }
+
+    // received_ns is when the input arrived, 0 means now
+    void toggle_microphone_mute(MuteSource source, uint64_t received_ns = 0) {
+        if (!rate_limiter.allow((size_t)source)) {
+            return; // Over the limit of this source, ignore input
+        }
+
+        if (received_ns == 0) received_ns = latency_now_ns();
+        request_mute_change(MuteIntent::Toggle, source, latency.begin(received_ns));
+    }
+
+    // UI thread. Automatic changes are never dropped: one over the limit
+    // waits for the next token, and a newer one replaces it meanwhile.
+    void request_automatic_change(MuteIntent intent) {
+        pending_automatic = intent;
+        automatic_pending = true;
+        flush_automatic_change();
+    }
+
+    void flush_automatic_change() {
+        KillTimer(main_hwnd, AUTOMATIC_CHANGE_TIMER_ID);
+        if (!automatic_pending) return;
+
+        // A held push-to-talk/push-to-mute key outranks the detector
+        if (hold_state.is_holding()) {
+            automatic_pending = false;
+            return;
+        }
+
+        const size_t source = (size_t)MuteSource::VoiceActivity;
+        if (!rate_limiter.allow(source)) {
+            UINT wait_ms = (UINT)((rate_limiter.wait_ns(source) + 999999) / 1000000);
+            SetTimer(main_hwnd, AUTOMATIC_CHANGE_TIMER_ID, wait_ms > 0 ? wait_ms : 1, nullptr);
+            return;
+        }
+        automatic_pending = false;
+        request_mute_change(pending_automatic, MuteSource::VoiceActivity);
+    }
+
+    void apply_rate_limits() {
+        rate_limiter.configure((size_t)MuteSource::Hotkey, { config.toggle_cooldown, config.toggle_burst });
+        rate_limiter.configure((size_t)MuteSource::Tray, { config.tray_cooldown, config.tray_burst });
+        rate_limiter.configure((size_t)MuteSource::Control, { config.control_cooldown, config.control_burst });
+        rate_limiter.configure((size_t)MuteSource::VoiceActivity, { config.voice_cooldown, config.voice_burst });
+    }
+
+    // Only enqueues, safe to call from the keyboard hook
+    void request_mute_change(MuteIntent intent, MuteSource source, LatencyRecorder::TraceId trace = 0) {
+        if (mute_worker_wake && mute_requests.push({ intent, source, trace })) {
+            SetEvent(mute_worker_wake);
+        }
+        else {
+            latency.abandon(trace);
+        }
+    }
+
+    bool start_mute_worker() {
+        mute_worker_wake = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+        if (!mute_worker_wake) return false;
+
+        mute_worker_stop = false;
+        mute_worker = std::thread([this] { mute_worker_loop(); });
+        return true;
+    }
+
+    void stop_mute_worker() {
+        if (mute_worker.joinable()) {
+            mute_worker_stop = true;
+            SetEvent(mute_worker_wake);
+            mute_worker.join();
+        }
+        if (mute_worker_wake) {
+            CloseHandle(mute_worker_wake);
+            mute_worker_wake = nullptr;
+        }
+    }
+
+    void mute_worker_loop() {
+        HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+        bool worker_com = SUCCEEDED(hr);
+
+        while (WaitForSingleObject(mute_worker_wake, INFINITE) == WAIT_OBJECT_0 && !mute_worker_stop) {
+            // Coalesce everything queued so far into one change,
+            // only the newest request is timed past this point
+            MuteChange change;
+            MuteRequest request;
+            MuteSource source = MuteSource::Unknown;
+            LatencyRecorder::TraceId trace = 0;
+            while (mute_requests.pop(request)) {
+                change.add(request.intent);
+                source = request.source; // the newest request decides, so it is credited
+                if (request.trace) {
+                    latency.abandon(trace);
+                    trace = request.trace;
+                }
+            }
+            latency.mark(trace, STAGE_DISPATCHED);
+
+            if (change.empty()) {
+                latency.abandon(trace);
+            }
+            else {
+                apply_mute_change(change, source, trace);
+            }
+        }
+
+        if (worker_com) CoUninitialize();
+    }
+
+    // Runs on the mute worker thread. The trace is completed by the UI
+    // thread, or abandoned here when nothing is posted to it.
+    void apply_mute_change(const MuteChange& change, MuteSource source, LatencyRecorder::TraceId trace) {
+        std::lock_guard<std::mutex> lock(audio_mutex);
+        if (mute_group.empty()) {
+            latency.abandon(trace);
+            return;
+        }
+
+        // Without notifications the cached state may be stale, ask the devices
+        if (!mute_events_active) {
+            for (size_t i = 0; i < mute_group.size(); i++) {
+                bool current;
+                if (mute_group.endpoint(i).get_mute(current)) mute_group.note_mute(i, current);
+            }
+            is_muted = mute_group.all_muted();
+        }
+
+        // A partially muted group counts as unmuted, so a toggle mutes everything
+        bool muted = change.apply(is_muted);
+        if (muted ? mute_group.all_muted() : !mute_group.any_muted()) {
+            latency.abandon(trace);
+            return;
+        }
+
+        MuteGroup::Result result;
+        bool was_muted[MuteGroup::MAX_DEVICES];
+        for (size_t i = 0; i < mute_group.size(); i++) {
+            was_muted[i] = mute_group.is_member_muted(i);
+            mute_journal.begin_change(i, muted);
+        }
+        mute_group.set_mute(muted, result);
+        latency.mark(trace, STAGE_BACKEND_DONE);
+        for (size_t i = 0; i < mute_group.size(); i++) {
+            mute_journal.end_change(i, mute_group.is_member_muted(i));
+            if (was_muted[i] != muted || !result.ok[i]) {
+                log_mute_event(i, was_muted[i], mute_group.is_member_muted(i), source, !result.ok[i]);
+            }
+        }
+        failed_devices = result.count - result.succeeded;
+        is_muted = mute_group.all_muted();
+
+        if (result.succeeded > 0) {
+            // Play appropriate sound
+            if (play_sound(muted ? SoundPlayer::MUTE_SOUND : SoundPlayer::UNMUTE_SOUND)) {
+                latency.mark(trace, STAGE_SOUND_STARTED);
+            }
+        }
+
+        // Tray icon belongs to the UI thread, which also completes the trace
+        if (!PostMessage(main_hwnd, WM_MUTE_STATE_CHANGED, is_muted, trace)) latency.abandon(trace);
+    }
+
     void restore_initial_mute_state() {
-        if (!endpoint_volume || !config.unmute_on_exit) return;
+        if (mute_group.empty() || !config.unmute_on_exit) return;
 
         // Always unmute on exit if unmute_on_exit is true
-        if (is_muted) {
-            endpoint_volume->SetMute(FALSE, nullptr);
+        if (mute_group.any_muted()) {
+            MuteGroup::Result result;
+            bool was_muted[MuteGroup::MAX_DEVICES];
+            for (size_t i = 0; i < mute_group.size(); i++) {
+                was_muted[i] = mute_group.is_member_muted(i);
+                mute_journal.begin_change(i, false);
+            }
+            mute_group.set_mute(false, result);
+            for (size_t i = 0; i < mute_group.size(); i++) {
+                mute_journal.end_change(i, mute_group.is_member_muted(i));
+                if (was_muted[i]) log_mute_event(i, true, mute_group.is_member_muted(i), MuteSource::Exit, !result.ok[i]);
+            }
         }
     }
 
-    void reload_configuration() {
-        // Unregister old hotkey
-        if (hotkey_registered) {
-            UnregisterHotKey(main_hwnd, HOTKEY_ID);
-            hotkey_registered = false;
+    // Any thread that may read the group: the mute worker, or a backend
+    // thread while the group is subscribed
+    void log_mute_event(size_t index, bool was_muted, bool muted, MuteSource source, bool failed = false) {
+        MuteEvent event;
+        event.device_id = mute_group.endpoint(index).id();
+        event.device_name = mute_group.name(index);
+        event.was_muted = was_muted;
+        event.muted = muted;
+        event.source = source;
+        event.failed = failed;
+        event_log.append(event);
+    }
+
+    void open_event_log() {
+        if (!event_log_mapping.open(config.mute_event_log_file, MuteEventLog::FILE_SIZE, true) ||
+            !event_log.attach(event_log_mapping.data(), event_log_mapping.size())) {
+            event_log_mapping.close();
+            log.write(LogLevel::Warning, "event_log_unavailable", { { "file", config.mute_event_log_file } });
         }
+    }
 
-        // Load new config
-        load_config();
+    // Maps the journal and, if the last session never got to cleanup(),
+    // does for its devices what cleanup() would have done
+    void open_mute_journal() {
+        std::vector<MuteJournalEntry> unfinished;
+        if (!mute_journal_mapping.open(config.mute_journal_file, MuteJournal::FILE_SIZE) ||
+            !mute_journal.attach(mute_journal_mapping.data(), mute_journal_mapping.size(), unfinished)) {
+            mute_journal_mapping.close();
+            log.write(LogLevel::Warning, "journal_unavailable", { { "file", config.mute_journal_file } });
+            return;
+        }
+        if (unfinished.empty()) return;
 
-        // Reinitialize audio with new device settings
-        if (!find_and_set_target_device()) {
-            std::wstring error_msg = L"Failed to reinitialize audio device after config reload.\n";
-            if (!config.use_default_device) {
-                error_msg += L"Check your device_name setting in the config file.";
-            }
-            MessageBox(nullptr, error_msg.c_str(), L"Device Error", MB_OK | MB_ICONWARNING);
+        log.write(LogLevel::Warning, "unclean_shutdown", { { "devices", std::to_string(unfinished.size()) } });
+        if (!ensure_audio_backend()) return;
+        for (const auto& entry : unfinished) reconcile_journal_entry(entry);
+    }
+
+    void reconcile_journal_entry(const MuteJournalEntry& entry) {
+        original_mute.emplace(entry.id, entry.original_muted);
+
+        const char* action = "kept";
+        bool muted = false;
+        std::shared_ptr<CaptureEndpoint> endpoint;
+        if (device_registry.describe(entry.id)) endpoint = device_registry.acquire(entry.id);
+        if (!endpoint || !endpoint->get_mute(muted)) {
+            action = "gone";
         }
         else {
-            update_tray_icon(); // Update with new device name
+            // Changed by someone else since the crash: theirs wins
+            bool ours = muted == entry.muted || (entry.pending && muted == entry.pending_muted);
+            if (ours && muted && config.unmute_on_exit) {
+                bool ok = endpoint->set_mute(false);
+                action = ok ? "unmuted" : "unmute_failed";
+
+                MuteEvent event;
+                event.device_id = entry.id;
+                event.device_name = device_registry.find(entry.id)->name;
+                event.was_muted = true;
+                event.muted = !ok;
+                event.source = MuteSource::Recovery;
+                event.failed = !ok;
+                event_log.append(event);
+            }
+        }
+
+        log.write(LogLevel::Warning, "journal_reconcile", {
+            { "device", entry.id },
+            { "original", entry.original_muted ? "muted" : "unmuted" },
+            { "found", muted ? "muted" : "unmuted" },
+            { "action", action } });
+    }
+
+    // After every change of the group. A device keeps its original state
+    // across rebinds, and across a crash through the reconcile.
+    void bind_mute_journal() {
+        std::vector<MuteJournalEntry> devices;
+        for (size_t i = 0; i < mute_group.size(); i++) {
+            MuteJournalEntry entry;
+            entry.id = mute_group.endpoint(i).id();
+            entry.muted = mute_group.is_member_muted(i);
+            entry.original_muted = original_mute.emplace(entry.id, entry.muted).first->second;
+            devices.push_back(std::move(entry));
+        }
+        mute_journal.bind(devices);
+    }
+
+    // Switches to the configured hotkeys without a moment where none is active
+    bool apply_hotkey_config() {
+        rebuild_hotkey_matcher();
+
+        if (config.use_keyboard_hook && (keyboard_hook || install_keyboard_hook())) {
+            unregister_global_hotkeys();
+            return true;
+        }
+
+        bool all_registered = register_global_hotkeys();
+        if (!registered_hotkeys.empty()) {
+            uninstall_keyboard_hook();
+        }
+        return all_registered;
+    }
+
+    // Releases every endpoint of the current backend, audio_mutex held
+    void reset_audio_backend() {
+        if (!audio_backend) return;
+
+        audio_backend->subscribe_devices(nullptr);
+        mute_group.clear();
+        device_registry.clear();
+        audio_backend.reset();
+
+        std::lock_guard<std::mutex> lock(device_events_mutex);
+        pending_device_events.clear();
+    }
+
+    // Swaps in the new config and re-applies only the subsystems whose
+    // settings changed, plus any in force. Returns the problems, if any.
+    std::wstring apply_config_update(ConfigUpdate& update, unsigned force) {
+        std::wstring problems = format_config_diagnostics(update.config.config_file, update.diagnostics);
+
+        unsigned changed = diff_config(config, update.config) | force;
+        if (changed == 0) return problems;
+        HotkeyChord previous_push_to_talk = config.push_to_talk_hotkey;
+
+        bool device_ready = true;
+        bool backend_changed = config.audio_backend != update.config.audio_backend;
+        {
+            // The mute worker sees either the old or the new state, never a mix
+            std::lock_guard<std::mutex> lock(audio_mutex);
+
+            if (backend_changed) {
+                reset_audio_backend();
+            }
+            config = update.config;
+
+            if (changed & CONFIG_SOUNDS) install_sounds(update.sounds);
+            if (changed & CONFIG_DEVICE) device_ready = find_and_set_target_device();
+        }
+
+        if (changed & CONFIG_DEVICE) {
+            if (!device_ready) {
+                current_device_name = "No device connected";
+                problems += L"Failed to reinitialize audio device after config reload.\n";
+                if (!config.use_default_device) {
+                    problems += L"Check your device_name setting in the config file.\n";
+                }
+            }
+            refresh_tray_device(); // Update with new device name
+        }
+
+        if (changed & (CONFIG_DEVICE | CONFIG_CAPTURE)) restart_capture();
+        if (backend_changed && audio_backend) start_background_init(false, true, false);
+        if (changed & CONFIG_CONTROL) start_control_server();
+        if (changed & CONFIG_RATE_LIMIT) apply_rate_limits();
+
+        if ((changed & CONFIG_HOTKEY) && !apply_hotkey_config()) {
+            problems += L"Failed to register a new hotkey, the previous one stays active.\n";
+            problems += L"The key combination might be in use.\n";
+        }
+        if (changed & CONFIG_HOTKEY) enter_hold_rest_state(previous_push_to_talk);
+        return problems;
+    }
+
+    // Watcher thread
+    void on_config_file_changed(const std::string& path) {
+        auto update = std::make_unique<ConfigUpdate>();
+        if (!build_config_update(path, *update)) return; // deleted or mid-replace
+
+        {
+            std::lock_guard<std::mutex> lock(config_update_mutex);
+            pending_config_update = std::move(update); // a newer edit supersedes an unapplied one
+        }
+
+        HWND hwnd = main_hwnd;
+        if (hwnd) PostMessage(hwnd, WM_CONFIG_CHANGED, 0, 0);
+    }
+
+    // UI thread, nobody is waiting on a dialog here
+    void process_config_update() {
+        std::unique_ptr<ConfigUpdate> update;
+        {
+            std::lock_guard<std::mutex> lock(config_update_mutex);
+            update.swap(pending_config_update);
         }
+        if (!update) return;
 
-        // Register new hotkey
-        if (!register_global_hotkey()) {
-            MessageBox(nullptr,
-                L"Failed to register new hotkey after config reload.\nThe key combination might be in use.",
-                L"Hotkey Registration Failed", MB_OK | MB_ICONWARNING);
+        std::wstring problems = apply_config_update(*update, 0);
+        if (!problems.empty()) {
+            show_tray_notice(L"Config Reload", problems);
         }
     }
 
+    // Manual reload from the tray menu, also re-opens the devices and sounds
+    bool reload_configuration() {
+        ConfigUpdate update;
+        if (!build_config_update(config.config_file, update)) {
+            save_config(); // Recreate the default file, keep the running settings
+            return true;
+        }
+
+        std::wstring problems = apply_config_update(update, CONFIG_DEVICE | CONFIG_SOUNDS);
+        if (!problems.empty()) {
+            MessageBox(nullptr, problems.c_str(), L"Config Reload", MB_OK | MB_ICONWARNING);
+            return false;
+        }
+        return true;
+    }
+
     static LRESULT CALLBACK main_window_proc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         MicrophoneController* controller = nullptr;
 
@@ -805,16 +1753,65 @@ public:
     LRESULT window_procedure(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         switch (msg) {
         case WM_HOTKEY:
-            // Only process if we're not using the keyboard hook
-            if (!use_keyboard_hook && wParam == HOTKEY_ID) {
-                toggle_microphone_mute();
+            // Only registered while the keyboard hook is not in use
+            for (const auto& hotkey : registered_hotkeys) {
+                if (hotkey.id == (int)wParam) {
+                    HotkeyEvent press;
+                    press.action = hotkey.action;
+                    handle_hotkey_event(press, latency_now_ns());
+                    if (is_hold_action(hotkey.action)) start_hold_release_poll(hotkey);
+                    break;
+                }
             }
             break;
 
+        case WM_TIMER:
+            if (wParam == HOLD_RELEASE_TIMER_ID) poll_hold_release();
+            else if (wParam == AUTOMATIC_CHANGE_TIMER_ID) flush_automatic_change();
+            break;
+
+        case WM_CYCLE_DEVICE:
+            cycle_target_device();
+            break;
+
+        case WM_LEVEL_CHANGED:
+            level_post_pending.store(false, std::memory_order_release);
+            if (level_meter_active) update_tray_icon();
+            break;
+
+        case WM_VOICE_ACTIVITY:
+            request_automatic_change(wParam ? MuteIntent::Unmute : MuteIntent::Mute);
+            break;
+
+        case WM_MUTE_STATE_CHANGED:
+            update_tray_icon();
+            latency.mark((LatencyRecorder::TraceId)lParam, STAGE_TRAY_UPDATED);
+            latency.complete((LatencyRecorder::TraceId)lParam);
+            control_server.publish_state(is_muted);
+            log.write(LogLevel::Info, "mute_state", { { "muted", is_muted ? "true" : "false" } });
+            break;
+
+        case WM_CONTROL_COMMAND:
+            if ((MuteIntent)wParam == MuteIntent::Toggle) toggle_microphone_mute(MuteSource::Control);
+            else request_mute_change((MuteIntent)wParam, MuteSource::Control);
+            break;
+
+        case WM_BACKGROUND_INIT:
+            finish_background_init();
+            break;
+
+        case WM_DEVICES_CHANGED:
+            process_device_events();
+            break;
+
+        case WM_CONFIG_CHANGED:
+            process_config_update();
+            break;
+
         case WM_TRAYICON:
             switch (lParam) {
             case WM_LBUTTONUP:
-                toggle_microphone_mute();
+                toggle_microphone_mute(MuteSource::Tray);
                 break;
             case WM_RBUTTONUP:
                 show_context_menu();
@@ -847,6 +1844,7 @@ public:
         AppendMenuA(menu, MF_STRING, ID_TRAY_LIST_DEVICES, "List Audio Devices");
         AppendMenuA(menu, MF_STRING, ID_TRAY_CONFIG, "Open Config File");
         AppendMenuA(menu, MF_STRING, ID_TRAY_RELOAD_CONFIG, "Reload Config");
+        AppendMenuA(menu, MF_STRING, ID_TRAY_EXPORT_LATENCY, "Export Latency Stats");
         AppendMenuA(menu, MF_SEPARATOR, 0, nullptr);
         AppendMenuA(menu, MF_STRING, ID_TRAY_EXIT, "Exit");
 
@@ -867,7 +1865,7 @@ public:
     void handle_menu_command(WORD command_id) {
         switch (command_id) {
         case ID_TRAY_TOGGLE:
-            toggle_microphone_mute();
+            toggle_microphone_mute(MuteSource::Tray);
             break;
 
         case ID_TRAY_LIST_DEVICES:
@@ -891,9 +1889,32 @@ public:
             break;
 
         case ID_TRAY_RELOAD_CONFIG:
-            reload_configuration();
-            MessageBox(nullptr, L"Configuration reloaded successfully!",
-                L"Config Reload", MB_OK | MB_ICONINFORMATION);
+            if (reload_configuration()) {
+                MessageBox(nullptr, L"Configuration reloaded successfully!",
+                    L"Config Reload", MB_OK | MB_ICONINFORMATION);
+            }
+            break;
+
+        case ID_TRAY_EXPORT_LATENCY:
+            if (!save_latency_stats()) {
+                MessageBox(nullptr, L"Failed to write the latency stats file.",
+                    L"Latency Stats", MB_OK | MB_ICONWARNING);
+            }
+            else {
+                std::ostringstream summary;
+                latency.write_summary(summary);
+
+                std::wstring msg = string_to_wstring(summary.str());
+                msg += L"\nFull stats have been saved to '";
+                msg += string_to_wstring(config.latency_stats_file);
+                msg += L"'.\n\nWould you like to open the file now?";
+
+                if (MessageBox(nullptr, msg.c_str(), L"Latency Stats",
+                    MB_YESNO | MB_ICONINFORMATION) == IDYES) {
+                    ShellExecuteA(nullptr, "open", config.latency_stats_file.c_str(),
+                        nullptr, nullptr, SW_SHOW);
+                }
+            }
             break;
 
         case ID_TRAY_EXIT:
@@ -902,31 +1923,92 @@ public:
         }
     }
 
+    // Percentiles per toggle stage as CSV, read on the UI thread
+    bool save_latency_stats() {
+        std::ofstream file(config.latency_stats_file);
+        if (!file.is_open()) return false;
+        latency.write_csv(file);
+        return file.good();
+    }
+
+    // Set from the command line (--dump-latency)
+    void set_dump_latency_on_exit(bool enabled) {
+        dump_latency_on_exit = enabled;
+    }
+
+    // Set from the command line before run(). Headless also mirrors the log
+    // to stderr when one is attached.
+    bool open_log(bool headless_mode, bool to_stderr) {
+        headless = headless_mode;
+        return log.open(config.log_file, to_stderr ? &std::cerr : nullptr);
+    }
+
+    HWND window() const { return main_hwnd; }
+
+    // A problem that stops startup: a dialog for someone at the desk, a log
+    // line for a service manager. Headless runs never block on a dialog.
+    void report(LogLevel level, const char* event, const wchar_t* title, const std::wstring& text, UINT icon) {
+        log.write(level, event, { { "message", wstring_to_string(text) } });
+        if (!headless) MessageBox(nullptr, text.c_str(), title, MB_OK | icon);
+    }
+
+    // Since process creation, so loader and CRT start-up count too
+    static long long startup_milliseconds() {
+        FILETIME created, exited, kernel, user, now;
+        if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) return -1;
+        GetSystemTimeAsFileTime(&now);
+        auto ticks = [](const FILETIME& t) { return ((long long)t.dwHighDateTime << 32) | t.dwLowDateTime; };
+        return (ticks(now) - ticks(created)) / 10000;
+    }
+
     void cleanup() {
+        join_background_init();
+        config_watcher.stop();
+        control_server.stop();
+        stop_capture();
+
+        // Stop the worker before touching the devices from this thread
+        stop_mute_worker();
+        save_device_cache(); // with the targets bound at exit
+        close_device_cache();
+
+        if (dump_latency_on_exit) {
+            save_latency_stats();
+            dump_latency_on_exit = false;
+        }
+
         // Restore microphone state if needed
         restore_initial_mute_state();
+        mute_journal.close();
 
         // Remove tray icon
         if (tray_icon_added) {
             Shell_NotifyIcon(NIM_DELETE, &notification_icon_data);
             tray_icon_added = false;
         }
+        destroy_level_icons();
 
-        // Unregister hotkey
-        if (hotkey_registered && main_hwnd) {
-            UnregisterHotKey(main_hwnd, HOTKEY_ID);
-            hotkey_registered = false;
+        // Unregister hotkeys
+        if (main_hwnd) {
+            unregister_global_hotkeys();
         }
 
-        if (keyboard_hook) {
-            UnhookWindowsHookEx(keyboard_hook);
-            keyboard_hook = nullptr;
-        }
+        uninstall_keyboard_hook();
+
+        sound_player.close();
 
-        // Release COM objects (handled by ComPtr destructors)
-        endpoint_volume.Release();
-        current_device.Release();
-        device_enumerator.Release();
+        // Release backend objects before COM goes away
+        if (audio_backend) audio_backend->subscribe_devices(nullptr);
+        mute_group.clear();
+        device_registry.clear();
+        audio_backend.reset();
+
+        // No notification can reach the journal or the event log any more
+        mute_journal.detach();
+        mute_journal_mapping.flush();
+        mute_journal_mapping.close();
+        event_log.detach();
+        event_log_mapping.close();
 
         // Uninitialize COM
         if (com_initialized) {
@@ -941,30 +2023,52 @@ public:
         }
     }
 
+    // Startup is ordered so the hotkey and the target device are live as
+    // soon as possible: the default device is bound without enumerating the
+    // others, and everything the hotkey does not need (full enumeration,
+    // sound decoding, capture, common controls) finishes in the background.
+    // Every phase is timed and logged.
     int run() {
+        startup_trace.restart();
         if (!initialize_system()) {
-            MessageBox(nullptr, L"Failed to initialize system components.",
-                L"Initialization Error", MB_OK | MB_ICONSTOP);
+            report(LogLevel::Error, "init_failed", L"Initialization Error",
+                L"Failed to initialize system components.", MB_ICONSTOP);
             return 1;
         }
+        startup_trace.mark("com");
 
         load_config();
+        apply_rate_limits();
+        startup_trace.mark("config");
+
+        open_device_cache();
+        startup_trace.mark("device_cache");
+
+        open_event_log(); // first, the journal reconcile is logged too
+        open_mute_journal();
+        startup_trace.mark("mute_journal");
 
         if (!initialize_audio()) {
-            return 1; // Error already shown in initialize_audio()
+            return 1; // Error already reported in initialize_audio()
         }
+        startup_trace.mark("device");
 
         if (!create_main_window()) {
-            MessageBox(nullptr, L"Failed to create application window.",
-                L"Window Creation Error", MB_OK | MB_ICONSTOP);
+            report(LogLevel::Error, "window_failed", L"Window Creation Error",
+                L"Failed to create application window.", MB_ICONSTOP);
             return 1;
         }
 
-        if (!setup_tray_icon()) {
-            MessageBox(nullptr, L"Failed to create system tray icon.",
-                L"Tray Icon Error", MB_OK | MB_ICONWARNING);
+        // Apply any hot-plug events that arrived before the window existed
+        PostMessage(main_hwnd, WM_DEVICES_CHANGED, 0, 0);
+        startup_trace.mark("window");
+
+        if (!start_mute_worker()) {
+            report(LogLevel::Error, "worker_failed", L"Initialization Error",
+                L"Failed to start the audio worker thread.", MB_ICONSTOP);
             return 1;
         }
+        startup_trace.mark("worker");
 
         // Registering hotkey
         const std::wstring hotkey_error_msg =
@@ -972,26 +2076,61 @@ public:
             L"The key combination might already be in use by another application.\n\n"
             L"You can still use the tray icon to control the microphone.";
 
+        rebuild_hotkey_matcher();
         if (config.use_keyboard_hook) {
-            keyboard_hook = SetWindowsHookEx(WH_KEYBOARD_LL, keyboard_hook_proc, GetModuleHandle(nullptr), 0);
-            if (!keyboard_hook) {
-                MessageBox(nullptr,
-                    L"Failed to install keyboard hook. Falling back to standard hotkey.",
-                    L"Hook Error",
-                    MB_OK | MB_ICONWARNING);
-                if (!register_global_hotkey()) {
-                    MessageBox(nullptr, hotkey_error_msg.c_str(),
-                        L"Hotkey Registration Failed",
-                        MB_OK | MB_ICONWARNING);
+            if (!install_keyboard_hook()) {
+                report(LogLevel::Warning, "hook_failed", L"Hook Error",
+                    L"Failed to install keyboard hook. Falling back to standard hotkey.", MB_ICONWARNING);
+                if (!register_global_hotkeys()) {
+                    report(LogLevel::Warning, "hotkey_failed", L"Hotkey Registration Failed",
+                        hotkey_error_msg, MB_ICONWARNING);
                 }
             }
         }
-        else if (!register_global_hotkey()) {
-            MessageBox(nullptr, hotkey_error_msg.c_str(),
-                L"Hotkey Registration Failed",
-                MB_OK | MB_ICONWARNING);
+        else if (!register_global_hotkeys()) {
+            report(LogLevel::Warning, "hotkey_failed", L"Hotkey Registration Failed",
+                hotkey_error_msg, MB_ICONWARNING);
         }
 
+        enter_hold_rest_state(HotkeyChord());
+        startup_trace.mark("hotkey");
+
+        if (!headless && !setup_tray_icon()) {
+            report(LogLevel::Error, "tray_failed", L"Tray Icon Error",
+                L"Failed to create system tray icon.", MB_ICONWARNING);
+            return 1;
+        }
+
+        if (!config_problems.empty()) {
+            show_tray_notice(L"Config Problems", config_problems);
+        }
+        startup_trace.mark("tray");
+
+        start_control_server();
+
+        // Apply config edits as soon as the file is saved, the menu reload still works without it
+        std::string config_path = config.config_file;
+        config_watcher.start(config_path, [this, config_path] { on_config_file_changed(config_path); });
+        startup_trace.mark("control");
+
+        start_background_init(true, true, true);
+        startup_trace.mark("background_start");
+
+        for (size_t i = 0; i < startup_trace.size(); i++) {
+            char ms[32];
+            snprintf(ms, sizeof(ms), "%.2f", startup_trace.phase(i).duration_ns / 1e6);
+            log.write(LogLevel::Info, "startup_phase", { { "phase", startup_trace.phase(i).name }, { "ms", ms } });
+        }
+        char run_ms[32];
+        snprintf(run_ms, sizeof(run_ms), "%.2f", startup_trace.total_ns() / 1e6);
+        log.write(LogLevel::Info, "ready", {
+            { "mode", headless ? "headless" : "tray" },
+            { "startup_ms", std::to_string(startup_milliseconds()) },
+            { "run_ms", run_ms },
+            { "muted", is_muted ? "true" : "false" },
+            { "device", current_device_name },
+            { "pipe", control_server.running() ? config.control_pipe : "" } });
+
         // Message loop
         MSG msg;
         while (GetMessage(&msg, nullptr, 0, 0)) {
@@ -999,23 +2138,66 @@ public:
             DispatchMessage(&msg);
         }
 
+        log.write(LogLevel::Info, "stopping");
         return 0;
     }
 };
 
+std::atomic<MicrophoneController*> MicrophoneController::hook_controller{ nullptr };
+
+static std::atomic<MicrophoneController*> console_controller{ nullptr };
+
+// Ctrl+C, or the console or session going away: shut down like the tray's Exit
+static BOOL WINAPI console_ctrl_handler(DWORD ctrl_type) {
+    MicrophoneController* controller = console_controller;
+    HWND hwnd = controller ? controller->window() : nullptr;
+    if (!hwnd) return FALSE;
+
+    PostMessage(hwnd, WM_CLOSE, 0, 0);
+    if (ctrl_type != CTRL_C_EVENT && ctrl_type != CTRL_BREAK_EVENT) {
+        // The process is ended as soon as this returns, wait for cleanup instead;
+        // returning from WinMain ends this thread with it
+        Sleep(5000);
+    }
+    return TRUE;
+}
+
+// stderr for headless runs: a handle redirected by a service wrapper, or the
+// console of whoever started us
+static bool attach_stderr() {
+    HANDLE handle = GetStdHandle(STD_ERROR_HANDLE);
+    if (handle && handle != INVALID_HANDLE_VALUE) return true;
+    if (!AttachConsole(ATTACH_PARENT_PROCESS)) return false;
+
+    FILE* stream = nullptr;
+    return freopen_s(&stream, "CONOUT$", "w", stderr) == 0;
+}
+
 // Main entry point
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
+    MicrophoneController controller;
+    bool headless = lpCmdLine && strstr(lpCmdLine, "--headless");
+    if (headless || (lpCmdLine && strstr(lpCmdLine, "--log"))) {
+        controller.open_log(headless, headless && attach_stderr());
+    }
+    if (lpCmdLine && strstr(lpCmdLine, "--dump-latency")) {
+        controller.set_dump_latency_on_exit(true);
+    }
+
     // Prevent multiple instances
     HANDLE mutex = CreateMutex(nullptr, TRUE, L"MicrophoneController_SingleInstance_Mutex");
     if (GetLastError() == ERROR_ALREADY_EXISTS) {
-        MessageBox(nullptr, L"Microphone Controller is already running!\n\nCheck the system tray area.",
-            L"Already Running", MB_OK | MB_ICONINFORMATION);
+        controller.report(LogLevel::Error, "already_running", L"Already Running",
+            L"Microphone Controller is already running!\n\nCheck the system tray area.", MB_ICONINFORMATION);
         if (mutex) CloseHandle(mutex);
         return 1;
     }
 
-    MicrophoneController controller;
+    console_controller = &controller;
+    SetConsoleCtrlHandler(console_ctrl_handler, TRUE);
     int result = controller.run();
+    SetConsoleCtrlHandler(console_ctrl_handler, FALSE);
+    console_controller = nullptr;
 
     if (mutex) {
         ReleaseMutex(mutex);
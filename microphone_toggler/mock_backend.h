@@ -0,0 +1,224 @@
+#pragma once
+
+// Deterministic in-memory audio backend.
+// Used with 'audio_backend = mock' to exercise the toggle path without
+// touching real hardware. Portable, no platform headers.
+
+#include "audio_backend.h"
+
+#include <algorithm>
+#include <mutex>
+
+class MockAudioBackend : public AudioBackend {
+private:
+    // Shared between the backend and every endpoint opened on the device
+    struct DeviceState {
+        AudioDevice info;
+        bool muted = false;
+        unsigned long set_mute_calls = 0;
+        std::vector<MuteChangeHandler*> handlers;
+        std::mutex mutex;
+    };
+
+    class MockEndpoint : public CaptureEndpoint {
+    private:
+        std::shared_ptr<DeviceState> state;
+        MuteChangeHandler handler;
+
+    public:
+        explicit MockEndpoint(std::shared_ptr<DeviceState> s) : state(std::move(s)) {}
+
+        ~MockEndpoint() override {
+            subscribe(nullptr);
+        }
+
+        const std::string& id() const override { return state->info.id; }
+
+        bool get_mute(bool& muted) override {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (!state->info.is_enabled) return false;
+            muted = state->muted;
+            return true;
+        }
+
+        bool set_mute(bool muted) override {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (!state->info.is_enabled) return false;
+            state->set_mute_calls++;
+            if (state->muted != muted) {
+                state->muted = muted;
+                for (auto* h : state->handlers) (*h)(muted, true);
+            }
+            return true;
+        }
+
+        bool subscribe(MuteChangeHandler h) override {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            auto& list = state->handlers;
+            list.erase(std::remove(list.begin(), list.end(), &handler), list.end());
+            handler = std::move(h);
+            if (handler) list.push_back(&handler);
+            return true;
+        }
+    };
+
+    std::vector<std::shared_ptr<DeviceState>> devices;
+    std::string default_id;
+    DeviceChangeHandler device_handler;
+    mutable std::mutex devices_mutex;
+
+    // Handlers are called without holding devices_mutex so they may query back
+    void notify(DeviceEvent event, const std::string& id) {
+        DeviceChangeHandler handler;
+        {
+            std::lock_guard<std::mutex> lock(devices_mutex);
+            handler = device_handler;
+        }
+        if (handler) handler(event, id);
+    }
+
+    std::shared_ptr<DeviceState> find(const std::string& id) const {
+        std::lock_guard<std::mutex> lock(devices_mutex);
+        for (const auto& d : devices) {
+            if (d->info.id == id) return d;
+        }
+        return nullptr;
+    }
+
+public:
+    const char* name() const override { return "mock"; }
+
+    // Populates a fixed pair of devices unless the caller already added some
+    bool initialize() override {
+        bool empty;
+        {
+            std::lock_guard<std::mutex> lock(devices_mutex);
+            empty = devices.empty();
+        }
+        if (empty) {
+            add_device("{mock.capture.0}", "Mock Microphone", "Mock capture device");
+            add_device("{mock.capture.1}", "Mock Headset", "Mock capture device");
+        }
+        return true;
+    }
+
+    std::vector<AudioDevice> enumerate_devices() override {
+        std::lock_guard<std::mutex> lock(devices_mutex);
+        std::vector<AudioDevice> result;
+        result.reserve(devices.size());
+        for (const auto& d : devices) {
+            // Like WASAPI, only active devices are listed
+            std::lock_guard<std::mutex> state_lock(d->mutex);
+            if (!d->info.is_enabled) continue;
+            AudioDevice info = d->info;
+            info.is_default = (info.id == default_id);
+            result.push_back(info);
+        }
+        return result;
+    }
+
+    std::unique_ptr<CaptureEndpoint> open_default_device() override {
+        std::string id;
+        {
+            std::lock_guard<std::mutex> lock(devices_mutex);
+            id = default_id;
+        }
+        return open_device(id);
+    }
+
+    std::unique_ptr<CaptureEndpoint> open_device(const std::string& id) override {
+        auto state = find(id);
+        if (!state || !state->info.is_enabled) return nullptr;
+        return std::make_unique<MockEndpoint>(state);
+    }
+
+    bool describe_device(const std::string& id, AudioDevice& device) override {
+        auto state = find(id);
+        if (!state) return false;
+
+        std::string current_default = default_device_id();
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (!state->info.is_enabled) return false;
+        device = state->info;
+        device.is_default = (id == current_default);
+        return true;
+    }
+
+    std::string default_device_id() override {
+        std::lock_guard<std::mutex> lock(devices_mutex);
+        return default_id;
+    }
+
+    bool subscribe_devices(DeviceChangeHandler handler) override {
+        std::lock_guard<std::mutex> lock(devices_mutex);
+        device_handler = std::move(handler);
+        return true;
+    }
+
+    // --- Test controls ---
+
+    // The first device added becomes the default
+    void add_device(const std::string& id, const std::string& device_name,
+        const std::string& description = "", bool muted = false) {
+        auto state = std::make_shared<DeviceState>();
+        state->info.id = id;
+        state->info.name = device_name;
+        state->info.description = description;
+        state->info.is_enabled = true;
+        state->muted = muted;
+
+        bool became_default;
+        {
+            std::lock_guard<std::mutex> lock(devices_mutex);
+            devices.push_back(state);
+            became_default = default_id.empty();
+            if (became_default) default_id = id;
+        }
+
+        notify(DeviceEvent::Added, id);
+        if (became_default) notify(DeviceEvent::DefaultChanged, id);
+    }
+
+    void set_default_device(const std::string& id) {
+        {
+            std::lock_guard<std::mutex> lock(devices_mutex);
+            default_id = id;
+        }
+        notify(DeviceEvent::DefaultChanged, id);
+    }
+
+    // Simulates unplugging and replugging, opened endpoints fail while disabled
+    void set_device_enabled(const std::string& id, bool enabled) {
+        auto state = find(id);
+        if (!state) return;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->info.is_enabled = enabled;
+        }
+        notify(DeviceEvent::StateChanged, id);
+    }
+
+    // Simulates another application changing the mute state
+    void inject_mute_change(const std::string& id, bool muted) {
+        if (auto state = find(id)) {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (state->muted == muted) return;
+            state->muted = muted;
+            for (auto* h : state->handlers) (*h)(muted, false);
+        }
+    }
+
+    bool device_muted(const std::string& id) const {
+        auto state = find(id);
+        if (!state) return false;
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return state->muted;
+    }
+
+    unsigned long set_mute_calls(const std::string& id) const {
+        auto state = find(id);
+        if (!state) return 0;
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return state->set_mute_calls;
+    }
+};
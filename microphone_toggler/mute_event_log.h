@@ -0,0 +1,236 @@
+#pragma once
+
+// Record of every mute change, to show afterwards who was muted when.
+// Fixed-size records in a ring inside one mapped file: disk use is bounded
+// (CAPACITY records of 64 bytes, 4 MB) and the oldest records go first.
+// Portable, no platform headers: the caller maps the file, miclog reads it.
+//
+// Layout, little-endian:
+//   header   magic "MICE", version, record size, capacity, next sequence
+//   records  CAPACITY slots, sequence n lives in slot (n - 1) % CAPACITY
+// Appending is lock-free from any thread: one fetch_add claims a sequence,
+// then the record is copied into its slot. Every record carries its
+// sequence and a checksum, so a reader skips a record that was half written
+// when it looked (or when the process died) and one left from an older lap.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+const uint32_t MUTE_EVENT_LOG_MAGIC = 0x4543494D; // "MICE"
+const uint16_t MUTE_EVENT_LOG_VERSION = 1;
+const uint32_t MUTE_EVENT_LOG_CAPACITY = 65536;
+const size_t MUTE_EVENT_DEVICE_NAME = 36;
+
+// Where a change came from
+enum class MuteSource : uint8_t {
+    Unknown,
+    Hotkey,
+    Tray,
+    Control,       // named pipe, mictoggle
+    VoiceActivity,
+    External,      // another application or the Windows mixer
+    Exit,          // unmute_on_exit
+    Recovery       // the reconcile after an unclean shutdown
+};
+
+const MuteSource MUTE_SOURCES[] = {
+    MuteSource::Unknown, MuteSource::Hotkey, MuteSource::Tray, MuteSource::Control,
+    MuteSource::VoiceActivity, MuteSource::External, MuteSource::Exit, MuteSource::Recovery
+};
+
+inline const char* mute_source_name(MuteSource source) {
+    switch (source) {
+    case MuteSource::Unknown: return "unknown";
+    case MuteSource::Hotkey: return "hotkey";
+    case MuteSource::Tray: return "tray";
+    case MuteSource::Control: return "control";
+    case MuteSource::VoiceActivity: return "voice";
+    case MuteSource::External: return "external";
+    case MuteSource::Exit: return "exit";
+    case MuteSource::Recovery: return "recovery";
+    }
+    return "unknown";
+}
+
+enum MuteEventFlags : uint8_t {
+    MUTE_EVENT_FAILED = 1 << 0 // the device refused, muted is what it still is
+};
+
+struct MuteEventLogHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t capacity;
+    uint32_t reserved;
+    std::atomic<uint64_t> next; // sequences handed out so far
+    char padding[40];
+};
+
+struct MuteEventRecord {
+    uint64_t sequence;   // from 1
+    int64_t time_us;     // since 1970-01-01 UTC
+    uint32_t device_hash; // FNV-1a of the endpoint id
+    uint8_t was_muted;
+    uint8_t muted;
+    uint8_t source;      // MuteSource
+    uint8_t flags;       // MuteEventFlags
+    char device[MUTE_EVENT_DEVICE_NAME]; // name, truncated, zero padded
+    uint32_t checksum;   // FNV-1a of everything before it
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the sequence counter lives in the mapped file");
+static_assert(sizeof(MuteEventLogHeader) == 64, "MuteEventLogHeader is a file format");
+static_assert(sizeof(MuteEventRecord) == 64, "MuteEventRecord is a file format");
+
+inline uint32_t mute_event_hash(const char* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (uint8_t)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+inline uint32_t mute_event_checksum(const MuteEventRecord& record) {
+    return mute_event_hash((const char*)&record, offsetof(MuteEventRecord, checksum));
+}
+
+inline int64_t mute_event_now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// One change of one device, as handed to append()
+struct MuteEvent {
+    std::string_view device_id;
+    std::string_view device_name;
+    bool was_muted = false;
+    bool muted = false;
+    MuteSource source = MuteSource::Unknown;
+    bool failed = false;
+    int64_t time_us = 0; // 0 = now
+};
+
+class MuteEventLog {
+public:
+    static const size_t FILE_SIZE = sizeof(MuteEventLogHeader) + (size_t)MUTE_EVENT_LOG_CAPACITY * sizeof(MuteEventRecord);
+
+private:
+    MuteEventLogHeader* header = nullptr;
+    MuteEventRecord* records = nullptr;
+
+public:
+    // memory must stay mapped until detach(). Anything that is not a log
+    // of this version and size starts over empty.
+    bool attach(void* memory, size_t size) {
+        detach();
+        if (!memory || size < FILE_SIZE) return false;
+
+        header = (MuteEventLogHeader*)memory;
+        records = (MuteEventRecord*)((char*)memory + sizeof(MuteEventLogHeader));
+        if (header->magic != MUTE_EVENT_LOG_MAGIC || header->version != MUTE_EVENT_LOG_VERSION ||
+            header->record_size != sizeof(MuteEventRecord) || header->capacity != MUTE_EVENT_LOG_CAPACITY) {
+            memset(memory, 0, FILE_SIZE);
+            header->magic = MUTE_EVENT_LOG_MAGIC;
+            header->version = MUTE_EVENT_LOG_VERSION;
+            header->record_size = sizeof(MuteEventRecord);
+            header->capacity = MUTE_EVENT_LOG_CAPACITY;
+        }
+        return true;
+    }
+
+    void detach() {
+        header = nullptr;
+        records = nullptr;
+    }
+
+    bool attached() const { return header != nullptr; }
+
+    // Any thread, never blocks
+    void append(const MuteEvent& event) {
+        if (!header) return;
+
+        MuteEventRecord record = {};
+        record.sequence = header->next.fetch_add(1, std::memory_order_relaxed) + 1;
+        record.time_us = event.time_us ? event.time_us : mute_event_now_us();
+        record.device_hash = mute_event_hash(event.device_id.data(), event.device_id.size());
+        record.was_muted = event.was_muted;
+        record.muted = event.muted;
+        record.source = (uint8_t)event.source;
+        record.flags = event.failed ? MUTE_EVENT_FAILED : 0;
+        size_t name_length = event.device_name.size() < MUTE_EVENT_DEVICE_NAME ? event.device_name.size() : MUTE_EVENT_DEVICE_NAME;
+        memcpy(record.device, event.device_name.data(), name_length);
+        record.checksum = mute_event_checksum(record);
+
+        memcpy(&records[(record.sequence - 1) % MUTE_EVENT_LOG_CAPACITY], &record, sizeof(record));
+    }
+};
+
+// Reads a copy of the file, or the mapping itself
+class MuteEventReader {
+private:
+    const char* data = nullptr;
+    uint64_t next = 0;
+
+    template<typename T>
+    static T field(const void* bytes, size_t offset) {
+        T value;
+        memcpy(&value, (const char*)bytes + offset, sizeof(value));
+        return value;
+    }
+
+public:
+    // False when the bytes are not a log of this version
+    bool open(const void* bytes, size_t size) {
+        data = nullptr;
+        next = 0;
+        if (!bytes || size < MuteEventLog::FILE_SIZE) return false;
+
+        if (field<uint32_t>(bytes, offsetof(MuteEventLogHeader, magic)) != MUTE_EVENT_LOG_MAGIC ||
+            field<uint16_t>(bytes, offsetof(MuteEventLogHeader, version)) != MUTE_EVENT_LOG_VERSION ||
+            field<uint16_t>(bytes, offsetof(MuteEventLogHeader, record_size)) != sizeof(MuteEventRecord) ||
+            field<uint32_t>(bytes, offsetof(MuteEventLogHeader, capacity)) != MUTE_EVENT_LOG_CAPACITY) {
+            return false;
+        }
+        data = (const char*)bytes;
+        next = field<uint64_t>(bytes, offsetof(MuteEventLogHeader, next));
+        return true;
+    }
+
+    uint64_t appended() const { return next; }
+
+    // The intact records still in the ring, oldest first
+    std::vector<MuteEventRecord> records() const {
+        std::vector<MuteEventRecord> result;
+        if (!data) return result;
+
+        uint64_t last = appended();
+        uint64_t first = last > MUTE_EVENT_LOG_CAPACITY ? last - MUTE_EVENT_LOG_CAPACITY + 1 : 1;
+        result.reserve((size_t)(last - first + 1));
+
+        const char* slots = data + sizeof(MuteEventLogHeader);
+        for (uint32_t slot = 0; slot < MUTE_EVENT_LOG_CAPACITY; slot++) {
+            MuteEventRecord record;
+            memcpy(&record, slots + (size_t)slot * sizeof(MuteEventRecord), sizeof(record));
+            if (record.sequence < first || record.sequence > last) continue;
+            if ((record.sequence - 1) % MUTE_EVENT_LOG_CAPACITY != slot) continue;
+            if (record.checksum != mute_event_checksum(record)) continue;
+            result.push_back(record);
+        }
+        std::sort(result.begin(), result.end(),
+            [](const MuteEventRecord& a, const MuteEventRecord& b) { return a.sequence < b.sequence; });
+        return result;
+    }
+};
+
+inline std::string_view mute_event_device(const MuteEventRecord& record) {
+    size_t length = 0;
+    while (length < MUTE_EVENT_DEVICE_NAME && record.device[length]) length++;
+    return std::string_view(record.device, length);
+}
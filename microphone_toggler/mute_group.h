@@ -0,0 +1,204 @@
+#pragma once
+
+// A set of capture endpoints muted together.
+// With more than one member every extra device gets a parked helper
+// thread, so one set_mute() fans out to all devices at the same moment
+// instead of paying each driver round trip in sequence.
+// Portable, no platform headers.
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio_backend.h"
+
+class MuteGroup {
+public:
+    static const size_t MAX_DEVICES = 8;
+
+    struct Result {
+        size_t count = 0;
+        size_t succeeded = 0;
+        bool ok[MAX_DEVICES] = {};
+        std::chrono::nanoseconds spread{ 0 }; // first to last device completing
+    };
+
+    // Thread hooks let the owner set up per-thread state (e.g. COM)
+    using ThreadHook = std::function<void()>;
+
+private:
+    struct Member {
+        std::shared_ptr<CaptureEndpoint> endpoint;
+        std::string name;
+    };
+
+    std::vector<Member> members;
+    std::atomic<bool> member_muted[MAX_DEVICES];
+    std::atomic<size_t> member_count{ 0 };
+
+    ThreadHook thread_start;
+    ThreadHook thread_stop;
+
+    std::vector<std::thread> helpers;
+    std::mutex mutex;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+    unsigned long generation = 0;
+    size_t remaining = 0;
+    bool pending_mute = false;
+    bool stopping = false;
+    Result* pending_result = nullptr;
+    std::chrono::steady_clock::time_point finished_at[MAX_DEVICES];
+
+    // seen starts at the generation current when the helper was spawned,
+    // so a request issued before the thread gets scheduled is not lost
+    void helper_loop(size_t index, unsigned long seen) {
+        if (thread_start) thread_start();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            start_cv.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) break;
+            seen = generation;
+            bool target = pending_mute;
+
+            lock.unlock();
+            bool ok = members[index].endpoint->set_mute(target);
+            auto now = std::chrono::steady_clock::now();
+            lock.lock();
+
+            pending_result->ok[index] = ok;
+            finished_at[index] = now;
+            if (--remaining == 0) done_cv.notify_one();
+        }
+
+        lock.unlock();
+        if (thread_stop) thread_stop();
+    }
+
+    void stop_helpers() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        start_cv.notify_all();
+        for (auto& t : helpers) t.join();
+        helpers.clear();
+        stopping = false;
+    }
+
+public:
+    MuteGroup(ThreadHook on_thread_start = nullptr, ThreadHook on_thread_stop = nullptr)
+        : thread_start(std::move(on_thread_start)), thread_stop(std::move(on_thread_stop)) {
+        for (auto& m : member_muted) m = false;
+    }
+
+    ~MuteGroup() { clear(); }
+
+    MuteGroup(const MuteGroup&) = delete;
+    MuteGroup& operator=(const MuteGroup&) = delete;
+
+    void clear() {
+        stop_helpers();
+        member_count = 0;
+        for (auto& m : members) m.endpoint->subscribe(nullptr);
+        members.clear();
+    }
+
+    // Extra endpoints beyond MAX_DEVICES are ignored
+    void add(std::shared_ptr<CaptureEndpoint> endpoint, const std::string& name, bool muted) {
+        if (members.size() >= MAX_DEVICES || !endpoint) return;
+
+        stop_helpers();
+        member_muted[members.size()] = muted;
+        members.push_back({ std::move(endpoint), name });
+        member_count = members.size();
+
+        // Member 0 always runs on the calling thread
+        for (size_t i = 1; i < members.size(); i++) {
+            unsigned long start_generation = generation;
+            helpers.emplace_back([this, i, start_generation] { helper_loop(i, start_generation); });
+        }
+    }
+
+    size_t size() const { return members.size(); }
+    bool empty() const { return members.empty(); }
+    CaptureEndpoint& endpoint(size_t index) const { return *members[index].endpoint; }
+    const std::string& name(size_t index) const { return members[index].name; }
+
+    bool contains(const std::string& id) const {
+        for (const auto& m : members) {
+            if (m.endpoint->id() == id) return true;
+        }
+        return false;
+    }
+
+    bool is_member_muted(size_t index) const { return index < member_count && member_muted[index]; }
+
+    // Per-member state, may be updated from notification threads
+    void note_mute(size_t index, bool muted) {
+        if (index < member_count) member_muted[index] = muted;
+    }
+
+    bool any_muted() const {
+        size_t count = member_count;
+        for (size_t i = 0; i < count; i++) {
+            if (member_muted[i]) return true;
+        }
+        return false;
+    }
+
+    // The group counts as muted only when every member is
+    bool all_muted() const {
+        size_t count = member_count;
+        if (count == 0) return false;
+        for (size_t i = 0; i < count; i++) {
+            if (!member_muted[i]) return false;
+        }
+        return true;
+    }
+
+    void set_mute(bool muted, Result& result) {
+        result = Result();
+        result.count = members.size();
+        if (members.empty()) return;
+
+        if (members.size() > 1) {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending_mute = muted;
+            pending_result = &result;
+            remaining = members.size() - 1;
+            generation++;
+        }
+        start_cv.notify_all();
+
+        result.ok[0] = members[0].endpoint->set_mute(muted);
+        auto first_done = std::chrono::steady_clock::now();
+        auto last_done = first_done;
+
+        if (members.size() > 1) {
+            std::unique_lock<std::mutex> lock(mutex);
+            done_cv.wait(lock, [&] { return remaining == 0; });
+            pending_result = nullptr;
+
+            for (size_t i = 1; i < members.size(); i++) {
+                if (finished_at[i] < first_done) first_done = finished_at[i];
+                if (finished_at[i] > last_done) last_done = finished_at[i];
+            }
+        }
+
+        result.spread = std::chrono::duration_cast<std::chrono::nanoseconds>(last_done - first_done);
+        for (size_t i = 0; i < result.count; i++) {
+            if (result.ok[i]) {
+                member_muted[i] = muted;
+                result.succeeded++;
+            }
+        }
+    }
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+// What the hook and UI thread ask the mute worker to do, and how the worker
+// folds a burst of requests into one change. Portable, no platform headers.
+
+// Requests posted from the hook/UI thread to the mute worker
+enum class MuteIntent : unsigned char {
+    Toggle,
+    Mute,
+    Unmute
+};
+
+// Several queued intents folded into one change relative to the
+// authoritative state, an even number of toggles cancels out
+struct MuteChange {
+    bool has_set = false;
+    bool set_value = false;
+    bool flip = false;
+
+    void add(MuteIntent intent) {
+        switch (intent) {
+        case MuteIntent::Toggle: flip = !flip; break;
+        case MuteIntent::Mute: has_set = true; set_value = true; flip = false; break;
+        case MuteIntent::Unmute: has_set = true; set_value = false; flip = false; break;
+        }
+    }
+
+    bool apply(bool current) const {
+        return (has_set ? set_value : current) != flip;
+    }
+
+    bool empty() const { return !has_set && !flip; }
+};
@@ -0,0 +1,173 @@
+#pragma once
+
+// Crash-safe record of the mute state of every controlled device, so a
+// session that ends without cleanup() (crash, kill, power button) can be
+// put right on the next start. Portable, no platform headers: the caller
+// maps a file of FILE_SIZE bytes and hands the memory over.
+//
+// Layout, little-endian, one page:
+//   header  magic "MICJ", version, running flag, slot count
+//   slots   one per device: state word, id length, id bytes
+// Every change is a store into the shared mapping, ordered with release
+// semantics and never flushed: the pages belong to the file cache, so they
+// survive the process being killed at any instruction, and the system
+// writes them back on its own. Only a power loss can lose the last changes.
+//
+// The state of a device is one 32-bit word, a change never tears. A slot is
+// counted only once its id is complete, and the running flag is set after
+// the slots, so a session killed halfway through bind() looks like the one
+// before it.
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+const uint32_t MUTE_JOURNAL_MAGIC = 0x4A43494D; // "MICJ"
+const uint32_t MUTE_JOURNAL_VERSION = 1;
+const size_t MUTE_JOURNAL_SLOTS = 8;
+const size_t MUTE_JOURNAL_MAX_ID = 248;
+
+enum MuteJournalState : uint32_t {
+    JOURNAL_ORIGINAL_MUTED = 1 << 0, // before this program first touched it
+    JOURNAL_MUTED = 1 << 1,          // last state set or seen
+    JOURNAL_PENDING = 1 << 2,        // a change was started and not finished
+    JOURNAL_PENDING_MUTED = 1 << 3   // ... and this was its target
+};
+
+struct MuteJournalHeader {
+    uint32_t magic;
+    uint32_t version;
+    std::atomic<uint32_t> running; // 1 between bind() and close()
+    std::atomic<uint32_t> slot_count;
+};
+
+struct MuteJournalSlot {
+    std::atomic<uint32_t> state;
+    uint32_t id_length;
+    char id[MUTE_JOURNAL_MAX_ID];
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "journal words are shared with the file cache");
+static_assert(sizeof(MuteJournalHeader) == 16, "MuteJournalHeader is a file format");
+static_assert(sizeof(MuteJournalSlot) == 256, "MuteJournalSlot is a file format");
+
+struct MuteJournalEntry {
+    std::string id;
+    bool original_muted = false;
+    bool muted = false;
+    bool pending = false;
+    bool pending_muted = false;
+};
+
+class MuteJournal {
+public:
+    static const size_t FILE_SIZE = sizeof(MuteJournalHeader) + MUTE_JOURNAL_SLOTS * sizeof(MuteJournalSlot);
+
+private:
+    MuteJournalHeader* header = nullptr;
+    MuteJournalSlot* slots = nullptr;
+
+    // Sets the bits in mask to value, other writers may touch other bits
+    void update(size_t slot, uint32_t mask, uint32_t value) {
+        if (!header || slot >= header->slot_count.load(std::memory_order_relaxed)) return;
+        std::atomic<uint32_t>& state = slots[slot].state;
+        uint32_t old = state.load(std::memory_order_relaxed);
+        while (!state.compare_exchange_weak(old, (old & ~mask) | value, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+
+public:
+    // memory must stay mapped until detach(). Anything that is not a journal
+    // of this version is formatted. If the last session never reached
+    // close(), its devices are returned in unfinished; they stay in the file
+    // until the next bind(), so a crash during the reconcile is not lost.
+    bool attach(void* memory, size_t size, std::vector<MuteJournalEntry>& unfinished) {
+        detach();
+        unfinished.clear();
+        if (!memory || size < FILE_SIZE) return false;
+
+        header = (MuteJournalHeader*)memory;
+        slots = (MuteJournalSlot*)((char*)memory + sizeof(MuteJournalHeader));
+
+        if (header->magic != MUTE_JOURNAL_MAGIC || header->version != MUTE_JOURNAL_VERSION) {
+            memset(memory, 0, FILE_SIZE);
+            header->magic = MUTE_JOURNAL_MAGIC;
+            header->version = MUTE_JOURNAL_VERSION;
+            return true;
+        }
+
+        if (header->running.load(std::memory_order_acquire) == 0) return true;
+        uint32_t count = header->slot_count.load(std::memory_order_acquire);
+        if (count > MUTE_JOURNAL_SLOTS) count = 0;
+
+        for (uint32_t i = 0; i < count; i++) {
+            const MuteJournalSlot& slot = slots[i];
+            if (slot.id_length == 0 || slot.id_length > MUTE_JOURNAL_MAX_ID) continue;
+
+            uint32_t state = slot.state.load(std::memory_order_acquire);
+            MuteJournalEntry entry;
+            entry.id.assign(slot.id, slot.id_length);
+            entry.original_muted = (state & JOURNAL_ORIGINAL_MUTED) != 0;
+            entry.muted = (state & JOURNAL_MUTED) != 0;
+            entry.pending = (state & JOURNAL_PENDING) != 0;
+            entry.pending_muted = (state & JOURNAL_PENDING_MUTED) != 0;
+            unfinished.push_back(std::move(entry));
+        }
+        return true;
+    }
+
+    void detach() {
+        header = nullptr;
+        slots = nullptr;
+    }
+
+    bool attached() const { return header != nullptr; }
+
+    // The devices now controlled, in group order, and marks the session
+    // running. Ids longer than a slot are not journaled.
+    void bind(const std::vector<MuteJournalEntry>& devices) {
+        if (!header) return;
+        header->slot_count.store(0, std::memory_order_release);
+
+        uint32_t count = 0;
+        for (const MuteJournalEntry& device : devices) {
+            if (count == MUTE_JOURNAL_SLOTS) break;
+            MuteJournalSlot& slot = slots[count];
+            bool fits = !device.id.empty() && device.id.size() <= MUTE_JOURNAL_MAX_ID;
+            slot.id_length = fits ? (uint32_t)device.id.size() : 0;
+            if (fits) memcpy(slot.id, device.id.data(), device.id.size());
+
+            uint32_t state = 0;
+            if (device.original_muted) state |= JOURNAL_ORIGINAL_MUTED;
+            if (device.muted) state |= JOURNAL_MUTED;
+            slot.state.store(state, std::memory_order_relaxed);
+            count++;
+        }
+
+        header->slot_count.store(count, std::memory_order_release);
+        header->running.store(1, std::memory_order_release);
+    }
+
+    // Around every set_mute: a session killed in between knows which way
+    // the device was going
+    void begin_change(size_t slot, bool muted) {
+        update(slot, JOURNAL_PENDING | JOURNAL_PENDING_MUTED, JOURNAL_PENDING | (muted ? JOURNAL_PENDING_MUTED : 0u));
+    }
+
+    void end_change(size_t slot, bool muted) {
+        update(slot, JOURNAL_PENDING | JOURNAL_PENDING_MUTED | JOURNAL_MUTED, muted ? JOURNAL_MUTED : 0u);
+    }
+
+    // A change made by someone else, any thread
+    void note(size_t slot, bool muted) {
+        update(slot, JOURNAL_MUTED, muted ? JOURNAL_MUTED : 0u);
+    }
+
+    // Clean shutdown, the next attach() finds nothing to reconcile
+    void close() {
+        if (!header) return;
+        header->running.store(0, std::memory_order_release);
+    }
+};
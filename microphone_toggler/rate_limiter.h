@@ -0,0 +1,88 @@
+#pragma once
+
+// Per-source limits on mute requests: a token bucket for each source, so a
+// bouncing key or a script stuck in a loop is throttled while a quick
+// double-tap still goes through.
+// Each bucket is kept as the time its next token becomes free (GCRA): one
+// atomic, so a check is a load and one compare-exchange, safe from the
+// keyboard hook and any other thread at once. The clock is injected, the
+// default one is the steady clock.
+// Portable, no platform headers.
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+struct RateLimit {
+    int interval_ms = 0; // one token every interval_ms, 0 = unlimited
+    int burst = 1;       // tokens that can be saved up, 1 = plain cooldown
+};
+
+inline int64_t rate_limiter_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+class RateLimiter {
+public:
+    using Clock = int64_t (*)(); // nanoseconds, monotonic
+    static const size_t MAX_SOURCES = 8;
+
+private:
+    struct Bucket {
+        std::atomic<int64_t> interval_ns{ 0 };
+        std::atomic<int64_t> tolerance_ns{ 0 }; // (burst - 1) * interval
+        std::atomic<int64_t> next_free{ INT64_MIN }; // the bucket starts full
+    };
+
+    Bucket buckets[MAX_SOURCES];
+    Clock clock;
+
+public:
+    explicit RateLimiter(Clock now = rate_limiter_now_ns) : clock(now) {}
+
+    RateLimiter(const RateLimiter&) = delete;
+    RateLimiter& operator=(const RateLimiter&) = delete;
+
+    // Any thread. The bucket starts over full.
+    void configure(size_t source, RateLimit limit) {
+        if (source >= MAX_SOURCES) return;
+        Bucket& b = buckets[source];
+        int64_t interval = limit.interval_ms > 0 ? (int64_t)limit.interval_ms * 1000000 : 0;
+        int64_t burst = limit.burst > 1 ? limit.burst : 1;
+        b.interval_ns.store(interval, std::memory_order_relaxed);
+        b.tolerance_ns.store((burst - 1) * interval, std::memory_order_relaxed);
+        b.next_free.store(INT64_MIN, std::memory_order_relaxed);
+    }
+
+    // Takes a token if there is one. Any thread, never blocks.
+    bool allow(size_t source) {
+        if (source >= MAX_SOURCES) return true;
+        Bucket& b = buckets[source];
+        int64_t interval = b.interval_ns.load(std::memory_order_relaxed);
+        if (interval == 0) return true;
+        int64_t tolerance = b.tolerance_ns.load(std::memory_order_relaxed);
+
+        int64_t now = clock();
+        int64_t next_free = b.next_free.load(std::memory_order_relaxed);
+        for (;;) {
+            int64_t start = next_free > now ? next_free : now;
+            if (start - now > tolerance) return false;
+            if (b.next_free.compare_exchange_weak(next_free, start + interval, std::memory_order_relaxed)) return true;
+        }
+    }
+
+    // How long until allow() would succeed, 0 = now
+    int64_t wait_ns(size_t source) const {
+        if (source >= MAX_SOURCES) return 0;
+        const Bucket& b = buckets[source];
+        if (b.interval_ns.load(std::memory_order_relaxed) == 0) return 0;
+
+        int64_t next_free = b.next_free.load(std::memory_order_relaxed);
+        int64_t now = clock();
+        if (next_free <= now) return 0;
+        int64_t wait = next_free - now - b.tolerance_ns.load(std::memory_order_relaxed);
+        return wait > 0 ? wait : 0;
+    }
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+// Low-latency notification sound playback.
+// Sounds are decoded once, converted to the output format and pre-scaled,
+// then played from memory through a wave-out stream that stays open.
+
+#include <windows.h>
+#include <mmsystem.h>
+#include <string>
+
+#include "gain.h"
+#include "wav_decoder.h"
+
+class SoundPlayer {
+public:
+    enum SoundId {
+        MUTE_SOUND = 0,
+        UNMUTE_SOUND = 1,
+        SOUND_COUNT
+    };
+
+    static const unsigned OUTPUT_SAMPLE_RATE = 48000;
+    static const unsigned OUTPUT_CHANNELS = 2;
+
+private:
+    struct LoadedSound {
+        PcmSound pcm;
+        WAVEHDR header;
+        bool prepared = false;
+    };
+
+    HWAVEOUT wave_out = nullptr;
+    LoadedSound sounds[SOUND_COUNT];
+
+    void unload(SoundId id) {
+        LoadedSound& sound = sounds[id];
+        if (sound.prepared) {
+            waveOutUnprepareHeader(wave_out, &sound.header, sizeof(WAVEHDR));
+            sound.prepared = false;
+        }
+        sound.pcm = PcmSound();
+    }
+
+public:
+    SoundPlayer() = default;
+    ~SoundPlayer() { close(); }
+
+    SoundPlayer(const SoundPlayer&) = delete;
+    SoundPlayer& operator=(const SoundPlayer&) = delete;
+
+    bool open() {
+        if (wave_out) return true;
+
+        WAVEFORMATEX format = {};
+        format.wFormatTag = WAVE_FORMAT_PCM;
+        format.nChannels = OUTPUT_CHANNELS;
+        format.nSamplesPerSec = OUTPUT_SAMPLE_RATE;
+        format.wBitsPerSample = 16;
+        format.nBlockAlign = format.nChannels * format.wBitsPerSample / 8;
+        format.nAvgBytesPerSec = format.nSamplesPerSec * format.nBlockAlign;
+
+        return waveOutOpen(&wave_out, WAVE_MAPPER, &format, 0, 0, CALLBACK_NULL) == MMSYSERR_NOERROR;
+    }
+
+    void close() {
+        if (!wave_out) return;
+
+        waveOutReset(wave_out);
+        for (int i = 0; i < SOUND_COUNT; i++) {
+            unload((SoundId)i);
+        }
+        waveOutClose(wave_out);
+        wave_out = nullptr;
+    }
+
+    // Decodes the file into the output format and bakes the gain into the
+    // samples. Touches no device, so it may run on any thread. An empty file
+    // name or zero gain gives an empty sound, which plays as silence.
+    static bool decode(const std::string& file, float gain, PcmSound& out) {
+        out = PcmSound();
+        if (file.empty() || gain <= 0.0f) return true;
+
+        PcmSound decoded;
+        if (!load_wav_file(file, decoded)) return false;
+
+        out = convert_pcm(decoded, OUTPUT_SAMPLE_RATE, OUTPUT_CHANNELS);
+        if (out.empty()) return false;
+
+        apply_gain_int16(out.samples.data(), out.samples.size(), gain);
+        return true;
+    }
+
+    bool load(SoundId id, const std::string& file, float gain) {
+        PcmSound pcm;
+        if (!decode(file, gain, pcm)) {
+            load_decoded(id, PcmSound());
+            return false;
+        }
+        return load_decoded(id, std::move(pcm));
+    }
+
+    // Swaps in a sound produced by decode()
+    bool load_decoded(SoundId id, PcmSound pcm) {
+        if (!wave_out) return false;
+
+        waveOutReset(wave_out);
+        unload(id);
+        if (pcm.empty()) return true;
+
+        LoadedSound& sound = sounds[id];
+        sound.pcm = std::move(pcm);
+
+        memset(&sound.header, 0, sizeof(WAVEHDR));
+        sound.header.lpData = (LPSTR)sound.pcm.samples.data();
+        sound.header.dwBufferLength = (DWORD)(sound.pcm.samples.size() * sizeof(int16_t));
+        sound.prepared = waveOutPrepareHeader(wave_out, &sound.header, sizeof(WAVEHDR)) == MMSYSERR_NOERROR;
+        return sound.prepared;
+    }
+
+    // Interrupts whatever is playing and starts the sound from memory
+    bool play(SoundId id) {
+        LoadedSound& sound = sounds[id];
+        if (!wave_out || !sound.prepared) return false;
+
+        waveOutReset(wave_out);
+        return waveOutWrite(wave_out, &sound.header, sizeof(WAVEHDR)) == MMSYSERR_NOERROR;
+    }
+};
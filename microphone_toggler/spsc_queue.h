@@ -0,0 +1,48 @@
+#pragma once
+
+// Bounded lock-free single-producer/single-consumer ring buffer.
+// push() is wait-free and never allocates, so it is safe to call from the
+// low-level keyboard hook. Portable, no platform headers.
+
+#include <atomic>
+#include <cstddef>
+
+template<typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+private:
+    static constexpr size_t MASK = Capacity - 1;
+
+    // Producer and consumer indices live on separate cache lines
+    alignas(64) std::atomic<size_t> head{ 0 }; // next slot to read
+    alignas(64) std::atomic<size_t> tail{ 0 }; // next slot to write
+    alignas(64) T slots[Capacity];
+
+public:
+    // Producer side, returns false when the queue is full
+    bool push(const T& value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        slots[t & MASK] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side, returns false when the queue is empty
+    bool pop(T& value) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = slots[h & MASK];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+// Structured log for unattended runs. Portable, no platform headers.
+// One logfmt line per event, easy to grep and to feed to log shippers:
+//   time=2026-10-15T09:12:03.481Z level=error event=device_not_found device="USB Mic" message="..."
+// Values with spaces, quotes or '=' are quoted, line breaks become \n.
+
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <initializer_list>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+
+enum class LogLevel : unsigned char {
+    Info,
+    Warning,
+    Error
+};
+
+inline const char* log_level_name(LogLevel level) {
+    switch (level) {
+    case LogLevel::Info: return "info";
+    case LogLevel::Warning: return "warning";
+    case LogLevel::Error: return "error";
+    }
+    return "unknown";
+}
+
+typedef std::pair<const char*, std::string> LogField;
+
+inline void append_log_value(std::string& line, const std::string& value) {
+    bool quote = value.empty();
+    for (char c : value) {
+        if (c == ' ' || c == '"' || c == '=' || c == '\n' || c == '\r' || c == '\t') quote = true;
+    }
+    if (!quote) {
+        line += value;
+        return;
+    }
+
+    line += '"';
+    for (char c : value) {
+        switch (c) {
+        case '"': line += "\\\""; break;
+        case '\\': line += "\\\\"; break;
+        case '\n': line += "\\n"; break;
+        case '\r': break;
+        case '\t': line += ' '; break;
+        default: line += c; break;
+        }
+    }
+    line += '"';
+}
+
+// UTC with milliseconds, e.g. 2026-10-15T09:12:03.481Z
+inline std::string log_timestamp() {
+    auto now = std::chrono::system_clock::now();
+    std::time_t seconds = std::chrono::system_clock::to_time_t(now);
+    long long millis = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000;
+
+    std::tm utc = {};
+#if defined(_WIN32)
+    gmtime_s(&utc, &seconds);
+#else
+    gmtime_r(&seconds, &utc);
+#endif
+    char text[32];
+    size_t length = std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%S", &utc);
+    snprintf(text + length, sizeof(text) - length, ".%03lldZ", millis);
+    return text;
+}
+
+class StructuredLog {
+private:
+    std::mutex mutex;
+    std::ofstream file;
+    std::ostream* mirror = nullptr;
+
+public:
+    // Appends to path, mirror (e.g. std::cerr) gets every line as well
+    bool open(const std::string& path, std::ostream* also_to = nullptr) {
+        std::lock_guard<std::mutex> lock(mutex);
+        file.open(path, std::ios::app);
+        mirror = also_to;
+        return file.is_open();
+    }
+
+    bool enabled() const { return file.is_open() || mirror != nullptr; }
+
+    // Any thread
+    void write(LogLevel level, const char* event, std::initializer_list<LogField> fields = {}) {
+        if (!enabled()) return;
+
+        std::string line = "time=" + log_timestamp();
+        line += " level=";
+        line += log_level_name(level);
+        line += " event=";
+        line += event;
+        for (const LogField& field : fields) {
+            line += ' ';
+            line += field.first;
+            line += '=';
+            append_log_value(line, field.second);
+        }
+        line += '\n';
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (file.is_open()) file << line << std::flush;
+        if (mirror) *mirror << line << std::flush;
+    }
+};
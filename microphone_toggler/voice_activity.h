@@ -0,0 +1,247 @@
+#pragma once
+
+// Streaming voice activity detector for automatic muting.
+// Audio is cut into fixed frames; each frame's energy and zero-crossing
+// rate are measured by the widest kernel the CPU supports and compared
+// against an adaptive noise floor. A gate with attack, hangover and
+// release times turns the per-frame decisions into mute/unmute edges.
+// Works in place on the caller's buffer, never allocates. Portable, no
+// platform headers.
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "cpu_features.h"
+
+struct VadFrameStats {
+    double energy = 0.0;     // sum of squares
+    uint32_t crossings = 0;  // sign changes, including the one into samples[0]
+};
+
+// previous is the sample before samples[0], for the first crossing
+typedef void (*VadKernel)(const float* samples, size_t count, float previous, VadFrameStats& stats);
+
+inline void vad_stats_scalar(const float* samples, size_t count, float previous, VadFrameStats& stats) {
+    float energy = 0.0f;
+    uint32_t crossings = 0;
+    bool negative = std::signbit(previous);
+    for (size_t i = 0; i < count; i++) {
+        float v = samples[i];
+        energy += v * v;
+        bool now_negative = std::signbit(v);
+        crossings += (now_negative != negative);
+        negative = now_negative;
+    }
+    stats.energy += energy;
+    stats.crossings += crossings;
+}
+
+#if MIC_X86
+// Set bits in a 4-bit movemask
+inline uint32_t vad_mask_bits(int mask) {
+    static const uint8_t bits[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+    return bits[mask & 0xF];
+}
+
+inline void vad_stats_sse2(const float* samples, size_t count, float previous, VadFrameStats& stats) {
+    if (count < 4) {
+        vad_stats_scalar(samples, count, previous, stats);
+        return;
+    }
+
+    __m128 sum = _mm_setzero_ps();
+    uint32_t crossings = 0;
+
+    // The first vector compares against previous, later ones against the
+    // unaligned load one sample back
+    __m128 current = _mm_loadu_ps(samples);
+    __m128 before = _mm_set_ps(samples[2], samples[1], samples[0], previous);
+    sum = _mm_add_ps(sum, _mm_mul_ps(current, current));
+    crossings += vad_mask_bits(_mm_movemask_ps(_mm_xor_ps(current, before)));
+
+    size_t i = 4;
+    for (; i + 4 <= count; i += 4) {
+        current = _mm_loadu_ps(samples + i);
+        before = _mm_loadu_ps(samples + i - 1);
+        sum = _mm_add_ps(sum, _mm_mul_ps(current, current));
+        crossings += vad_mask_bits(_mm_movemask_ps(_mm_xor_ps(current, before)));
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, sum);
+    stats.energy += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    stats.crossings += crossings;
+    vad_stats_scalar(samples + i, count - i, samples[i - 1], stats);
+}
+
+MIC_TARGET_AVX2
+inline void vad_stats_avx2(const float* samples, size_t count, float previous, VadFrameStats& stats) {
+    if (count < 8) {
+        vad_stats_sse2(samples, count, previous, stats);
+        return;
+    }
+
+    __m256 sum = _mm256_setzero_ps();
+    uint32_t crossings = 0;
+
+    // First sample goes through the scalar path so every load can look one back
+    vad_stats_scalar(samples, 1, previous, stats);
+
+    size_t i = 1;
+    for (; i + 8 <= count; i += 8) {
+        __m256 current = _mm256_loadu_ps(samples + i);
+        __m256 before = _mm256_loadu_ps(samples + i - 1);
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(current, current));
+        int mask = _mm256_movemask_ps(_mm256_xor_ps(current, before));
+        crossings += vad_mask_bits(mask) + vad_mask_bits(mask >> 4);
+    }
+
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+    float lanes[4];
+    _mm_storeu_ps(lanes, half);
+    stats.energy += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    stats.crossings += crossings;
+    vad_stats_scalar(samples + i, count - i, samples[i - 1], stats);
+}
+#endif
+
+inline VadKernel select_vad_kernel() {
+#if MIC_X86
+    if (cpu_has_avx2()) return vad_stats_avx2;
+    if (cpu_has_sse2()) return vad_stats_sse2;
+#endif
+    return vad_stats_scalar;
+}
+
+struct VadSettings {
+    int threshold_db = 12;   // speech is this far above the noise floor
+    int attack_ms = 30;      // speech needed before unmuting
+    int hangover_ms = 300;   // pauses shorter than this still count as speech
+    int release_ms = 3000;   // silence after the hangover before muting
+};
+
+class VoiceActivityDetector {
+public:
+    static const unsigned FRAME_MS = 10;
+
+    // Quieter than this is never speech, whatever the noise floor
+    static constexpr float ABSOLUTE_FLOOR_DB = -60.0f;
+    // White noise crosses zero on about half the samples, voiced speech far less
+    static constexpr float MAX_SPEECH_ZCR = 0.35f;
+    // The floor follows quieter frames quickly and creeps up otherwise,
+    // so the pauses between words keep pulling it back down
+    static constexpr float FLOOR_FALL = 0.2f;
+    static constexpr float FLOOR_RISE_DB_PER_SECOND = 3.0f;
+
+private:
+    VadKernel kernel = select_vad_kernel();
+    VadSettings settings;
+    unsigned frame_samples = 480;
+
+    // Current, partially filled frame
+    VadFrameStats frame;
+    unsigned frame_fill = 0;
+    float previous = 0.0f;
+
+    float noise_floor_db = 0.0f;
+    bool floor_known = false;
+
+    bool open = true; // unmuted
+    bool voiced = false;
+    unsigned voiced_ms = 0;
+    unsigned hangover_left_ms = 0;
+    unsigned silent_ms = 0;
+
+    static float to_db(double mean_square) {
+        return 10.0f * std::log10((float)mean_square + 1e-12f);
+    }
+
+    void finish_frame() {
+        float level_db = to_db(frame.energy / frame_samples);
+        float zcr = (float)frame.crossings / frame_samples;
+        frame = VadFrameStats();
+        frame_fill = 0;
+
+        if (!floor_known) {
+            noise_floor_db = level_db;
+            floor_known = true;
+        }
+        else if (level_db < noise_floor_db) {
+            noise_floor_db += (level_db - noise_floor_db) * FLOOR_FALL;
+        }
+        else {
+            noise_floor_db += FLOOR_RISE_DB_PER_SECOND * FRAME_MS / 1000.0f;
+        }
+        if (noise_floor_db < ABSOLUTE_FLOOR_DB - 40.0f) noise_floor_db = ABSOLUTE_FLOOR_DB - 40.0f;
+
+        bool speech = level_db > ABSOLUTE_FLOOR_DB &&
+            level_db > noise_floor_db + settings.threshold_db &&
+            zcr < MAX_SPEECH_ZCR;
+
+        if (speech) {
+            hangover_left_ms = settings.hangover_ms;
+        }
+        else if (hangover_left_ms > 0) {
+            hangover_left_ms = hangover_left_ms > FRAME_MS ? hangover_left_ms - FRAME_MS : 0;
+            speech = true;
+        }
+        voiced = speech;
+
+        if (speech) {
+            voiced_ms += FRAME_MS;
+            silent_ms = 0;
+        }
+        else {
+            voiced_ms = 0;
+            silent_ms += FRAME_MS;
+        }
+
+        if (!open && voiced_ms >= (unsigned)settings.attack_ms) open = true;
+        else if (open && silent_ms >= (unsigned)settings.release_ms) open = false;
+    }
+
+public:
+    // Starts over with an open gate, call before feeding a new stream
+    void configure(unsigned sample_rate, const VadSettings& vad_settings) {
+        settings = vad_settings;
+        frame_samples = sample_rate * FRAME_MS / 1000;
+        if (frame_samples == 0) frame_samples = 1;
+        reset();
+    }
+
+    void reset() {
+        frame = VadFrameStats();
+        frame_fill = 0;
+        previous = 0.0f;
+        floor_known = false;
+        open = true;
+        voiced = false;
+        voiced_ms = 0;
+        hangover_left_ms = 0;
+        silent_ms = 0;
+    }
+
+    // Mono samples in [-1, 1]. True when the gate changed during this call;
+    // with a long buffer only the final state is reported.
+    bool process(const float* samples, size_t count) {
+        bool was_open = open;
+        while (count > 0) {
+            size_t take = frame_samples - frame_fill;
+            if (take > count) take = count;
+
+            kernel(samples, take, previous, frame);
+            previous = samples[take - 1];
+            frame_fill += (unsigned)take;
+            samples += take;
+            count -= take;
+
+            if (frame_fill == frame_samples) finish_frame();
+        }
+        return open != was_open;
+    }
+
+    bool gate_open() const { return open; }
+    bool speech_detected() const { return voiced; }
+    float noise_floor() const { return noise_floor_db; }
+};
@@ -0,0 +1,524 @@
+#pragma once
+
+// WASAPI (Core Audio) implementation of the capture endpoint backend
+
+#include <windows.h>
+#include <mmdeviceapi.h>
+#include <mmreg.h>
+#include <audioclient.h>
+#include <endpointvolume.h>
+#include <functiondiscoverykeys_devpkey.h>
+#include <ksmedia.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "audio_backend.h"
+#include "win_utils.h"
+
+// Event context passed to SetMute so our own changes can be told apart
+// from the ones made by other applications
+static const GUID MUTE_EVENT_CONTEXT =
+{ 0x5f2a8c41, 0x7d3e, 0x4b9a, { 0x9e, 0x61, 0x2c, 0x84, 0x1f, 0x0b, 0x6d, 0x37 } };
+
+// Shared-mode, event-driven capture on its own thread. Each packet is
+// downmixed to mono float in a buffer sized once when the stream opens.
+class WasapiCaptureStream : public CaptureStream {
+private:
+    static const REFERENCE_TIME BUFFER_DURATION = 100 * 10000; // 100 ms
+
+    ComPtr<IAudioClient> audio_client;
+    ComPtr<IAudioCaptureClient> capture_client;
+    HANDLE sample_event = nullptr;
+    HANDLE stop_event = nullptr;
+    unsigned rate = 0;
+    unsigned channels = 0;
+    bool float_samples = false; // otherwise 16-bit PCM
+    std::vector<float> mono;
+    CaptureSampleHandler handler;
+    std::thread thread;
+
+    // Silent packets carry no data worth reading, they become zeros
+    void deliver(const BYTE* data, UINT32 frames, bool silent) {
+        while (frames > 0) {
+            UINT32 count = frames < (UINT32)mono.size() ? frames : (UINT32)mono.size();
+            if (silent) {
+                std::fill(mono.begin(), mono.begin() + count, 0.0f);
+            }
+            else if (float_samples) {
+                const float* in = (const float*)data;
+                float scale = 1.0f / channels;
+                for (UINT32 i = 0; i < count; i++) {
+                    float sum = 0.0f;
+                    for (unsigned c = 0; c < channels; c++) sum += in[i * channels + c];
+                    mono[i] = sum * scale;
+                }
+                data += count * channels * sizeof(float);
+            }
+            else {
+                const int16_t* in = (const int16_t*)data;
+                float scale = 1.0f / (32768.0f * channels);
+                for (UINT32 i = 0; i < count; i++) {
+                    int sum = 0;
+                    for (unsigned c = 0; c < channels; c++) sum += in[i * channels + c];
+                    mono[i] = sum * scale;
+                }
+                data += count * channels * sizeof(int16_t);
+            }
+
+            handler(mono.data(), count);
+            frames -= count;
+        }
+    }
+
+    void capture_loop() {
+        HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+        bool thread_com = SUCCEEDED(hr);
+
+        HANDLE handles[2] = { stop_event, sample_event };
+        bool running = true;
+        while (running && WaitForMultipleObjects(2, handles, FALSE, INFINITE) == WAIT_OBJECT_0 + 1) {
+            UINT32 packet = 0;
+            while (running && SUCCEEDED(capture_client->GetNextPacketSize(&packet)) && packet > 0) {
+                BYTE* data;
+                UINT32 frames;
+                DWORD flags;
+                if (FAILED(capture_client->GetBuffer(&data, &frames, &flags, nullptr, nullptr))) {
+                    running = false; // device went away, a reselect opens a new stream
+                    break;
+                }
+                deliver(data, frames, (flags & AUDCLNT_BUFFERFLAGS_SILENT) != 0);
+                capture_client->ReleaseBuffer(frames);
+            }
+        }
+
+        if (thread_com) CoUninitialize();
+    }
+
+public:
+    WasapiCaptureStream() = default;
+
+    ~WasapiCaptureStream() override {
+        stop();
+        if (sample_event) CloseHandle(sample_event);
+        if (stop_event) CloseHandle(stop_event);
+    }
+
+    WasapiCaptureStream(const WasapiCaptureStream&) = delete;
+    WasapiCaptureStream& operator=(const WasapiCaptureStream&) = delete;
+
+    // Only 32-bit float and 16-bit PCM mix formats are accepted
+    bool open(IMMDevice* device) {
+        HRESULT hr = device->Activate(__uuidof(IAudioClient), CLSCTX_ALL,
+            nullptr, (void**)audio_client.GetAddressOf());
+        if (FAILED(hr)) return false;
+
+        WAVEFORMATEX* format = nullptr;
+        if (FAILED(audio_client->GetMixFormat(&format))) return false;
+
+        WORD tag = format->wFormatTag;
+        if (tag == WAVE_FORMAT_EXTENSIBLE) {
+            const WAVEFORMATEXTENSIBLE* extensible = (const WAVEFORMATEXTENSIBLE*)format;
+            tag = IsEqualGUID(extensible->SubFormat, KSDATAFORMAT_SUBTYPE_IEEE_FLOAT) ? WAVE_FORMAT_IEEE_FLOAT :
+                IsEqualGUID(extensible->SubFormat, KSDATAFORMAT_SUBTYPE_PCM) ? WAVE_FORMAT_PCM : 0;
+        }
+        float_samples = (tag == WAVE_FORMAT_IEEE_FLOAT && format->wBitsPerSample == 32);
+        bool pcm16 = (tag == WAVE_FORMAT_PCM && format->wBitsPerSample == 16);
+        rate = format->nSamplesPerSec;
+        channels = format->nChannels;
+
+        if ((float_samples || pcm16) && channels > 0) {
+            hr = audio_client->Initialize(AUDCLNT_SHAREMODE_SHARED, AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
+                BUFFER_DURATION, 0, format, nullptr);
+        }
+        else {
+            hr = E_FAIL;
+        }
+        CoTaskMemFree(format);
+        if (FAILED(hr)) return false;
+
+        UINT32 buffer_frames;
+        sample_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+        stop_event = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+        if (!sample_event || !stop_event ||
+            FAILED(audio_client->SetEventHandle(sample_event)) ||
+            FAILED(audio_client->GetBufferSize(&buffer_frames)) ||
+            FAILED(audio_client->GetService(__uuidof(IAudioCaptureClient), (void**)capture_client.GetAddressOf()))) {
+            return false;
+        }
+
+        mono.resize(buffer_frames ? buffer_frames : 1);
+        return true;
+    }
+
+    unsigned sample_rate() const override { return rate; }
+
+    bool start(CaptureSampleHandler on_samples) override {
+        stop();
+        if (!capture_client || !on_samples) return false;
+
+        handler = std::move(on_samples);
+        ResetEvent(stop_event);
+        if (FAILED(audio_client->Start())) return false;
+        thread = std::thread([this] { capture_loop(); });
+        return true;
+    }
+
+    void stop() override {
+        if (!thread.joinable()) return;
+        SetEvent(stop_event);
+        thread.join();
+        audio_client->Stop();
+        handler = nullptr;
+    }
+};
+
+class WasapiCaptureEndpoint : public CaptureEndpoint {
+private:
+    // Receives IAudioEndpointVolume notifications on a system thread
+    class VolumeCallback : public IAudioEndpointVolumeCallback {
+    private:
+        std::atomic<ULONG> ref_count{ 1 };
+        std::mutex handler_mutex;
+        MuteChangeHandler handler;
+
+    public:
+        void set_handler(MuteChangeHandler h) {
+            std::lock_guard<std::mutex> lock(handler_mutex);
+            handler = std::move(h);
+        }
+
+        HRESULT STDMETHODCALLTYPE OnNotify(PAUDIO_VOLUME_NOTIFICATION_DATA data) override {
+            if (!data) return E_INVALIDARG;
+            std::lock_guard<std::mutex> lock(handler_mutex);
+            if (handler) {
+                handler(data->bMuted != FALSE, IsEqualGUID(data->guidEventContext, MUTE_EVENT_CONTEXT) != FALSE);
+            }
+            return S_OK;
+        }
+
+        ULONG STDMETHODCALLTYPE AddRef() override { return ++ref_count; }
+
+        ULONG STDMETHODCALLTYPE Release() override {
+            ULONG count = --ref_count;
+            if (count == 0) delete this;
+            return count;
+        }
+
+        HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object) override {
+            if (!object) return E_POINTER;
+            if (IsEqualIID(riid, __uuidof(IUnknown)) || IsEqualIID(riid, __uuidof(IAudioEndpointVolumeCallback))) {
+                AddRef();
+                *object = static_cast<IAudioEndpointVolumeCallback*>(this);
+                return S_OK;
+            }
+            *object = nullptr;
+            return E_NOINTERFACE;
+        }
+    };
+
+    std::string device_id;
+    ComPtr<IMMDevice> device;
+    ComPtr<IAudioEndpointVolume> endpoint_volume;
+    ComPtr<VolumeCallback> callback;
+    bool callback_registered = false;
+
+public:
+    WasapiCaptureEndpoint(std::string id, ComPtr<IMMDevice>&& dev, ComPtr<IAudioEndpointVolume>&& volume)
+        : device_id(std::move(id)), device(std::move(dev)), endpoint_volume(std::move(volume)) {
+    }
+
+    ~WasapiCaptureEndpoint() override {
+        if (callback_registered) {
+            endpoint_volume->UnregisterControlChangeNotify(callback.Get());
+        }
+    }
+
+    const std::string& id() const override { return device_id; }
+
+    bool get_mute(bool& muted) override {
+        BOOL value;
+        if (FAILED(endpoint_volume->GetMute(&value))) return false;
+        muted = value != FALSE;
+        return true;
+    }
+
+    bool set_mute(bool muted) override {
+        return SUCCEEDED(endpoint_volume->SetMute(muted ? TRUE : FALSE, &MUTE_EVENT_CONTEXT));
+    }
+
+    bool subscribe(MuteChangeHandler handler) override {
+        if (!handler) {
+            if (callback) callback->set_handler(nullptr);
+            return true;
+        }
+
+        if (!callback) {
+            callback = ComPtr<VolumeCallback>(new VolumeCallback());
+        }
+        callback->set_handler(std::move(handler));
+
+        if (!callback_registered) {
+            callback_registered = SUCCEEDED(endpoint_volume->RegisterControlChangeNotify(callback.Get()));
+        }
+        return callback_registered;
+    }
+
+    std::unique_ptr<CaptureStream> open_stream() override {
+        auto stream = std::make_unique<WasapiCaptureStream>();
+        if (!stream->open(device.Get())) return nullptr;
+        return stream;
+    }
+};
+
+class WasapiAudioBackend : public AudioBackend {
+private:
+    // Receives IMMNotificationClient callbacks on a system thread
+    class DeviceNotificationClient : public IMMNotificationClient {
+    private:
+        std::atomic<ULONG> ref_count{ 1 };
+        std::mutex handler_mutex;
+        DeviceChangeHandler handler;
+
+        void notify(DeviceEvent event, LPCWSTR id) {
+            std::lock_guard<std::mutex> lock(handler_mutex);
+            if (handler) handler(event, id ? wstring_to_string(id) : std::string());
+        }
+
+    public:
+        void set_handler(DeviceChangeHandler h) {
+            std::lock_guard<std::mutex> lock(handler_mutex);
+            handler = std::move(h);
+        }
+
+        HRESULT STDMETHODCALLTYPE OnDeviceStateChanged(LPCWSTR id, DWORD) override {
+            notify(DeviceEvent::StateChanged, id);
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE OnDeviceAdded(LPCWSTR id) override {
+            notify(DeviceEvent::Added, id);
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE OnDeviceRemoved(LPCWSTR id) override {
+            notify(DeviceEvent::Removed, id);
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE OnDefaultDeviceChanged(EDataFlow flow, ERole role, LPCWSTR id) override {
+            if (flow == eCapture && role == eConsole) {
+                notify(DeviceEvent::DefaultChanged, id);
+            }
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE OnPropertyValueChanged(LPCWSTR id, const PROPERTYKEY key) override {
+            if (IsEqualGUID(key.fmtid, PKEY_Device_FriendlyName.fmtid) && key.pid == PKEY_Device_FriendlyName.pid) {
+                notify(DeviceEvent::PropertiesChanged, id);
+            }
+            return S_OK;
+        }
+
+        ULONG STDMETHODCALLTYPE AddRef() override { return ++ref_count; }
+
+        ULONG STDMETHODCALLTYPE Release() override {
+            ULONG count = --ref_count;
+            if (count == 0) delete this;
+            return count;
+        }
+
+        HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object) override {
+            if (!object) return E_POINTER;
+            if (IsEqualIID(riid, __uuidof(IUnknown)) || IsEqualIID(riid, __uuidof(IMMNotificationClient))) {
+                AddRef();
+                *object = static_cast<IMMNotificationClient*>(this);
+                return S_OK;
+            }
+            *object = nullptr;
+            return E_NOINTERFACE;
+        }
+    };
+
+    ComPtr<IMMDeviceEnumerator> device_enumerator;
+    ComPtr<DeviceNotificationClient> notification_client;
+    bool notification_registered = false;
+
+    std::unique_ptr<CaptureEndpoint> activate(ComPtr<IMMDevice>&& device) {
+        std::string id;
+        LPWSTR device_id;
+        if (SUCCEEDED(device->GetId(&device_id))) {
+            id = wstring_to_string(device_id);
+            CoTaskMemFree(device_id);
+        }
+
+        // Get endpoint volume interface
+        ComPtr<IAudioEndpointVolume> endpoint_volume;
+        HRESULT hr = device->Activate(__uuidof(IAudioEndpointVolume), CLSCTX_ALL,
+            nullptr, (void**)endpoint_volume.GetAddressOf());
+        if (FAILED(hr)) return nullptr;
+
+        return std::make_unique<WasapiCaptureEndpoint>(std::move(id), std::move(device), std::move(endpoint_volume));
+    }
+
+    // Reads id, names and state. is_default is left to the caller.
+    static void read_device_info(IMMDevice* device, AudioDevice& audio_device) {
+        // Get device ID
+        LPWSTR device_id;
+        if (SUCCEEDED(device->GetId(&device_id))) {
+            audio_device.id = wstring_to_string(device_id);
+            CoTaskMemFree(device_id);
+        }
+
+        // Get device properties
+        ComPtr<IPropertyStore> property_store;
+        if (SUCCEEDED(device->OpenPropertyStore(STGM_READ, property_store.GetAddressOf()))) {
+            PROPVARIANT prop_var;
+            PropVariantInit(&prop_var);
+
+            // Get friendly name
+            if (SUCCEEDED(property_store->GetValue(PKEY_Device_FriendlyName, &prop_var))) {
+                if (prop_var.vt == VT_LPWSTR) {
+                    audio_device.name = wstring_to_string(prop_var.pwszVal);
+                }
+                PropVariantClear(&prop_var);
+            }
+
+            // Get device description
+            if (SUCCEEDED(property_store->GetValue(PKEY_Device_DeviceDesc, &prop_var))) {
+                if (prop_var.vt == VT_LPWSTR) {
+                    audio_device.description = wstring_to_string(prop_var.pwszVal);
+                }
+                PropVariantClear(&prop_var);
+            }
+        }
+
+        // Check device state
+        DWORD state;
+        audio_device.is_enabled = SUCCEEDED(device->GetState(&state)) && (state == DEVICE_STATE_ACTIVE);
+    }
+
+public:
+    ~WasapiAudioBackend() override {
+        if (notification_registered) {
+            device_enumerator->UnregisterEndpointNotificationCallback(notification_client.Get());
+        }
+    }
+
+    const char* name() const override { return "wasapi"; }
+
+    bool initialize() override {
+        if (device_enumerator) return true;
+
+        HRESULT hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL,
+            __uuidof(IMMDeviceEnumerator), (void**)device_enumerator.GetAddressOf());
+        return SUCCEEDED(hr);
+    }
+
+    std::vector<AudioDevice> enumerate_devices() override {
+        std::vector<AudioDevice> devices;
+        if (!initialize()) return devices;
+
+        ComPtr<IMMDeviceCollection> device_collection;
+        HRESULT hr = device_enumerator->EnumAudioEndpoints(eCapture, DEVICE_STATE_ACTIVE, device_collection.GetAddressOf());
+        if (FAILED(hr)) return devices;
+
+        // Get default device id once for comparison
+        std::string default_id = default_device_id();
+
+        UINT count;
+        device_collection->GetCount(&count);
+        devices.reserve(count);
+
+        for (UINT i = 0; i < count; i++) {
+            ComPtr<IMMDevice> device;
+            if (SUCCEEDED(device_collection->Item(i, device.GetAddressOf()))) {
+                AudioDevice audio_device;
+                read_device_info(device.Get(), audio_device);
+                audio_device.is_default = !default_id.empty() && audio_device.id == default_id;
+                devices.push_back(audio_device);
+            }
+        }
+
+        return devices;
+    }
+
+    std::unique_ptr<CaptureEndpoint> open_default_device() override {
+        if (!initialize()) return nullptr;
+
+        ComPtr<IMMDevice> device;
+        HRESULT hr = device_enumerator->GetDefaultAudioEndpoint(eCapture, eConsole, device.GetAddressOf());
+        if (FAILED(hr)) return nullptr;
+
+        return activate(std::move(device));
+    }
+
+    std::unique_ptr<CaptureEndpoint> open_device(const std::string& id) override {
+        if (id.empty() || !initialize()) return nullptr;
+
+        ComPtr<IMMDevice> device;
+        std::wstring device_id_wide = string_to_wstring(id);
+        HRESULT hr = device_enumerator->GetDevice(device_id_wide.c_str(), device.GetAddressOf());
+        if (FAILED(hr)) return nullptr;
+
+        return activate(std::move(device));
+    }
+
+    bool describe_device(const std::string& id, AudioDevice& audio_device) override {
+        if (id.empty() || !initialize()) return false;
+
+        ComPtr<IMMDevice> device;
+        std::wstring device_id_wide = string_to_wstring(id);
+        if (FAILED(device_enumerator->GetDevice(device_id_wide.c_str(), device.GetAddressOf()))) return false;
+
+        // Notifications also arrive for render endpoints
+        ComPtr<IMMEndpoint> mm_endpoint;
+        EDataFlow flow;
+        if (FAILED(device->QueryInterface(__uuidof(IMMEndpoint), (void**)mm_endpoint.GetAddressOf())) ||
+            FAILED(mm_endpoint->GetDataFlow(&flow)) || flow != eCapture) {
+            return false;
+        }
+
+        read_device_info(device.Get(), audio_device);
+        if (!audio_device.is_enabled) return false;
+
+        audio_device.is_default = (audio_device.id == default_device_id());
+        return true;
+    }
+
+    std::string default_device_id() override {
+        std::string id;
+        if (!initialize()) return id;
+
+        ComPtr<IMMDevice> default_device;
+        if (SUCCEEDED(device_enumerator->GetDefaultAudioEndpoint(eCapture, eConsole, default_device.GetAddressOf()))) {
+            LPWSTR device_id;
+            if (SUCCEEDED(default_device->GetId(&device_id))) {
+                id = wstring_to_string(device_id);
+                CoTaskMemFree(device_id);
+            }
+        }
+        return id;
+    }
+
+    bool subscribe_devices(DeviceChangeHandler handler) override {
+        if (!initialize()) return false;
+
+        if (!handler) {
+            if (notification_client) notification_client->set_handler(nullptr);
+            return true;
+        }
+
+        if (!notification_client) {
+            notification_client = ComPtr<DeviceNotificationClient>(new DeviceNotificationClient());
+        }
+        notification_client->set_handler(std::move(handler));
+
+        if (!notification_registered) {
+            notification_registered = SUCCEEDED(device_enumerator->RegisterEndpointNotificationCallback(notification_client.Get()));
+        }
+        return notification_registered;
+    }
+};
@@ -0,0 +1,187 @@
+#pragma once
+
+// Minimal RIFF/WAVE decoder producing interleaved 16-bit PCM.
+// Handles 8/16/24/32-bit integer PCM, 32-bit float and WAVE_FORMAT_EXTENSIBLE.
+// Portable, no platform headers.
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+struct PcmSound {
+    unsigned sample_rate = 0;
+    unsigned channels = 0;
+    std::vector<int16_t> samples; // interleaved
+
+    size_t frames() const { return channels ? samples.size() / channels : 0; }
+    bool empty() const { return samples.empty(); }
+};
+
+namespace wav_detail {
+    inline uint16_t read_u16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+    inline uint32_t read_u32(const uint8_t* p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+    const uint16_t FORMAT_PCM = 1;
+    const uint16_t FORMAT_IEEE_FLOAT = 3;
+    const uint16_t FORMAT_EXTENSIBLE = 0xFFFE;
+
+    inline int16_t float_to_int16(float v) {
+        if (v >= 1.0f) return 32767;
+        if (v <= -1.0f) return -32768;
+        return (int16_t)(v * 32767.0f);
+    }
+}
+
+// Decodes an in-memory WAV file. On failure returns false and, if given,
+// fills error with a short reason.
+inline bool decode_wav(const uint8_t* data, size_t size, PcmSound& out, std::string* error = nullptr) {
+    using namespace wav_detail;
+
+    auto fail = [error](const char* reason) {
+        if (error) *error = reason;
+        return false;
+    };
+
+    if (size < 12 || memcmp(data, "RIFF", 4) != 0 || memcmp(data + 8, "WAVE", 4) != 0) {
+        return fail("not a RIFF/WAVE file");
+    }
+
+    uint16_t format = 0, channels = 0, bits = 0, block_align = 0;
+    uint32_t sample_rate = 0;
+    const uint8_t* pcm = nullptr;
+    size_t pcm_size = 0;
+
+    size_t pos = 12;
+    while (pos + 8 <= size) {
+        const uint8_t* chunk = data + pos;
+        size_t chunk_size = read_u32(chunk + 4);
+        size_t body = pos + 8;
+        size_t available = size - body;
+
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            if (chunk_size < 16 || chunk_size > available) return fail("truncated fmt chunk");
+            format = read_u16(chunk + 8);
+            channels = read_u16(chunk + 10);
+            sample_rate = read_u32(chunk + 12);
+            block_align = read_u16(chunk + 20);
+            bits = read_u16(chunk + 22);
+            if (format == FORMAT_EXTENSIBLE) {
+                if (chunk_size < 40) return fail("truncated extensible fmt chunk");
+                format = read_u16(chunk + 8 + 24); // first two bytes of SubFormat GUID
+            }
+        }
+        else if (memcmp(chunk, "data", 4) == 0) {
+            pcm = chunk + 8;
+            pcm_size = chunk_size < available ? chunk_size : available; // tolerate truncated files
+            break;
+        }
+
+        // A chunk running past the end would wrap pos with a 32-bit size_t,
+        // nothing after it can be read anyway. Chunks are word aligned.
+        if (chunk_size > available) break;
+        pos = body + chunk_size + (chunk_size & 1);
+    }
+
+    if (!channels || !sample_rate) return fail("missing fmt chunk");
+    if (!pcm) return fail("missing data chunk");
+
+    size_t bytes_per_sample = bits / 8;
+    bool supported =
+        (format == FORMAT_PCM && (bits == 8 || bits == 16 || bits == 24 || bits == 32)) ||
+        (format == FORMAT_IEEE_FLOAT && bits == 32);
+    if (!supported || block_align != bytes_per_sample * channels) {
+        return fail("unsupported sample format");
+    }
+
+    size_t count = pcm_size / bytes_per_sample;
+    count -= count % channels;
+
+    out.sample_rate = sample_rate;
+    out.channels = channels;
+    out.samples.resize(count);
+    int16_t* dst = out.samples.data();
+
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t* p = pcm + i * bytes_per_sample;
+        switch (bits) {
+        case 8:
+            dst[i] = (int16_t)((p[0] - 128) << 8);
+            break;
+        case 16:
+            dst[i] = (int16_t)read_u16(p);
+            break;
+        case 24:
+            dst[i] = (int16_t)read_u16(p + 1);
+            break;
+        case 32:
+            if (format == FORMAT_IEEE_FLOAT) {
+                float f;
+                uint32_t raw = read_u32(p);
+                memcpy(&f, &raw, sizeof(f));
+                dst[i] = float_to_int16(f);
+            }
+            else {
+                dst[i] = (int16_t)read_u16(p + 2);
+            }
+            break;
+        }
+    }
+
+    return true;
+}
+
+inline bool load_wav_file(const std::string& path, PcmSound& out, std::string* error = nullptr) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        if (error) *error = "cannot open file";
+        return false;
+    }
+
+    std::streamoff size = file.tellg();
+    if (size <= 0) {
+        if (error) *error = "empty file";
+        return false;
+    }
+
+    std::vector<uint8_t> bytes((size_t)size);
+    file.seekg(0);
+    if (!file.read((char*)bytes.data(), size)) {
+        if (error) *error = "read error";
+        return false;
+    }
+
+    return decode_wav(bytes.data(), bytes.size(), out, error);
+}
+
+// Converts to the given rate/channel layout. Mono is duplicated, extra
+// channels are dropped and the rate is changed by linear interpolation.
+inline PcmSound convert_pcm(const PcmSound& in, unsigned sample_rate, unsigned channels) {
+    PcmSound out;
+    out.sample_rate = sample_rate;
+    out.channels = channels;
+
+    size_t in_frames = in.frames();
+    if (!in_frames || !sample_rate || !channels) return out;
+
+    size_t out_frames = (size_t)((uint64_t)in_frames * sample_rate / in.sample_rate);
+    out.samples.resize(out_frames * channels);
+
+    double step = (double)in.sample_rate / sample_rate;
+    for (size_t f = 0; f < out_frames; f++) {
+        double src = f * step;
+        size_t i0 = (size_t)src;
+        size_t i1 = i0 + 1 < in_frames ? i0 + 1 : i0;
+        double frac = src - i0;
+
+        for (unsigned c = 0; c < channels; c++) {
+            unsigned src_c = c < in.channels ? c : in.channels - 1;
+            double a = in.samples[i0 * in.channels + src_c];
+            double b = in.samples[i1 * in.channels + src_c];
+            out.samples[f * channels + c] = (int16_t)(a + (b - a) * frac);
+        }
+    }
+
+    return out;
+}
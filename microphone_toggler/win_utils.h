@@ -0,0 +1,204 @@
+#pragma once
+
+#include <windows.h>
+#include <string>
+
+// RAII wrapper for COM interfaces
+template<typename T>
+class ComPtr {
+private:
+    T* ptr;
+
+public:
+    ComPtr() : ptr(nullptr) {}
+    ComPtr(T* p) : ptr(p) {}
+    ~ComPtr() { Release(); }
+
+    // Move constructor
+    ComPtr(ComPtr&& other) noexcept : ptr(other.ptr) {
+        other.ptr = nullptr;
+    }
+
+    // Move assignment
+    ComPtr& operator=(ComPtr&& other) noexcept {
+        if (this != &other) {
+            Release();
+            ptr = other.ptr;
+            other.ptr = nullptr;
+        }
+        return *this;
+    }
+
+    // Disable copy
+    ComPtr(const ComPtr&) = delete;
+    ComPtr& operator=(const ComPtr&) = delete;
+
+    void Release() {
+        if (ptr) {
+            ptr->Release();
+            ptr = nullptr;
+        }
+    }
+
+    T* Get() const { return ptr; }
+    T** GetAddressOf() { Release(); return &ptr; }
+    T* operator->() const { return ptr; }
+    operator bool() const { return ptr != nullptr; }
+};
+
+inline std::string wstring_to_string(const std::wstring& wstr) {
+    if (wstr.empty()) return std::string();
+
+    int size = WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), -1, nullptr, 0, nullptr, nullptr);
+    std::string result(size - 1, 0);
+    WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), -1, &result[0], size, nullptr, nullptr);
+    return result;
+}
+
+inline std::wstring string_to_wstring(const std::string& str) {
+    if (str.empty()) return std::wstring();
+
+    int size = MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, nullptr, 0);
+    std::wstring result(size - 1, 0);
+    MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, &result[0], size);
+    return result;
+}
+
+// Read-only view of a whole file, closed on destruction
+class MappedFile {
+private:
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+    const void* view = nullptr;
+    size_t length = 0;
+
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path) {
+        close();
+        file = CreateFileW(string_to_wstring(path).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0 || size.QuadPart > 64 * 1024 * 1024) {
+            close();
+            return false;
+        }
+        mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (!view) {
+            close();
+            return false;
+        }
+        length = (size_t)size.QuadPart;
+        return true;
+    }
+
+    void close() {
+        if (view) UnmapViewOfFile(view);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        view = nullptr;
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+        length = 0;
+    }
+
+    const void* data() const { return view; }
+    size_t size() const { return length; }
+};
+
+// Writable shared view of a fixed-size file, created or resized as needed.
+// Stores land in the file cache and reach the disk without any flush, even
+// if the process is killed. Exclusive unless share_read lets readers in.
+class WritableMapping {
+private:
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+    void* view = nullptr;
+    size_t length = 0;
+
+public:
+    WritableMapping() = default;
+    ~WritableMapping() { close(); }
+
+    WritableMapping(const WritableMapping&) = delete;
+    WritableMapping& operator=(const WritableMapping&) = delete;
+
+    bool open(const std::string& path, size_t size, bool share_read = false) {
+        close();
+        file = CreateFileW(string_to_wstring(path).c_str(), GENERIC_READ | GENERIC_WRITE, share_read ? FILE_SHARE_READ : 0,
+            nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER current;
+        if (!GetFileSizeEx(file, &current)) {
+            close();
+            return false;
+        }
+        if ((size_t)current.QuadPart != size) {
+            LARGE_INTEGER wanted;
+            wanted.QuadPart = (LONGLONG)size;
+            if (!SetFilePointerEx(file, wanted, nullptr, FILE_BEGIN) || !SetEndOfFile(file)) {
+                close();
+                return false;
+            }
+        }
+
+        mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, 0, (DWORD)size, nullptr);
+        view = mapping ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size) : nullptr;
+        if (!view) {
+            close();
+            return false;
+        }
+        length = size;
+        return true;
+    }
+
+    // Off the hot path only, e.g. at shutdown: waits for the disk
+    void flush() {
+        if (!view) return;
+        FlushViewOfFile(view, length);
+        FlushFileBuffers(file);
+    }
+
+    void close() {
+        if (view) UnmapViewOfFile(view);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        view = nullptr;
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+        length = 0;
+    }
+
+    void* data() const { return view; }
+    size_t size() const { return length; }
+};
+
+// Writes a sibling temporary file and renames it over path, so readers
+// see the old contents or the new ones, never a torn write
+inline bool write_file_atomically(const std::string& path, const std::string& bytes) {
+    std::wstring target = string_to_wstring(path);
+    std::wstring temporary = target + L".tmp";
+
+    HANDLE file = CreateFileW(temporary.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    DWORD written = 0;
+    bool ok = WriteFile(file, bytes.data(), (DWORD)bytes.size(), &written, nullptr) &&
+        written == bytes.size() && FlushFileBuffers(file);
+    CloseHandle(file);
+
+    if (!ok || !MoveFileExW(temporary.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        DeleteFileW(temporary.c_str());
+        return false;
+    }
+    return true;
+}
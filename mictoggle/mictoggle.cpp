@@ -0,0 +1,164 @@
+// Command-line client for the control pipe of a running microphone_toggler,
+// so scripts and headless setups need neither the tray nor a hotkey:
+//
+//   mictoggle [--pipe NAME] toggle|mute|unmute|status|devices|watch
+//
+// status prints muted or unmuted, devices prints one "id<TAB>name<TAB>flags"
+// line per device and watch prints the state on every change until stopped.
+// Exit codes: 0 done, 1 refused by the server, 2 bad usage, 3 not running.
+
+#include <windows.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+const char* DEFAULT_PIPE = "microphone_toggler"; // control_pipe in mic_config.txt
+const DWORD BUSY_WAIT_MS = 2000;
+
+enum ExitCode {
+    EXIT_DONE = 0,
+    EXIT_REFUSED = 1,
+    EXIT_USAGE = 2,
+    EXIT_NOT_RUNNING = 3
+};
+
+class PipeClient {
+private:
+    HANDLE pipe = INVALID_HANDLE_VALUE;
+    std::string input;
+
+public:
+    ~PipeClient() {
+        if (pipe != INVALID_HANDLE_VALUE) CloseHandle(pipe);
+    }
+
+    bool connect(const std::string& name) {
+        std::wstring path = L"\\\\.\\pipe\\" + std::wstring(name.begin(), name.end());
+        for (;;) {
+            pipe = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+            if (pipe != INVALID_HANDLE_VALUE) return true;
+
+            // Every instance is taken for the moment, the server opens another one
+            if (GetLastError() != ERROR_PIPE_BUSY || !WaitNamedPipeW(path.c_str(), BUSY_WAIT_MS)) return false;
+        }
+    }
+
+    bool send(const char* request) {
+        std::string line = std::string(request) + "\n";
+        DWORD written = 0;
+        return WriteFile(pipe, line.data(), (DWORD)line.size(), &written, nullptr) && written == line.size();
+    }
+
+    // Next reply line without its '\n', false once the server hangs up
+    bool read_line(std::string& line) {
+        size_t end;
+        while ((end = input.find('\n')) == std::string::npos) {
+            char buffer[512];
+            DWORD read = 0;
+            if (!ReadFile(pipe, buffer, sizeof(buffer), &read, nullptr) || read == 0) return false;
+            input.append(buffer, read);
+        }
+        line.assign(input, 0, end);
+        input.erase(0, end + 1);
+        return true;
+    }
+};
+
+static bool starts_with(const std::string& text, const char* prefix) {
+    return text.compare(0, strlen(prefix), prefix) == 0;
+}
+
+// "error <reason>" replies, true when line was one
+static bool report_error(const std::string& line) {
+    if (!starts_with(line, "error ")) return false;
+    fprintf(stderr, "mictoggle: %s\n", line.c_str() + 6);
+    return true;
+}
+
+static int lost_server() {
+    fprintf(stderr, "mictoggle: the connection was closed\n");
+    return EXIT_NOT_RUNNING;
+}
+
+static int run_simple(PipeClient& client, const char* request) {
+    std::string line;
+    if (!client.send(request) || !client.read_line(line)) return lost_server();
+    if (report_error(line)) return EXIT_REFUSED;
+    return EXIT_DONE;
+}
+
+static int run_status(PipeClient& client) {
+    std::string line;
+    if (!client.send("get") || !client.read_line(line)) return lost_server();
+    if (report_error(line)) return EXIT_REFUSED;
+    if (!starts_with(line, "state ")) return EXIT_REFUSED;
+
+    printf("%s\n", line.c_str() + 6);
+    return EXIT_DONE;
+}
+
+static int run_devices(PipeClient& client) {
+    std::string line;
+    if (!client.send("devices")) return lost_server();
+    while (client.read_line(line)) {
+        if (line == "end") return EXIT_DONE;
+        if (report_error(line)) return EXIT_REFUSED;
+        if (starts_with(line, "device\t")) printf("%s\n", line.c_str() + 7);
+    }
+    return lost_server();
+}
+
+// Runs until Ctrl+C or the server exits
+static int run_watch(PipeClient& client) {
+    std::string line;
+    if (!client.send("subscribe")) return lost_server();
+    while (client.read_line(line)) {
+        if (report_error(line)) return EXIT_REFUSED;
+
+        size_t space = line.find(' ');
+        if (space == std::string::npos) continue;
+        printf("%s\n", line.c_str() + space + 1);
+        fflush(stdout);
+    }
+    return EXIT_DONE;
+}
+
+static int usage() {
+    fprintf(stderr,
+        "usage: mictoggle [--pipe NAME] <command>\n"
+        "\n"
+        "  toggle    flip the microphone mute state\n"
+        "  mute      mute the microphone\n"
+        "  unmute    unmute the microphone\n"
+        "  status    print muted or unmuted\n"
+        "  devices   list capture devices as id, name and flags\n"
+        "  watch     print the state on every change\n");
+    return EXIT_USAGE;
+}
+
+int main(int argc, char** argv) {
+    std::string pipe_name = DEFAULT_PIPE;
+    const char* command = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--pipe") == 0 && i + 1 < argc) pipe_name = argv[++i];
+        else if (!command && argv[i][0] != '-') command = argv[i];
+        else return usage();
+    }
+    if (!command) return usage();
+
+    bool simple = strcmp(command, "toggle") == 0 || strcmp(command, "mute") == 0 || strcmp(command, "unmute") == 0;
+    bool known = simple || strcmp(command, "status") == 0 || strcmp(command, "devices") == 0 || strcmp(command, "watch") == 0;
+    if (!known) return usage();
+
+    PipeClient client;
+    if (!client.connect(pipe_name)) {
+        fprintf(stderr, "mictoggle: microphone_toggler is not running (no pipe '%s')\n", pipe_name.c_str());
+        return EXIT_NOT_RUNNING;
+    }
+
+    if (simple) return run_simple(client, command);
+    if (strcmp(command, "status") == 0) return run_status(client);
+    if (strcmp(command, "devices") == 0) return run_devices(client);
+    return run_watch(client);
+}
@@ -0,0 +1,141 @@
+// The toggle path does not touch the heap: a counting operator new watches
+// the queue hand-off, folding and applying a change on mock devices, the
+// latency trace, the rate limiter and the mute event ring once each is set
+// up and has run once.
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "latency_stats.h"
+#include "mock_backend.h"
+#include "mute_event_log.h"
+#include "mute_group.h"
+#include "mute_intent.h"
+#include "rate_limiter.h"
+#include "spsc_queue.h"
+#include "test_check.h"
+
+// Every thread counts, the mute group's helpers too
+static std::atomic<bool> counting{ false };
+static std::atomic<unsigned long> allocations{ 0 };
+
+void* operator new(size_t size) {
+    if (counting.load(std::memory_order_relaxed)) allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+// Allocations made while run() is called rounds times
+template<typename Run>
+static unsigned long allocations_during(int rounds, Run run) {
+    allocations = 0;
+    counting = true;
+    for (int i = 0; i < rounds; i++) run(i);
+    counting = false;
+    return allocations.load();
+}
+
+// Kept in a volatile so the compiler cannot drop the new/delete pair
+static int* volatile kept;
+
+static void test_counter_sees_allocations() {
+    CHECK(allocations_during(3, [](int) { kept = new int(1); delete kept; }) == 3);
+    CHECK(allocations_during(1, [](int) { kept = new int[100]; delete[] kept; }) == 1);
+}
+
+// Same shape as the application's request
+struct Request {
+    MuteIntent intent;
+    MuteSource source;
+    LatencyRecorder::TraceId trace;
+};
+
+static void test_queue() {
+    static SpscQueue<Request, 64> queue;
+    CHECK(allocations_during(1000, [](int i) {
+        queue.push({ i % 3 == 0 ? MuteIntent::Mute : MuteIntent::Toggle, MuteSource::Hotkey, 0 });
+        queue.push({ MuteIntent::Toggle, MuteSource::Tray, 0 });
+        MuteChange change;
+        Request request;
+        while (queue.pop(request)) change.add(request.intent);
+        if (change.apply(i % 2 == 0)) queue.push({ MuteIntent::Unmute, MuteSource::Control, 0 });
+        queue.pop(request);
+    }) == 0);
+}
+
+static void test_mute_group(size_t devices) {
+    MockAudioBackend backend;
+    MuteGroup group;
+    for (size_t i = 0; i < devices; i++) {
+        std::string id = "{mock.alloc." + std::to_string(i) + "}";
+        backend.add_device(id, "Alloc Microphone " + std::to_string(i));
+        group.add(backend.open_device(id), id, false);
+    }
+    int notified = 0;
+    group.endpoint(0).subscribe([&](bool, bool) { notified++; });
+
+    MuteGroup::Result result;
+    group.set_mute(true, result);
+    group.set_mute(false, result);
+
+    CHECK(allocations_during(200, [&](int i) { group.set_mute(i % 2 == 0, result); }) == 0);
+    CHECK(result.succeeded == devices && !group.any_muted());
+    CHECK(notified == 202);
+    group.endpoint(0).subscribe(nullptr);
+}
+
+static void test_latency_trace() {
+    static LatencyRecorder recorder;
+    recorder.complete(recorder.begin(latency_now_ns()));
+    CHECK(allocations_during(1000, [](int) {
+        LatencyRecorder::TraceId trace = recorder.begin(latency_now_ns());
+        recorder.mark(trace, STAGE_DISPATCHED);
+        recorder.mark(trace, STAGE_BACKEND_DONE);
+        recorder.complete(trace);
+    }) == 0);
+    CHECK(recorder.completed() == 1001);
+}
+
+static void test_rate_limiter() {
+    static RateLimiter limiter;
+    limiter.configure(0, { 50, 3 });
+    int allowed = 0;
+    CHECK(allocations_during(1000, [&](int i) { allowed += limiter.allow(i % 2) ? 1 : 0; }) == 0);
+    CHECK(allowed >= 503);
+}
+
+static void test_event_log() {
+    std::vector<uint64_t> memory(MuteEventLog::FILE_SIZE / 8);
+    MuteEventLog log;
+    CHECK(log.attach(memory.data(), MuteEventLog::FILE_SIZE));
+    CHECK(allocations_during(1000, [&](int i) {
+        MuteEvent event;
+        event.device_id = "{0.0.1.00000000}.{headset}";
+        event.device_name = "Headset Microphone";
+        event.was_muted = i % 2 != 0;
+        event.muted = i % 2 == 0;
+        event.source = MuteSource::Hotkey;
+        log.append(event);
+    }) == 0);
+}
+
+int main() {
+    test_counter_sees_allocations();
+    test_queue();
+    test_mute_group(1);
+    test_mute_group(4);
+    test_latency_trace();
+    test_rate_limiter();
+    test_event_log();
+    return test_result();
+}
@@ -0,0 +1,206 @@
+// MuteGroup and DeviceRegistry driven against the mock backend, the same
+// calls the Windows controller makes on the toggle and hot-plug paths.
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mock_backend.h"
+#include "device_registry.h"
+#include "mute_group.h"
+#include "test_check.h"
+
+static void test_mock_devices() {
+    MockAudioBackend backend;
+    CHECK(backend.initialize());
+
+    std::vector<AudioDevice> devices = backend.enumerate_devices();
+    CHECK(devices.size() == 2);
+    CHECK(devices[0].is_default && !devices[1].is_default);
+    CHECK(backend.default_device_id() == "{mock.capture.0}");
+
+    // Disabled devices are not listed and cannot be opened
+    backend.set_device_enabled("{mock.capture.1}", false);
+    CHECK(backend.enumerate_devices().size() == 1);
+    CHECK(!backend.open_device("{mock.capture.1}"));
+    AudioDevice info;
+    CHECK(!backend.describe_device("{mock.capture.1}", info));
+    CHECK(backend.describe_device("{mock.capture.0}", info) && info.is_default);
+}
+
+static void test_mute_notifications() {
+    MockAudioBackend backend;
+    backend.initialize();
+    auto endpoint = backend.open_device("{mock.capture.0}");
+    CHECK(endpoint != nullptr);
+
+    std::vector<std::pair<bool, bool>> seen; // muted, self_initiated
+    endpoint->subscribe([&](bool muted, bool self) { seen.emplace_back(muted, self); });
+
+    CHECK(endpoint->set_mute(true));
+    CHECK(endpoint->set_mute(true)); // no change, no notification
+    backend.inject_mute_change("{mock.capture.0}", false);
+    CHECK(seen.size() == 2);
+    CHECK(seen[0] == std::make_pair(true, true));
+    CHECK(seen[1] == std::make_pair(false, false));
+    CHECK(backend.set_mute_calls("{mock.capture.0}") == 2);
+
+    endpoint->subscribe(nullptr);
+    backend.inject_mute_change("{mock.capture.0}", true);
+    CHECK(seen.size() == 2);
+
+    bool muted = false;
+    CHECK(endpoint->get_mute(muted) && muted);
+    backend.set_device_enabled("{mock.capture.0}", false);
+    CHECK(!endpoint->get_mute(muted));
+    CHECK(!endpoint->set_mute(false));
+}
+
+static void test_single_member_group() {
+    MockAudioBackend backend;
+    backend.initialize();
+
+    MuteGroup group;
+    group.add(backend.open_device("{mock.capture.0}"), "Mock Microphone", false);
+    CHECK(group.size() == 1);
+    CHECK(!group.any_muted() && !group.all_muted());
+
+    MuteGroup::Result result;
+    group.set_mute(true, result);
+    CHECK(result.count == 1 && result.succeeded == 1 && result.ok[0]);
+    CHECK(result.spread.count() == 0);
+    CHECK(group.all_muted());
+    CHECK(backend.device_muted("{mock.capture.0}"));
+    CHECK(!backend.device_muted("{mock.capture.1}"));
+
+    group.set_mute(false, result);
+    CHECK(!group.any_muted());
+    CHECK(!backend.device_muted("{mock.capture.0}"));
+}
+
+static void test_group_fans_out() {
+    MockAudioBackend backend;
+    std::vector<std::string> ids;
+    for (int i = 0; i < 4; i++) {
+        ids.push_back("{mock.group." + std::to_string(i) + "}");
+        backend.add_device(ids.back(), "Group Microphone " + std::to_string(i));
+    }
+
+    std::atomic<int> thread_starts{ 0 }; // the hooks run on the helper threads
+    std::atomic<int> thread_stops{ 0 };
+    {
+        MuteGroup group([&] { thread_starts++; }, [&] { thread_stops++; });
+        for (const auto& id : ids) group.add(backend.open_device(id), id, false);
+        CHECK(group.size() == 4);
+        CHECK(group.contains(ids[3]) && !group.contains("{mock.capture.0}"));
+
+        // Repeated rounds make sure a parked helper never misses a generation
+        MuteGroup::Result result;
+        for (int round = 0; round < 200; round++) {
+            bool muted = round % 2 == 0;
+            group.set_mute(muted, result);
+            CHECK(result.count == 4 && result.succeeded == 4);
+            CHECK(group.all_muted() == muted && group.any_muted() == muted);
+            for (const auto& id : ids) CHECK(backend.device_muted(id) == muted);
+        }
+        for (const auto& id : ids) CHECK(backend.set_mute_calls(id) == 200);
+
+        // One unplugged member fails alone, the group is then partly muted
+        backend.set_device_enabled(ids[2], false);
+        group.set_mute(true, result);
+        CHECK(result.succeeded == 3);
+        CHECK(result.ok[0] && result.ok[1] && !result.ok[2] && result.ok[3]);
+        CHECK(group.any_muted() && !group.all_muted());
+        CHECK(!group.is_member_muted(2) && group.is_member_muted(3));
+
+        // State seen by a notification counts too
+        group.note_mute(2, true);
+        CHECK(group.all_muted());
+    }
+    CHECK(thread_starts == 6 && thread_stops == 6); // add() respawns the helpers, 0 + 1 + 2 + 3
+}
+
+static void test_registry_lazy_default() {
+    MockAudioBackend backend;
+    backend.initialize();
+
+    DeviceRegistry registry;
+    registry.attach(&backend);
+    CHECK(!registry.is_populated());
+    CHECK(registry.get_default_id() == "{mock.capture.0}");
+    CHECK(registry.devices().size() == 1); // only the default was described
+
+    const AudioDevice* other = registry.describe("{mock.capture.1}");
+    CHECK(other && other->name == "Mock Headset" && !other->is_default);
+    CHECK(!registry.is_populated());
+
+    // A name can only be matched against the full list
+    const AudioDevice* by_name = registry.find_by_name("Mock Headset");
+    CHECK(registry.is_populated());
+    CHECK(by_name && by_name->id == "{mock.capture.1}");
+    CHECK(!registry.find_by_name("Nothing Like It"));
+}
+
+static void test_registry_events() {
+    MockAudioBackend backend;
+    backend.initialize();
+
+    DeviceRegistry registry;
+    registry.attach(&backend);
+    registry.populate();
+
+    // Events are queued by the backend and applied later, as on the UI thread
+    std::vector<std::pair<DeviceEvent, std::string>> events;
+    backend.subscribe_devices([&](DeviceEvent event, const std::string& id) { events.emplace_back(event, id); });
+    auto apply = [&] {
+        bool changed = false;
+        for (const auto& e : events) changed |= registry.apply_event(e.first, e.second);
+        events.clear();
+        return changed;
+    };
+
+    std::shared_ptr<CaptureEndpoint> endpoint = registry.acquire("{mock.capture.1}");
+    CHECK(endpoint && registry.acquire("{mock.capture.1}") == endpoint);
+
+    backend.add_device("{mock.capture.2}", "Studio Condenser");
+    CHECK(apply());
+    CHECK(registry.devices().size() == 3);
+    CHECK(registry.find_by_name("Studio Condenser") != nullptr);
+
+    backend.set_default_device("{mock.capture.2}");
+    CHECK(apply());
+    CHECK(registry.get_default_id() == "{mock.capture.2}");
+    CHECK(registry.find("{mock.capture.2}")->is_default);
+    CHECK(!registry.find("{mock.capture.0}")->is_default);
+
+    // Unplugged devices leave the list and the name index
+    backend.set_device_enabled("{mock.capture.2}", false);
+    CHECK(apply());
+    CHECK(!registry.find("{mock.capture.2}"));
+    CHECK(!registry.find_by_name("Studio Condenser"));
+
+    backend.set_device_enabled("{mock.capture.2}", true);
+    CHECK(apply());
+    CHECK(registry.find("{mock.capture.2}") && registry.find("{mock.capture.2}")->is_default);
+
+    // Unrelated changes keep the cached endpoint, invalidate drops it
+    CHECK(registry.acquire("{mock.capture.1}") == endpoint);
+    registry.invalidate("{mock.capture.1}");
+    std::shared_ptr<CaptureEndpoint> reopened = registry.acquire("{mock.capture.1}");
+    CHECK(reopened && reopened != endpoint);
+    CHECK(!registry.acquire("{mock.capture.9}"));
+
+    backend.subscribe_devices(nullptr);
+}
+
+int main() {
+    test_mock_devices();
+    test_mute_notifications();
+    test_single_member_group();
+    test_group_fans_out();
+    test_registry_lazy_default();
+    test_registry_events();
+    return test_result();
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+// Timing for the benchmark programs, on the steady clock. best_ns_per_call()
+// keeps the fastest of several rounds so a preemption or a cold cache in one
+// round does not count; print_percentiles() is for runs where every sample
+// matters, like the slowest toggle.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+inline double elapsed_us(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Each round calls run(i) for i = 0 .. calls - 1. Nanoseconds per call in
+// the fastest round.
+template<typename Run>
+double best_ns_per_call(int rounds, int calls, Run run) {
+    double best = 1e30;
+    for (int round = 0; round < rounds; round++) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < calls; i++) run(i);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        if (ns < best) best = ns;
+    }
+    return best / calls;
+}
+
+// One line of p50, p99 and max, samples in microseconds. Sorts them.
+inline void print_percentiles(const char* what, std::vector<double>& us) {
+    std::sort(us.begin(), us.end());
+    printf("  %-10s p50 %8.1f us  p99 %8.1f us  max %8.1f us\n", what,
+        us[us.size() / 2], us[us.size() * 99 / 100], us.back());
+}
@@ -0,0 +1,40 @@
+// Time to tokenize and apply a config file: the saved defaults, and the
+// same text repeated into a large file.
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bench_timer.h"
+#include "config.h"
+
+const int ROUNDS = 200;
+
+static void bench_parse(const char* name, const std::string& text) {
+    size_t entries = 0;
+    double best = best_ns_per_call(ROUNDS, 1, [&](int) {
+        Config config;
+        std::vector<ConfigDiagnostic> diagnostics;
+        entries = 0;
+        parse_config_entries(text, [&](const ConfigEntry& entry) {
+            apply_config_entry(entry, config, diagnostics);
+            entries++;
+        });
+    }) / 1000;
+    printf("%-8s %7zu bytes %5zu entries %8.1f us %7.1f MB/s\n", name, text.size(), entries, best,
+        text.size() / best);
+}
+
+int main() {
+    std::ostringstream out;
+    write_config_settings(out, Config());
+    std::string defaults = out.str();
+
+    std::string large;
+    while (large.size() < (1 << 20)) large += defaults;
+
+    bench_parse("defaults", defaults);
+    bench_parse("1 MB", large);
+    return 0;
+}
@@ -0,0 +1,150 @@
+// The config tokenizer and value parsers on hand-picked lines, then on
+// random text: every entry has to point back into the text at the line
+// and columns it claims, and applying it must never do more than report.
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "config.h"
+#include "test_check.h"
+
+static std::vector<ConfigEntry> entries_of(std::string_view text) {
+    std::vector<ConfigEntry> entries;
+    parse_config_entries(text, [&](const ConfigEntry& entry) { entries.push_back(entry); });
+    return entries;
+}
+
+static void test_tokenizer() {
+    std::vector<ConfigEntry> e = entries_of(
+        "\xEF\xBB\xBF" "first=1\r\n"
+        "# comment = not a setting\n"
+        "======== BANNER ========\n"
+        "\n"
+        "free text without an equals sign\n"
+        "\t key two \t=\t value = with equals \r\n"
+        "empty =\n"
+        "= no key\n"
+        "last = no newline");
+
+    CHECK(e.size() == 4);
+    if (e.size() != 4) return;
+    CHECK(e[0].key == "first" && e[0].value == "1" && e[0].line == 1);
+    CHECK(e[0].key_column == 1 && e[0].value_column == 7);
+    CHECK(e[1].key == "key two" && e[1].value == "value = with equals" && e[1].line == 6);
+    CHECK(e[1].key_column == 3 && e[1].value_column == 15);
+    CHECK(e[2].key == "empty" && e[2].value.empty() && e[2].line == 7);
+    CHECK(e[3].key == "last" && e[3].value == "no newline" && e[3].line == 9);
+
+    CHECK(entries_of("").empty());
+    CHECK(entries_of("\n\n\r\n").empty());
+}
+
+static void test_values() {
+    bool b = false;
+    for (const char* yes : { "1", "true", "TRUE", "Yes", "on" }) CHECK(parse_config_bool(yes, b) && b);
+    for (const char* no : { "0", "false", "No", "OFF" }) CHECK(parse_config_bool(no, b) && !b);
+    for (const char* bad : { "", "2", "truee", "y", "enabled" }) CHECK(!parse_config_bool(bad, b));
+
+    unsigned long u = 0;
+    CHECK(parse_config_uint("42", u) && u == 42);
+    CHECK(parse_config_uint("0x7B", u) && u == 0x7B);
+    CHECK(parse_config_uint("0", u) && u == 0);
+    for (const char* bad : { "", "0x", "-1", "+1", "12a", "0x1G", " 1", "99999999999999999999999" }) {
+        CHECK(!parse_config_uint(bad, u));
+    }
+
+    long i = 0;
+    CHECK(parse_config_int("-12", i) && i == -12);
+    for (const char* bad : { "", "-", "1.5", "0x10", "7 " }) CHECK(!parse_config_int(bad, i));
+
+    // Every schema key is found, near misses are not
+    for (const ConfigSetting& s : CONFIG_SCHEMA) {
+        CHECK(find_config_setting(s.key) == &s);
+        std::string longer = std::string(s.key) + "x";
+        CHECK(find_config_setting(longer) == nullptr);
+    }
+    CHECK(find_config_setting("") == nullptr);
+
+    // The hash order holds every setting once
+    bool seen[CONFIG_SCHEMA_SIZE] = {};
+    for (size_t i = 0; i < CONFIG_SCHEMA_SIZE; i++) {
+        seen[CONFIG_SCHEMA_BY_HASH[i]] = true;
+        if (i > 0) CHECK(CONFIG_SCHEMA[CONFIG_SCHEMA_BY_HASH[i - 1]].hash < CONFIG_SCHEMA[CONFIG_SCHEMA_BY_HASH[i]].hash);
+    }
+    for (bool s : seen) CHECK(s);
+}
+
+// Text built from the characters the tokenizer cares about, random bytes
+// (NUL included) and pieces of real keys and values, so some entries get
+// past the schema lookup
+static std::string random_config(std::mt19937& random) {
+    static const char* const pieces[] = {
+        "=", " ", "\t", "\r", "\n", "\r\n", "#", "\xEF\xBB\xBF", "0x", "-", "1", "99999999999",
+        "true", "Ctrl+", "F2", "+", "play_sounds", "sound_volume", "hotkey_vk", "mute_hotkey",
+        "toggle_cooldown", "device_name", "\xC3\xA9"
+    };
+    const size_t count = sizeof(pieces) / sizeof(pieces[0]);
+    std::string text;
+    size_t length = random() % 60;
+    for (size_t i = 0; i < length; i++) {
+        size_t p = random() % (count + 1);
+        if (p == count) text += (char)(random() & 0xFF);
+        else text += pieces[p];
+    }
+    return text;
+}
+
+static void test_random_text() {
+    std::mt19937 random(12);
+    for (int round = 0; round < 20000; round++) {
+        std::string text = random_config(random);
+        std::string_view body = text;
+        if (body.substr(0, 3) == "\xEF\xBB\xBF") body.remove_prefix(3);
+
+        // Start of every line, to check what the entries claim
+        std::vector<size_t> line_starts = { 0 };
+        for (size_t i = 0; i < body.size(); i++) {
+            if (body[i] == '\n') line_starts.push_back(i + 1);
+        }
+
+        Config config;
+        std::vector<ConfigDiagnostic> diagnostics;
+        size_t last_line = 0;
+        parse_config_entries(text, [&](const ConfigEntry& entry) {
+            CHECK(entry.line > last_line && entry.line <= line_starts.size());
+            last_line = entry.line;
+            if (entry.line > line_starts.size()) return;
+
+            const char* line = body.data() + line_starts[entry.line - 1];
+            CHECK(entry.key.data() == line + entry.key_column - 1);
+            CHECK(entry.value.data() == line + entry.value_column - 1);
+            CHECK(entry.value.data() + entry.value.size() <= body.data() + body.size());
+            CHECK(!entry.key.empty() && !is_config_space(entry.key.back()));
+            CHECK(entry.key.find('\n') == std::string_view::npos);
+            CHECK(entry.value.find('\n') == std::string_view::npos);
+            CHECK(entry.value.empty() || (!is_config_space(entry.value.front()) && !is_config_space(entry.value.back())));
+
+            size_t before = diagnostics.size();
+            apply_config_entry(entry, config, diagnostics);
+            CHECK(diagnostics.size() <= before + 1);
+            for (size_t d = before; d < diagnostics.size(); d++) CHECK(diagnostics[d].line == entry.line);
+        });
+
+        // Whatever was accepted is in range and saves cleanly
+        for (const ConfigSetting& s : CONFIG_SCHEMA) {
+            if (s.type == SettingType::Int) {
+                CHECK(config.*s.int_member >= s.minimum && config.*s.int_member <= s.maximum);
+            }
+        }
+    }
+}
+
+int main() {
+    test_tokenizer();
+    test_values();
+    test_random_text();
+    return test_result();
+}
@@ -0,0 +1,184 @@
+// Load/save symmetry of the schema-driven config: whatever write_config_settings
+// writes, parsing it back gives the same settings and no diagnostics, and a
+// second write is identical. Out-of-range numbers are clamped and reported.
+
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "test_check.h"
+
+static bool same_setting(const ConfigSetting& s, const Config& a, const Config& b) {
+    switch (s.type) {
+    case SettingType::Bool: return a.*s.bool_member == b.*s.bool_member;
+    case SettingType::UInt: return a.*s.uint_member == b.*s.uint_member;
+    case SettingType::Int: return a.*s.int_member == b.*s.int_member;
+    case SettingType::Text: return a.*s.text_member == b.*s.text_member;
+    case SettingType::Chord: return a.*s.chord_member == b.*s.chord_member;
+    }
+    return false;
+}
+
+static std::string save(const Config& config) {
+    std::ostringstream out;
+    write_config_settings(out, config);
+    return out.str();
+}
+
+static Config load(const std::string& text, std::vector<ConfigDiagnostic>& diagnostics) {
+    Config config;
+    parse_config_entries(text, [&](const ConfigEntry& entry) {
+        apply_config_entry(entry, config, diagnostics);
+    });
+    return config;
+}
+
+// Saves, reloads and saves again, every setting has to survive
+static void check_round_trip(const Config& original) {
+    std::string text = save(original);
+    std::vector<ConfigDiagnostic> diagnostics;
+    Config loaded = load(text, diagnostics);
+
+    CHECK(diagnostics.empty());
+    for (const ConfigSetting& s : CONFIG_SCHEMA) {
+        if (!same_setting(s, original, loaded)) {
+            fprintf(stderr, "setting '%s' did not survive the round trip\n", s.key);
+            CHECK(same_setting(s, original, loaded));
+        }
+    }
+    CHECK(diff_config(original, loaded) == 0);
+    CHECK(save(loaded) == text);
+}
+
+static void test_defaults() {
+    Config defaults;
+    check_round_trip(defaults);
+
+    // Every key is written exactly once
+    std::string text = save(defaults);
+    for (const ConfigSetting& s : CONFIG_SCHEMA) {
+        std::string line = std::string("\n") + s.key + " = ";
+        size_t first = text.find(line);
+        CHECK(first != std::string::npos);
+        CHECK(text.find(line, first + 1) == std::string::npos);
+    }
+
+    // An empty file keeps every default
+    std::vector<ConfigDiagnostic> diagnostics;
+    CHECK(diff_config(load("", diagnostics), defaults) == 0);
+    CHECK(diagnostics.empty());
+}
+
+// Every setting moved off its default, to a value that is valid for it
+static void test_every_key_changed() {
+    Config changed;
+    int n = 0;
+    for (const ConfigSetting& s : CONFIG_SCHEMA) {
+        n++;
+        switch (s.type) {
+        case SettingType::Bool:
+            changed.*s.bool_member = !(changed.*s.bool_member);
+            break;
+        case SettingType::UInt:
+            changed.*s.uint_member += 7;
+            break;
+        case SettingType::Int:
+            changed.*s.int_member = (int)(s.default_number == s.maximum ? s.minimum : s.maximum);
+            break;
+        case SettingType::Text:
+            changed.*s.text_member = "value " + std::to_string(n) + " = with; punctuation # inside";
+            break;
+        case SettingType::Chord:
+            changed.*s.chord_member = { HOTKEY_MOD_CONTROL | HOTKEY_MOD_ALT, (unsigned)(0x70 + n % 12) };
+            break;
+        }
+    }
+
+    Config defaults;
+    for (const ConfigSetting& s : CONFIG_SCHEMA) {
+        if (same_setting(s, changed, defaults)) fprintf(stderr, "setting '%s' was not changed\n", s.key);
+        CHECK(!same_setting(s, changed, defaults));
+    }
+    check_round_trip(changed);
+
+    // Each setting alone reports the subsystems it affects, and only those
+    for (const ConfigSetting& s : CONFIG_SCHEMA) {
+        std::string text = std::string(s.key) + " = ";
+        std::string saved = save(changed);
+        size_t start = saved.find("\n" + text) + 1;
+        text = saved.substr(start, saved.find('\n', start) - start);
+
+        std::vector<ConfigDiagnostic> diagnostics;
+        Config one = load(text, diagnostics);
+        CHECK(diagnostics.empty());
+        CHECK(diff_config(defaults, one) == s.affects);
+    }
+}
+
+static void test_clamping() {
+    for (const ConfigSetting& s : CONFIG_SCHEMA) {
+        if (s.type != SettingType::Int) continue;
+
+        std::string text = "# out of range\n" +
+            std::string(s.key) + " = " + std::to_string(s.minimum - 1) + "\n" +
+            "  " + s.key + "   =   " + std::to_string(s.maximum + 1000) + "\n";
+        std::vector<ConfigDiagnostic> diagnostics;
+        Config config;
+        bool saw_minimum = false;
+        parse_config_entries(text, [&](const ConfigEntry& entry) {
+            apply_config_entry(entry, config, diagnostics);
+            if (entry.line == 2) saw_minimum = config.*s.int_member == s.minimum;
+        });
+
+        CHECK(saw_minimum);
+        CHECK(config.*s.int_member == s.maximum);
+        CHECK(diagnostics.size() == 2);
+        if (diagnostics.size() == 2) {
+            CHECK(diagnostics[0].line == 2 && diagnostics[1].line == 3);
+            CHECK(diagnostics[1].column == strlen(s.key) + 10);
+            CHECK(diagnostics[0].message.find("out of range") != std::string::npos);
+            CHECK(diagnostics[1].message.find("using " + std::to_string(s.maximum)) != std::string::npos);
+        }
+
+        // A clamped value saves as the clamped value
+        std::vector<ConfigDiagnostic> again;
+        Config reloaded = load(save(config), again);
+        CHECK(again.empty() && reloaded.*s.int_member == s.maximum);
+    }
+}
+
+static void test_invalid_values() {
+    std::vector<ConfigDiagnostic> diagnostics;
+    Config config = load(
+        "play_sounds = maybe\n"
+        "hotkey_vk = 0x1FFFFFFFF\n"
+        "hotkey_mod = six\n"
+        "sound_volume = 40%\n"
+        "mute_hotkey = Ctrl+Nothing\n"
+        "no_such_setting = 1\n"
+        "unmute_on_exit = OFF\n"
+        "hotkey_vk = 0x71\n", diagnostics);
+
+    Config defaults;
+    CHECK(diagnostics.size() == 6);
+    for (size_t i = 0; i < diagnostics.size() && i < 6; i++) CHECK(diagnostics[i].line == i + 1);
+    CHECK(config.play_sounds == defaults.play_sounds);
+    CHECK(config.hotkey_mod == defaults.hotkey_mod);
+    CHECK(config.sound_volume == defaults.sound_volume);
+    CHECK(config.mute_hotkey == defaults.mute_hotkey);
+    CHECK(!config.unmute_on_exit);
+    CHECK(config.hotkey_vk == 0x71);
+    if (diagnostics.size() == 6) {
+        CHECK(diagnostics[5].column == 1 && diagnostics[5].message == "unknown setting 'no_such_setting'");
+    }
+}
+
+int main() {
+    test_defaults();
+    test_every_key_changed();
+    test_clamping();
+    test_invalid_values();
+    return test_result();
+}
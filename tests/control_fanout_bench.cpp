@@ -0,0 +1,95 @@
+// Control endpoint events with many subscribers, without the pipes: the
+// time from publishing a state on one thread until the server thread has
+// queued and handed it to every subscriber, and the fan-out cost per
+// subscriber. The wait for a wake stands in for the completion port.
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_timer.h"
+#include "control_fanout.h"
+
+const int EVENTS = 2000;
+
+struct Subscriber : ControlClientOutput {
+    size_t received = 0;
+};
+
+static void bench_subscribers(size_t count) {
+    std::vector<Subscriber> subscribers(count);
+    for (Subscriber& s : subscribers) s.subscribed = true;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable delivered;
+    int published = -1;
+    int done = 0;
+    bool stopping = false;
+    std::vector<double> fanout_us;
+
+    std::thread server([&] {
+        ControlFanout fanout;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            wake.wait(lock, [&] { return stopping || published >= 0; });
+            if (stopping) break;
+            int state = published;
+            published = -1;
+            lock.unlock();
+
+            auto start = std::chrono::steady_clock::now();
+            if (const std::string* event = fanout.event_for(state != 0)) {
+                for (Subscriber& s : subscribers) {
+                    if (!ControlFanout::queue(s, *event)) continue;
+                    while (s.begin_write()) {
+                        s.received += s.writing.size();
+                        s.end_write();
+                    }
+                }
+            }
+            fanout_us.push_back(elapsed_us(start));
+
+            lock.lock();
+            done++;
+            delivered.notify_one();
+        }
+    });
+
+    std::vector<double> round_trip_us;
+    for (int i = 0; i < EVENTS; i++) {
+        auto start = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(mutex);
+        published = i % 2;
+        wake.notify_one();
+        delivered.wait(lock, [&] { return done == i + 1; });
+        round_trip_us.push_back(elapsed_us(start));
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    server.join();
+
+    std::vector<double> per_subscriber_ns;
+    for (double us : fanout_us) per_subscriber_ns.push_back(us * 1000 / count);
+    std::sort(per_subscriber_ns.begin(), per_subscriber_ns.end());
+
+    printf("%zu subscribers, %d events, %.1f ns per subscriber (p50)\n", count, EVENTS,
+        per_subscriber_ns[per_subscriber_ns.size() / 2]);
+    print_percentiles("round trip", round_trip_us);
+    print_percentiles("fan-out", fanout_us);
+}
+
+int main() {
+    bench_subscribers(1);
+    bench_subscribers(100);
+    bench_subscribers(1000);
+    return 0;
+}
@@ -0,0 +1,112 @@
+// Event fan-out of the control endpoint without the pipes: a state reaches
+// every subscriber once and in order, repeats are dropped, and a subscriber
+// that stops reading is dropped at the output limit while 100+ others keep
+// up.
+
+#include <string>
+#include <vector>
+
+#include "control_fanout.h"
+#include "test_check.h"
+
+struct FakeClient : ControlClientOutput {
+    std::string received; // everything written to the pipe so far
+    bool reading = true;
+    bool dropped = false;
+
+    // The pipe takes everything queued at once
+    void drain() {
+        if (!reading || dropped) return;
+        while (begin_write()) {
+            received += writing;
+            end_write();
+        }
+    }
+};
+
+// What the server thread does on a published state, returns the subscribers reached
+static size_t broadcast(ControlFanout& fanout, std::vector<FakeClient>& clients, bool muted) {
+    const std::string* event = fanout.event_for(muted);
+    if (!event) return 0;
+
+    size_t reached = 0;
+    for (FakeClient& c : clients) {
+        if (!c.subscribed || c.dropped) continue;
+        if (!ControlFanout::queue(c, *event)) {
+            c.dropped = true;
+            continue;
+        }
+        reached++;
+    }
+    return reached;
+}
+
+static void test_repeats() {
+    ControlFanout fanout;
+    const std::string* first = fanout.event_for(true);
+    CHECK(first && *first == "event muted\n");
+    CHECK(!fanout.event_for(true));
+    const std::string* second = fanout.event_for(false);
+    CHECK(second && *second == "event unmuted\n");
+    CHECK(!fanout.event_for(false));
+
+    // A restarted server sends the state again
+    fanout.reset();
+    CHECK(fanout.event_for(false) != nullptr);
+}
+
+static void test_write_queue() {
+    ControlClientOutput client;
+    CHECK(!client.begin_write());
+
+    client.output = "state muted\n";
+    CHECK(client.begin_write() && client.writing == "state muted\n" && client.output.empty());
+
+    // Queued behind the write in flight, which still counts as unread
+    CHECK(ControlFanout::queue(client, "event unmuted\n"));
+    CHECK(!client.begin_write());
+    CHECK(client.unread() == 26);
+    client.end_write();
+    CHECK(client.begin_write() && client.writing == "event unmuted\n");
+    client.end_write();
+    CHECK(client.unread() == 0);
+}
+
+static void test_many_subscribers() {
+    const size_t CLIENTS = 160;
+    const size_t STALLED = 7;
+    ControlFanout fanout;
+    std::vector<FakeClient> clients(CLIENTS);
+    for (size_t i = 0; i < CLIENTS; i++) clients[i].subscribed = i % 16 != 0; // 150 subscribers
+    clients[STALLED].reading = false;
+
+    std::string expected;
+    for (int round = 0; round < 12000; round++) {
+        bool muted = round % 2 == 0;
+        size_t reached = broadcast(fanout, clients, muted);
+        CHECK(reached == (clients[STALLED].dropped ? 149u : 150u));
+        CHECK(broadcast(fanout, clients, muted) == 0); // a repeat reaches nobody
+        append_control_state(expected, "event", muted);
+        for (FakeClient& c : clients) c.drain();
+    }
+
+    // The stalled one went at the limit, no further
+    const FakeClient& stalled = clients[STALLED];
+    CHECK(stalled.dropped && stalled.received.empty());
+    CHECK(stalled.unread() > ControlFanout::MAX_PENDING_OUTPUT);
+    CHECK(stalled.unread() <= ControlFanout::MAX_PENDING_OUTPUT + 14);
+
+    for (size_t i = 0; i < CLIENTS; i++) {
+        if (i == STALLED) continue;
+        const FakeClient& c = clients[i];
+        CHECK(!c.dropped);
+        CHECK(c.received == (c.subscribed ? expected : std::string()));
+    }
+}
+
+int main() {
+    test_repeats();
+    test_write_queue();
+    test_many_subscribers();
+    return test_result();
+}
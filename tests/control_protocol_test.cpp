@@ -0,0 +1,75 @@
+// Request parsing and reply formatting of the control line protocol.
+// The named-pipe server around it is Windows only and not covered here.
+
+#include <string>
+
+#include "control_protocol.h"
+#include "test_check.h"
+
+static bool parses_as(const char* line, ControlVerb verb) {
+    ControlCommand command = parse_control_line(line);
+    return command.verb == verb && command.error == nullptr;
+}
+
+static bool rejected_with(const char* line, const std::string& error) {
+    ControlCommand command = parse_control_line(line);
+    return command.verb == ControlVerb::Unknown && command.error != nullptr && error == command.error;
+}
+
+static void test_requests() {
+    CHECK(parses_as("toggle", ControlVerb::Toggle));
+    CHECK(parses_as("mute", ControlVerb::Mute));
+    CHECK(parses_as("unmute", ControlVerb::Unmute));
+    CHECK(parses_as("get", ControlVerb::Get));
+    CHECK(parses_as("subscribe", ControlVerb::Subscribe));
+    CHECK(parses_as("unsubscribe", ControlVerb::Unsubscribe));
+    CHECK(parses_as("devices", ControlVerb::Devices));
+
+    // Surrounding blanks and a CR from CRLF line ends are ignored
+    CHECK(parses_as("  toggle\t\r", ControlVerb::Toggle));
+    CHECK(parses_as("set   muted ", ControlVerb::Mute));
+    CHECK(parses_as("set unmuted\r", ControlVerb::Unmute));
+    for (const char* on : { "set on", "set true", "set 1", "set YES" }) CHECK(parses_as(on, ControlVerb::Mute));
+    for (const char* off : { "set off", "set false", "set 0", "set No" }) CHECK(parses_as(off, ControlVerb::Unmute));
+
+    CHECK(rejected_with("", "empty request"));
+    CHECK(rejected_with(" \t\r", "empty request"));
+    CHECK(rejected_with("Toggle", "unknown command"));
+    CHECK(rejected_with("toggle now", "unexpected argument"));
+    CHECK(rejected_with("get state", "unexpected argument"));
+    CHECK(rejected_with("set", "expected set muted|unmuted"));
+    CHECK(rejected_with("set maybe", "expected set muted|unmuted"));
+    CHECK(rejected_with("set muted please", "expected set muted|unmuted"));
+}
+
+static void test_replies() {
+    std::string out;
+    append_control_state(out, "state", true);
+    append_control_state(out, "event", false);
+    append_control_error(out, "unknown command");
+    CHECK(out == "state muted\nevent unmuted\nerror unknown command\n");
+
+    AudioDevice device;
+    device.id = "{0.0.1.00000000}.{id}";
+    device.name = "Line\tIn\r\n(2)";
+    out.clear();
+    append_control_device(out, device, false);
+    CHECK(out == "device\t{0.0.1.00000000}.{id}\tLine In  (2)\t\n");
+
+    device.is_default = true;
+    out.clear();
+    append_control_device(out, device, false);
+    append_control_device(out, device, true);
+    device.is_default = false;
+    append_control_device(out, device, true);
+    CHECK(out ==
+        "device\t{0.0.1.00000000}.{id}\tLine In  (2)\tdefault\n"
+        "device\t{0.0.1.00000000}.{id}\tLine In  (2)\tdefault,target\n"
+        "device\t{0.0.1.00000000}.{id}\tLine In  (2)\ttarget\n");
+}
+
+int main() {
+    test_requests();
+    test_replies();
+    return test_result();
+}
@@ -0,0 +1,64 @@
+// Startup cost of the device cache: encoding it, and opening it in place
+// and looking a device up by name as startup does, against finding the
+// same device through a full enumeration of a mock backend holding the
+// same list. The mock only copies its list, a real enumeration asks every
+// driver and is far slower, so the gap here is the smallest it can be.
+
+#include <cstdio>
+#include <string>
+
+#include "bench_timer.h"
+#include "device_cache.h"
+#include "mock_backend.h"
+
+const int ITERATIONS = 10000;
+const int ROUNDS = 10;
+
+template<typename Run>
+static double best_us(Run run) {
+    return best_ns_per_call(ROUNDS, ITERATIONS, [&](int) { run(); }) / 1000;
+}
+
+static void bench_cache(size_t count) {
+    DeviceCacheContents contents;
+    for (size_t i = 0; i < count; i++) {
+        AudioDevice device;
+        device.id = "{0.0.1.00000000}.{" + std::to_string(i) + "-0000-0000-0000-000000000000}";
+        device.name = "Microphone (USB Audio Device " + std::to_string(i) + ")";
+        device.description = "USB Audio Device";
+        device.is_enabled = true;
+        contents.devices.push_back(device);
+    }
+    std::string last_name = contents.devices.back().name;
+
+    MockAudioBackend backend;
+    for (const AudioDevice& device : contents.devices) backend.add_device(device.id, device.name, device.description);
+
+    std::string bytes;
+    double encode = best_us([&] { bytes = encode_device_cache(contents); });
+
+    size_t found = 0;
+    double lookup = best_us([&] {
+        DeviceCacheView view;
+        if (view.open(bytes.data(), bytes.size())) found += view.find_id_by_name(last_name).size();
+    });
+    size_t enumerated = 0;
+    double enumerate = best_us([&] {
+        for (const AudioDevice& device : backend.enumerate_devices()) {
+            if (device.name == last_name) {
+                enumerated += device.id.size();
+                break;
+            }
+        }
+    });
+    printf("%4zu devices %7zu bytes  encode %8.2f us  open+lookup %7.2f us  enumerate+lookup %8.2f us%s\n",
+        count, bytes.size(), encode, lookup, enumerate, found && enumerated ? "" : " (not found)");
+}
+
+int main() {
+    bench_cache(1);
+    bench_cache(5);
+    bench_cache(20);
+    bench_cache(200);
+    return 0;
+}
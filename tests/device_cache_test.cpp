@@ -0,0 +1,123 @@
+// The on-disk device cache: encode and read back, then every single-byte
+// corruption and every truncation of a valid file has to be rejected as a
+// whole, as must offsets that point outside the strings.
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "device_cache.h"
+#include "test_check.h"
+
+static AudioDevice device(const std::string& id, const std::string& name, bool enabled, bool is_default) {
+    AudioDevice d;
+    d.id = id;
+    d.name = name;
+    d.description = name + " (USB Audio)";
+    d.is_enabled = enabled;
+    d.is_default = is_default;
+    return d;
+}
+
+static DeviceCacheContents sample_contents() {
+    DeviceCacheContents contents;
+    contents.devices = {
+        device("{0.0.1.00000000}.{a}", "Headset Microphone", true, false),
+        device("{0.0.1.00000000}.{b}", "Studio Condenser", true, true),
+        device("{0.0.1.00000000}.{c}", "Webcam Mic \xC3\xA9", false, false),
+        device("{0.0.1.00000000}.{d}", "", true, false),
+        device("{0.0.1.00000000}.{e}", "Studio Condenser", true, false),
+    };
+    contents.targets = { { "{0.0.1.00000000}.{e}", "Old Name" } };
+    return contents;
+}
+
+static void test_round_trip() {
+    DeviceCacheContents contents = sample_contents();
+    std::string bytes = encode_device_cache(contents);
+
+    DeviceCacheView view;
+    CHECK(view.open(bytes.data(), bytes.size()));
+    CHECK(view.is_open() && view.size() == contents.devices.size());
+
+    std::vector<AudioDevice> devices = view.devices();
+    CHECK(devices.size() == contents.devices.size());
+    for (size_t i = 0; i < devices.size() && i < contents.devices.size(); i++) {
+        const AudioDevice& a = devices[i];
+        const AudioDevice& b = contents.devices[i];
+        CHECK(a.id == b.id && a.name == b.name && a.description == b.description);
+        CHECK(a.is_enabled == b.is_enabled && a.is_default == b.is_default);
+        CHECK(view.id(i) == b.id && view.name(i) == b.name);
+    }
+    CHECK(view.flags(4) == (DEVICE_CACHED_ENABLED | DEVICE_CACHED_TARGET));
+
+    // The bound name wins over a renamed device, then the first enabled match
+    CHECK(view.find_id_by_name("Old Name") == "{0.0.1.00000000}.{e}");
+    CHECK(view.find_id_by_name("Studio Condenser") == "{0.0.1.00000000}.{b}");
+    CHECK(view.find_id_by_name("Webcam Mic \xC3\xA9").empty()); // disabled
+    CHECK(view.find_id_by_name("Nothing").empty());
+
+    // Encoding is deterministic, an empty cache is valid
+    CHECK(encode_device_cache(contents) == bytes);
+    std::string empty = encode_device_cache(DeviceCacheContents());
+    CHECK(empty.size() == sizeof(DeviceCacheHeader));
+    CHECK(view.open(empty.data(), empty.size()) && view.size() == 0);
+}
+
+static void test_corruption() {
+    std::string bytes = encode_device_cache(sample_contents());
+    DeviceCacheView view;
+
+    // Every byte, flipped one bit and all bits
+    for (size_t i = 0; i < bytes.size(); i++) {
+        for (unsigned char mask : { 0x01, 0x80, 0xFF }) {
+            std::string bad = bytes;
+            bad[i] = (char)(bad[i] ^ mask);
+            CHECK(!view.open(bad.data(), bad.size()));
+            CHECK(!view.is_open());
+        }
+    }
+
+    // Every truncation, and one byte too many
+    for (size_t size = 0; size < bytes.size(); size++) CHECK(!view.open(bytes.data(), size));
+    std::string longer = bytes + '\0';
+    CHECK(!view.open(longer.data(), longer.size()));
+    CHECK(!view.open(nullptr, 0));
+
+    // A failed open closes the view it replaced
+    CHECK(view.open(bytes.data(), bytes.size()));
+    CHECK(!view.open(bytes.data(), bytes.size() - 1) && !view.is_open());
+
+    // Offsets past the strings are caught even with a matching checksum
+    for (size_t field = 0; field < 8; field += 2) {
+        std::string bad = bytes;
+        char* record = &bad[sizeof(DeviceCacheHeader) + sizeof(DeviceCacheRecord)];
+        uint32_t values[9];
+        memcpy(values, record, sizeof(values));
+        values[field + 1] = 0xFFFFFFF0u; // length wrapping past the end
+        memcpy(record, values, sizeof(values));
+
+        DeviceCacheHeader header;
+        memcpy(&header, bad.data(), sizeof(header));
+        header.checksum = device_cache_checksum(bad.data() + sizeof(header), bad.size() - sizeof(header),
+            device_cache_checksum(bad.data(), offsetof(DeviceCacheHeader, checksum)));
+        memcpy(&bad[0], &header, sizeof(header));
+        CHECK(!view.open(bad.data(), bad.size()));
+    }
+}
+
+static void test_device_list() {
+    std::string text = format_device_list(sample_contents().devices, "config.txt");
+    CHECK(text.find("Device 5:\n") != std::string::npos);
+    CHECK(text.find("Device 6:") == std::string::npos);
+    CHECK(text.find("*** This is your system's default microphone ***") != std::string::npos);
+    CHECK(text.find("device_name = Headset Microphone\n") != std::string::npos);
+    CHECK(format_device_list({}, "config.txt").find("No active audio input devices found!") != std::string::npos);
+}
+
+int main() {
+    test_round_trip();
+    test_corruption();
+    test_device_list();
+    return test_result();
+}
@@ -0,0 +1,52 @@
+// Name lookups on synthetic device lists of growing size, one list of
+// distinct names and one where every device shares its model with many
+// others, the worst case for the similarity fallback.
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bench_timer.h"
+#include "device_name_index.h"
+
+const int LOOKUPS = 20000;
+const int ROUNDS = 5;
+
+static void bench_list(const char* kind, size_t count, bool same_model) {
+    std::vector<std::string> storage;
+    for (size_t i = 0; i < count; i++) {
+        if (same_model) storage.push_back("Microphone (" + std::to_string(i % 10 + 2) + "- USB Audio Device " + std::to_string(i / 10) + ")");
+        else storage.push_back("Microphone " + std::to_string(i) + " (Vendor " + std::to_string(i * 7919 % 1000) + " Audio)");
+    }
+    std::vector<std::string_view> names(storage.begin(), storage.end());
+
+    DeviceNameIndex index;
+    auto start = std::chrono::steady_clock::now();
+    index.build(names);
+    double build_us = elapsed_us(start);
+
+    // Retyped with other case and spacing, and misspelled
+    std::vector<std::string> retyped, misspelled;
+    for (const std::string& name : storage) {
+        std::string lower;
+        for (char c : name) lower += (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+        retyped.push_back("  " + lower);
+        misspelled.push_back(name.substr(0, name.size() - 3) + "xo)");
+    }
+
+    size_t hits = 0;
+    double exact = best_ns_per_call(ROUNDS, LOOKUPS, [&](int i) { hits += index.lookup(names[i % count]).kind != DeviceMatchKind::None; });
+    double normal = best_ns_per_call(ROUNDS, LOOKUPS, [&](int i) { hits += index.lookup(retyped[i % count]).kind != DeviceMatchKind::None; });
+    double similar = best_ns_per_call(ROUNDS, LOOKUPS, [&](int i) { hits += index.lookup(misspelled[i % count]).kind != DeviceMatchKind::None; });
+    printf("%-10s %4zu devices  build %7.1f us  exact %6.0f ns  normalized %6.0f ns  similar %7.0f ns\n",
+        kind, count, build_us, exact, normal, similar);
+    if (hits == 0) printf("  (no hits)\n");
+}
+
+int main() {
+    for (size_t count : { 10, 50, 100, 500 }) bench_list("distinct", count, false);
+    for (size_t count : { 10, 50, 100, 500 }) bench_list("same model", count, true);
+    return 0;
+}
@@ -0,0 +1,93 @@
+// Device name matching: normalization, the exact / normalized / similar
+// order, and names that match more than one device and so match none.
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "device_name_index.h"
+#include "test_check.h"
+
+static std::string normalized(std::string_view name) {
+    std::string out;
+    normalize_device_name(name, out);
+    return out;
+}
+
+static void test_normalize() {
+    CHECK(normalized("Microphone ( 2- USB  Audio)") == "microphone (usb audio)");
+    CHECK(normalized("  Microphone (USB Audio)  ") == "microphone (usb audio)");
+    CHECK(normalized("12- Headset\tMic") == "headset mic");
+    CHECK(normalized("Mic 2-channel") == "mic 2-channel"); // no space after the dash
+    CHECK(normalized("Mic 2") == "mic 2");
+    CHECK(normalized("") == "" && normalized(" \t ") == "");
+}
+
+static void test_match_order() {
+    std::vector<std::string_view> names = {
+        "Microphone (USB Audio)",
+        "Headset Microphone (Jabra Evolve 75)",
+        "Line In (Realtek High Definition Audio)",
+    };
+    DeviceNameIndex index;
+    index.build(names);
+
+    DeviceNameIndex::Match m = index.lookup("Headset Microphone (Jabra Evolve 75)");
+    CHECK(m.kind == DeviceMatchKind::Exact && m.index == 1);
+
+    m = index.lookup("microphone (2- usb audio)");
+    CHECK(m.kind == DeviceMatchKind::Normalized && m.index == 0);
+
+    m = index.lookup("Line In (Realtek HD Audio)");
+    CHECK(m.kind == DeviceMatchKind::Similar && m.index == 2);
+    CHECK(m.similarity >= DeviceNameIndex::MIN_SIMILARITY && m.similarity < 1.0f);
+
+    CHECK(index.lookup("Webcam").kind == DeviceMatchKind::None);
+    CHECK(index.lookup("").kind == DeviceMatchKind::None);
+
+    // Lookups leave no state behind
+    for (int i = 0; i < 3; i++) {
+        CHECK(index.lookup("Line In (Realtek HD Audio)").index == 2);
+        CHECK(index.lookup("Headset Mic (Jabra Evolve 75)").index == 1);
+    }
+}
+
+static void test_ambiguous() {
+    // Two of the same model: each exact name still finds its device, the
+    // name they share once normalized finds neither
+    std::vector<std::string_view> names = {
+        "Microphone (USB Audio)",
+        "Microphone (2- USB Audio)",
+        "Line In (Realtek High Definition Audio)",
+    };
+    DeviceNameIndex index;
+    index.build(names);
+
+    DeviceNameIndex::Match m = index.lookup("Microphone (2- USB Audio)");
+    CHECK(m.kind == DeviceMatchKind::Exact && m.index == 1);
+    CHECK(index.lookup("Microphone (USB Audio)").index == 0);
+    CHECK(index.lookup("Microphone (3- USB Audio)").kind == DeviceMatchKind::None);
+    CHECK(index.lookup("microphone (usb audio)").kind == DeviceMatchKind::None);
+    CHECK(index.lookup("Microphone (USB Audi)").kind == DeviceMatchKind::None);
+
+    // Other names are unaffected
+    CHECK(index.lookup("line in (realtek high definition audio)").kind == DeviceMatchKind::Normalized);
+
+    // Rebuilding without the second device makes the name unique again
+    names.erase(names.begin() + 1);
+    index.build(names);
+    m = index.lookup("Microphone (3- USB Audio)");
+    CHECK(m.kind == DeviceMatchKind::Normalized && m.index == 0);
+
+    // Two similar names with no clear winner
+    std::vector<std::string_view> close = { "Desk Mic Left", "Desk Mic Right" };
+    index.build(close);
+    CHECK(index.lookup("Desk Mic").kind == DeviceMatchKind::None);
+}
+
+int main() {
+    test_normalize();
+    test_match_order();
+    test_ambiguous();
+    return test_result();
+}
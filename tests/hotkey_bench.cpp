@@ -0,0 +1,40 @@
+// Cost of one key event through the hotkey matcher, on a synthetic stream
+// of typing mixed with modifier chords, some of them bound.
+
+#include <cstdio>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "bench_timer.h"
+#include "hotkey_matcher.h"
+
+const size_t EVENTS = 1 << 20;
+const int ROUNDS = 20;
+
+int main() {
+    HotkeyMatcher matcher;
+    matcher.bind({ HOTKEY_MOD_CONTROL | HOTKEY_MOD_SHIFT, 0x70 }, HotkeyAction::Toggle);
+    matcher.bind({ HOTKEY_MOD_CONTROL | HOTKEY_MOD_SHIFT, 0x71 }, HotkeyAction::Mute);
+    matcher.bind({ HOTKEY_MOD_CONTROL, 0x71 }, HotkeyAction::Unmute);
+    matcher.bind({ HOTKEY_MOD_ALT, 'M' }, HotkeyAction::CycleDevice);
+
+    const unsigned modifiers[] = { 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0x5B };
+    std::mt19937 random(1);
+    std::vector<std::pair<unsigned, bool>> events;
+    while (events.size() < EVENTS) {
+        unsigned mod = random() % 4 == 0 ? modifiers[random() % 6] : 0;
+        unsigned vk = random() % 8 == 0 ? 0x70 + random() % 2 : 'A' + random() % 26;
+        if (mod) events.push_back({ mod, true });
+        events.push_back({ vk, true });
+        events.push_back({ vk, false });
+        if (mod) events.push_back({ mod, false });
+    }
+
+    unsigned swallowed = 0;
+    double ns = best_ns_per_call(ROUNDS, (int)events.size(), [&](int i) {
+        swallowed += matcher.on_key(events[i].first, events[i].second).swallow;
+    });
+    printf("on_key %6.2f ns per event (%zu events, %u swallowed)\n", ns, events.size(), swallowed);
+    return 0;
+}
@@ -0,0 +1,172 @@
+// Hotkey chord text, the key-stream matcher and the push-to-talk state
+// machine, fed synthetic key events the way the low-level keyboard hook
+// delivers them.
+
+#include <string>
+
+#include "hotkey_matcher.h"
+#include "test_check.h"
+
+const unsigned VK_LCONTROL = 0xA2;
+const unsigned VK_RCONTROL = 0xA3;
+const unsigned VK_LSHIFT = 0xA0;
+const unsigned VK_LALT = 0xA4;
+const unsigned VK_F1 = 0x70;
+const unsigned VK_F2 = 0x71;
+
+static void test_chord_text() {
+    HotkeyChord chord;
+    CHECK(parse_hotkey_chord("Ctrl+Shift+F2", chord));
+    CHECK(chord.mods == (HOTKEY_MOD_CONTROL | HOTKEY_MOD_SHIFT) && chord.vk == VK_F2);
+    CHECK(format_hotkey_chord(chord) == "Ctrl+Shift+F2");
+
+    CHECK(parse_hotkey_chord(" shift + control + m ", chord));
+    CHECK(format_hotkey_chord(chord) == "Ctrl+Shift+M");
+    CHECK(parse_hotkey_chord("Win+Space", chord) && chord.vk == 0x20);
+    CHECK(parse_hotkey_chord("Alt+F24", chord) && chord.vk == 0x87);
+    CHECK(parse_hotkey_chord("Ctrl+145", chord) && format_hotkey_chord(chord) == "Ctrl+ScrollLock");
+    CHECK(parse_hotkey_chord("Ctrl+146", chord) && format_hotkey_chord(chord) == "Ctrl+146");
+    CHECK(parse_hotkey_chord("pageup", chord) && format_hotkey_chord(chord) == "PageUp");
+
+    // A failed parse leaves the chord alone, empty text unbinds
+    HotkeyChord kept = { HOTKEY_MOD_ALT, 'K' };
+    for (const char* bad : { "Ctrl+", "Ctrl+Nothing", "Hyper+K", "F25", "F0", "256", "+K", "Ctrl++K" }) {
+        CHECK(!parse_hotkey_chord(bad, kept));
+    }
+    CHECK(kept.mods == HOTKEY_MOD_ALT && kept.vk == 'K');
+    CHECK(parse_hotkey_chord("", kept) && kept.empty());
+    CHECK(format_hotkey_chord(kept).empty());
+
+    // Every key code that has text survives format and parse
+    for (unsigned vk = 1; vk < 256; vk++) {
+        for (unsigned mods = 0; mods <= HOTKEY_MOD_MASK; mods++) {
+            HotkeyChord original = { mods, vk };
+            HotkeyChord parsed;
+            CHECK(parse_hotkey_chord(format_hotkey_chord(original), parsed) && parsed == original);
+        }
+    }
+}
+
+static void test_matcher() {
+    HotkeyMatcher matcher;
+    matcher.bind({ HOTKEY_MOD_CONTROL | HOTKEY_MOD_SHIFT, VK_F1 }, HotkeyAction::Toggle);
+    matcher.bind({ HOTKEY_MOD_CONTROL | HOTKEY_MOD_SHIFT, VK_F2 }, HotkeyAction::Mute);
+    matcher.bind({ HOTKEY_MOD_CONTROL, VK_F2 }, HotkeyAction::Unmute);
+    matcher.bind({ 0, 'M' }, HotkeyAction::CycleDevice);
+
+    // Unbound keys and modifiers pass through
+    CHECK(matcher.on_key('A', true).action == HotkeyAction::None);
+    CHECK(!matcher.on_key('A', true).swallow);
+    matcher.on_key('A', false);
+
+    matcher.on_key(VK_RCONTROL, true);
+    matcher.on_key(VK_LSHIFT, true);
+    CHECK(matcher.modifiers() == (HOTKEY_MOD_CONTROL | HOTKEY_MOD_SHIFT));
+
+    HotkeyEvent press = matcher.on_key(VK_F1, true);
+    CHECK(press.action == HotkeyAction::Toggle && press.edge == HotkeyEdge::Press && press.swallow);
+
+    // Auto-repeat reports nothing and is still hidden from other apps
+    HotkeyEvent repeat = matcher.on_key(VK_F1, true);
+    CHECK(repeat.action == HotkeyAction::None && repeat.swallow);
+
+    // The release belongs to the press, whatever the modifiers are by then
+    matcher.on_key(VK_LSHIFT, false);
+    HotkeyEvent release = matcher.on_key(VK_F1, false);
+    CHECK(release.action == HotkeyAction::Toggle && release.edge == HotkeyEdge::Release && release.swallow);
+
+    // Modifiers have to match exactly
+    CHECK(matcher.on_key(VK_F2, true).action == HotkeyAction::Unmute);
+    matcher.on_key(VK_F2, false);
+    CHECK(matcher.on_key(VK_F1, true).action == HotkeyAction::None);
+    CHECK(!matcher.on_key(VK_F1, false).swallow);
+    matcher.on_key(VK_LALT, true);
+    CHECK(matcher.on_key(VK_F2, true).action == HotkeyAction::None);
+    matcher.on_key(VK_F2, false);
+    matcher.on_key(VK_LALT, false);
+
+    // Left and right are held separately
+    matcher.on_key(VK_LCONTROL, true);
+    matcher.on_key(VK_RCONTROL, false);
+    CHECK(matcher.modifiers() == HOTKEY_MOD_CONTROL);
+    matcher.on_key(VK_LCONTROL, false);
+    CHECK(matcher.modifiers() == 0);
+
+    CHECK(matcher.on_key('M', true).action == HotkeyAction::CycleDevice);
+
+    // A later binding replaces the earlier one, clear() keeps the held key's release
+    matcher.bind({ 0, 'M' }, HotkeyAction::Toggle);
+    matcher.clear();
+    CHECK(matcher.on_key('M', false).action == HotkeyAction::CycleDevice);
+    CHECK(matcher.on_key('M', true).action == HotkeyAction::None);
+    matcher.on_key('M', false);
+
+    // Missed key-ups are forgotten
+    matcher.bind({ HOTKEY_MOD_CONTROL, VK_F2 }, HotkeyAction::Unmute);
+    matcher.on_key(VK_LCONTROL, true);
+    matcher.on_key(VK_F2, true);
+    matcher.reset_key_state();
+    CHECK(matcher.modifiers() == 0);
+    CHECK(matcher.on_key(VK_F2, false).action == HotkeyAction::None);
+    CHECK(matcher.on_key(VK_F2, true).action == HotkeyAction::None);
+    matcher.on_key(VK_F2, false);
+
+    CHECK(matcher.on_key(300, true).action == HotkeyAction::None);
+}
+
+// Feeds one key event through the matcher into the hold state machine,
+// returns 'M' or 'U' for a requested mute state and '-' for none
+static char hold_step(HotkeyMatcher& matcher, HoldStateMachine& hold, unsigned vk, bool down) {
+    bool muted = false;
+    if (!hold.on_event(matcher.on_key(vk, down), muted)) return '-';
+    return muted ? 'M' : 'U';
+}
+
+static void test_hold() {
+    HotkeyMatcher matcher;
+    HoldStateMachine hold;
+    matcher.bind({ HOTKEY_MOD_CONTROL, VK_F1 }, HotkeyAction::PushToTalk);
+    matcher.bind({ 0, VK_F2 }, HotkeyAction::PushToMute);
+    matcher.bind({ 0, 'T' }, HotkeyAction::Toggle);
+
+    // Push-to-talk: down, repeats, modifier let go first, up
+    CHECK(hold_step(matcher, hold, VK_LCONTROL, true) == '-');
+    CHECK(hold_step(matcher, hold, VK_F1, true) == 'U');
+    CHECK(hold.is_holding() && hold.current() == HotkeyAction::PushToTalk);
+    for (int i = 0; i < 5; i++) CHECK(hold_step(matcher, hold, VK_F1, true) == '-');
+    CHECK(hold_step(matcher, hold, VK_LCONTROL, false) == '-');
+    CHECK(hold_step(matcher, hold, VK_F1, false) == 'M');
+    CHECK(!hold.is_holding());
+
+    // Push-to-mute, other actions pass by untouched
+    CHECK(hold_step(matcher, hold, VK_F2, true) == 'M');
+    CHECK(hold_step(matcher, hold, 'T', true) == '-');
+    CHECK(hold_step(matcher, hold, 'T', false) == '-');
+    CHECK(hold_step(matcher, hold, VK_F2, false) == 'U');
+
+    // The latest hold key wins, releasing the overridden one does nothing
+    matcher.on_key(VK_LCONTROL, true);
+    CHECK(hold_step(matcher, hold, VK_F1, true) == 'U');
+    matcher.on_key(VK_LCONTROL, false);
+    CHECK(hold_step(matcher, hold, VK_F2, true) == 'M');
+    CHECK(hold_step(matcher, hold, VK_F1, false) == '-');
+    CHECK(hold.current() == HotkeyAction::PushToMute);
+    CHECK(hold_step(matcher, hold, VK_F2, false) == 'U');
+    CHECK(!hold.is_holding());
+
+    // Wrong modifiers: no press, so no release either
+    CHECK(hold_step(matcher, hold, VK_F1, true) == '-');
+    CHECK(hold_step(matcher, hold, VK_F1, false) == '-');
+
+    // A release with no press, as after a missed key-down
+    HotkeyEvent stray = { HotkeyAction::PushToTalk, HotkeyEdge::Release, true };
+    bool muted = false;
+    CHECK(!hold.on_event(stray, muted));
+}
+
+int main() {
+    test_chord_text();
+    test_matcher();
+    test_hold();
+    return test_result();
+}
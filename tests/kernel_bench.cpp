@@ -0,0 +1,81 @@
+// Throughput of each SIMD kernel the CPU can run next to its scalar
+// reference, on one second of 48 kHz audio.
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "bench_timer.h"
+#include "gain.h"
+#include "level_meter.h"
+#include "voice_activity.h"
+
+const size_t SECOND = 48000;
+const int ROUNDS = 200;
+
+// Best of ROUNDS, in microseconds
+template<typename Run>
+static double best_us(Run run) {
+    return best_ns_per_call(ROUNDS, 1, [&](int) { run(); }) / 1000;
+}
+
+static void bench_gain(const char* name, GainKernel kernel) {
+    std::mt19937 random(1);
+    std::vector<int16_t> source(SECOND * 2); // stereo
+    for (auto& s : source) s = (int16_t)(random() & 0xFFFF);
+    std::vector<int16_t> samples;
+
+    double us = best_us([&] {
+        samples = source;
+        kernel(samples.data(), samples.size(), 0.7f);
+    });
+    printf("gain  %-6s %8.1f us per second of 48 kHz stereo\n", name, us);
+}
+
+static void bench_vad(const char* name, VadKernel kernel) {
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> sample(-1.0f, 1.0f);
+    std::vector<float> samples(SECOND); // mono
+    for (auto& s : samples) s = sample(random);
+
+    VadFrameStats stats;
+    double us = best_us([&] {
+        stats = VadFrameStats();
+        kernel(samples.data(), samples.size(), 0.0f, stats);
+    });
+    printf("vad   %-6s %8.1f us per second of 48 kHz mono, %u crossings\n", name, us, stats.crossings);
+}
+
+static void bench_level(const char* name, LevelKernel kernel) {
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> sample(-1.0f, 1.0f);
+    std::vector<float> samples(SECOND); // mono
+    for (auto& s : samples) s = sample(random);
+
+    LevelStats stats;
+    double us = best_us([&] {
+        stats = LevelStats();
+        kernel(samples.data(), samples.size(), stats);
+    });
+    printf("level %-6s %8.1f us per second of 48 kHz mono, peak %.3f\n", name, us, stats.peak);
+}
+
+int main() {
+    bench_gain("scalar", gain_int16_scalar);
+#if MIC_X86
+    bench_gain("sse2", gain_int16_sse2);
+    if (cpu_has_avx2()) bench_gain("avx2", gain_int16_avx2);
+#endif
+    bench_vad("scalar", vad_stats_scalar);
+#if MIC_X86
+    bench_vad("sse2", vad_stats_sse2);
+    if (cpu_has_avx2()) bench_vad("avx2", vad_stats_avx2);
+#endif
+    bench_level("scalar", level_stats_scalar);
+#if MIC_X86
+    bench_level("sse2", level_stats_sse2);
+    if (cpu_has_avx2()) bench_level("avx2", level_stats_avx2);
+#endif
+    return 0;
+}
@@ -0,0 +1,293 @@
+// The SIMD kernels against their scalar reference over random buffers of
+// every short length and at unaligned starts, so the vector bodies, their
+// tails and the dispatch all get exercised. Kernels the CPU cannot run are
+// skipped.
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "gain.h"
+#include "level_meter.h"
+#include "test_check.h"
+#include "voice_activity.h"
+
+static std::mt19937 random_engine(20261016);
+
+// Lengths around every vector width, and a long one
+static std::vector<size_t> test_lengths() {
+    std::vector<size_t> lengths;
+    for (size_t n = 0; n <= 70; n++) lengths.push_back(n);
+    lengths.push_back(1000);
+    lengths.push_back(4801);
+    return lengths;
+}
+
+static std::vector<int16_t> random_pcm(size_t count) {
+    std::uniform_int_distribution<int> sample(-32768, 32767);
+    std::vector<int16_t> samples(count);
+    for (auto& s : samples) s = (int16_t)sample(random_engine);
+    // Full scale both ways, where saturation matters
+    if (count > 2) {
+        samples[0] = 32767;
+        samples[count - 1] = -32768;
+    }
+    return samples;
+}
+
+static void check_gain_kernel(GainKernel kernel) {
+    const float gains[] = { 0.0f, 0.25f, 0.5f, 0.999f, 1.0f, 1.5f, 4.0f };
+    for (size_t length : test_lengths()) {
+        for (size_t offset = 0; offset < 3; offset++) {
+            std::vector<int16_t> input = random_pcm(length + offset);
+            for (float gain : gains) {
+                std::vector<int16_t> expected = input;
+                std::vector<int16_t> actual = input;
+                gain_int16_scalar(expected.data() + offset, length, gain);
+                kernel(actual.data() + offset, length, gain);
+                CHECK(actual == expected);
+            }
+        }
+    }
+}
+
+static void test_gain() {
+    int16_t samples[4] = { 1000, -1000, 30000, -30000 };
+    gain_int16_scalar(samples, 4, 2.0f);
+    CHECK(samples[0] == 2000 && samples[1] == -2000);
+    CHECK(samples[2] == 32767 && samples[3] == -32768);
+
+    int16_t truncated[2] = { 3, -3 };
+    gain_int16_scalar(truncated, 2, 0.5f);
+    CHECK(truncated[0] == 1 && truncated[1] == -1); // toward zero
+
+#if MIC_X86
+    check_gain_kernel(gain_int16_sse2);
+    if (cpu_has_avx2()) check_gain_kernel(gain_int16_avx2);
+#endif
+    check_gain_kernel(select_gain_kernel());
+
+    std::vector<int16_t> unchanged = random_pcm(100);
+    std::vector<int16_t> copy = unchanged;
+    apply_gain_int16(copy.data(), copy.size(), 1.0f);
+    CHECK(copy == unchanged);
+
+    CHECK(volume_to_gain(-5) == 0.0f && volume_to_gain(0) == 0.0f);
+    CHECK(volume_to_gain(50) == 0.5f);
+    CHECK(volume_to_gain(100) == 1.0f && volume_to_gain(250) == 1.0f);
+}
+
+// Random signs in runs of random length, with exact +0 and -0 mixed in
+static std::vector<float> random_float(size_t count) {
+    std::uniform_real_distribution<float> magnitude(0.0f, 1.0f);
+    std::uniform_int_distribution<int> pick(0, 15);
+    std::vector<float> samples(count);
+    bool negative = false;
+    for (auto& s : samples) {
+        int p = pick(random_engine);
+        if (p < 5) negative = !negative;
+        s = p == 15 ? 0.0f : magnitude(random_engine);
+        if (negative) s = -s;
+    }
+    return samples;
+}
+
+// Float sums in a different order, so energy is compared with a tolerance
+static bool close_energy(double a, double b) {
+    return std::fabs(a - b) <= 1e-5 * std::fabs(b) + 1e-9;
+}
+
+static void check_vad_kernel(VadKernel kernel) {
+    for (size_t length : test_lengths()) {
+        for (size_t offset = 0; offset < 4; offset++) {
+            std::vector<float> input = random_float(length + offset);
+            const float* samples = input.data() + offset;
+            std::uniform_real_distribution<float> any(-1.0f, 1.0f);
+            for (float previous : { 0.0f, -0.0f, any(random_engine) }) {
+                // Stats accumulate, start from something
+                VadFrameStats expected = { 2.5, 7 };
+                VadFrameStats actual = expected;
+                vad_stats_scalar(samples, length, previous, expected);
+                kernel(samples, length, previous, actual);
+                CHECK(actual.crossings == expected.crossings);
+                CHECK(close_energy(actual.energy, expected.energy));
+            }
+        }
+    }
+}
+
+static void test_vad_kernels() {
+    // Every sample flips sign, starting from previous; -0 counts as negative
+    float alternating[37];
+    for (int i = 0; i < 37; i++) alternating[i] = i % 2 ? 0.5f : -0.0f;
+    VadFrameStats stats;
+    vad_stats_scalar(alternating, 37, 1.0f, stats);
+    CHECK(stats.crossings == 37 && stats.energy == 18 * 0.25);
+
+#if MIC_X86
+    for (VadKernel kernel : { vad_stats_sse2, vad_stats_avx2 }) {
+        if (kernel == vad_stats_avx2 && !cpu_has_avx2()) continue;
+        for (size_t length : { 4, 5, 8, 9, 13, 37 }) {
+            VadFrameStats simd;
+            kernel(alternating, length, 1.0f, simd);
+            CHECK(simd.crossings == length);
+            VadFrameStats none;
+            kernel(alternating + 1, length, 1.0f, none);
+            CHECK(none.crossings == length - 1);
+        }
+    }
+
+    check_vad_kernel(vad_stats_sse2);
+    if (cpu_has_avx2()) check_vad_kernel(vad_stats_avx2);
+#endif
+    check_vad_kernel(select_vad_kernel());
+}
+
+// Feeds a stream in chunks that do not line up with the 10 ms frames and
+// returns the millisecond of the last gate change, -1 for none
+template<typename Sample>
+static int feed(VoiceActivityDetector& vad, unsigned ms, Sample sample) {
+    const unsigned rate = 48000;
+    std::vector<float> chunk(457);
+    int changed = -1;
+    size_t total = (size_t)rate * ms / 1000;
+    for (size_t done = 0; done < total;) {
+        size_t n = total - done < chunk.size() ? total - done : chunk.size();
+        for (size_t i = 0; i < n; i++) chunk[i] = sample(done + i);
+        done += n;
+        if (vad.process(chunk.data(), n)) changed = (int)(done * 1000 / rate);
+    }
+    return changed;
+}
+
+static void test_vad_gate() {
+    VoiceActivityDetector vad;
+    VadSettings settings;
+    vad.configure(48000, settings);
+    CHECK(vad.gate_open());
+
+    std::uniform_real_distribution<float> hiss(-0.001f, 0.001f);
+    auto quiet = [&](size_t) { return hiss(random_engine); };
+    auto voice = [&](size_t i) {
+        return 0.3f * (float)std::sin(2 * 3.14159265 * 180 * (double)i / 48000) + hiss(random_engine);
+    };
+    std::uniform_real_distribution<float> loud(-0.5f, 0.5f);
+    auto white = [&](size_t) { return loud(random_engine); };
+
+    // Background alone closes the gate after the release time
+    int closed = feed(vad, 5000, quiet);
+    CHECK(!vad.gate_open());
+    CHECK(closed >= settings.release_ms && closed <= settings.release_ms + 20);
+
+    // Speech over it opens within the attack time
+    int opened = feed(vad, 500, voice);
+    CHECK(vad.gate_open() && vad.speech_detected());
+    CHECK(opened >= settings.attack_ms && opened <= settings.attack_ms + 20);
+
+    // Digital silence, as a muted driver delivers, closes it again after
+    // hangover and release
+    int release = settings.hangover_ms + settings.release_ms;
+    auto silence = [](size_t) { return 0.0f; };
+    CHECK(feed(vad, release - 100, silence) == -1);
+    CHECK(vad.gate_open());
+    int silenced = feed(vad, 200, silence);
+    CHECK(silenced >= 100 && silenced <= 120);
+    CHECK(!vad.gate_open());
+
+    // Loud white noise crosses zero too often to be speech
+    CHECK(feed(vad, 3000, white) == -1);
+    CHECK(!vad.gate_open() && !vad.speech_detected());
+}
+
+static void check_level_kernel(LevelKernel kernel) {
+    for (size_t length : test_lengths()) {
+        for (size_t offset = 0; offset < 4; offset++) {
+            std::vector<float> input = random_float(length + offset);
+            float* samples = input.data() + offset;
+            // The loudest sample is negative and in the tail
+            if (length > 0) samples[length - 1] = -1.0f;
+
+            // Stats carry over from the previous buffer, peak included
+            for (float carried : { 0.0f, 0.5f, 2.0f }) {
+                LevelStats expected;
+                expected.peak = carried;
+                expected.energy = 3.0;
+                LevelStats actual = expected;
+                level_stats_scalar(samples, length, expected);
+                kernel(samples, length, actual);
+                CHECK(actual.peak == expected.peak);
+                CHECK(close_energy(actual.energy, expected.energy));
+            }
+        }
+    }
+}
+
+static void test_level_kernels() {
+#if MIC_X86
+    check_level_kernel(level_stats_sse2);
+    if (cpu_has_avx2()) check_level_kernel(level_stats_avx2);
+#endif
+    check_level_kernel(select_level_kernel());
+}
+
+// Feeds windows of a constant magnitude with alternating sign, returns how
+// many of them reported a change
+static int feed_level(LevelMeter& meter, float magnitude, int windows) {
+    std::vector<float> window(48000 * LevelMeter::METER_WINDOW_MS / 1000);
+    for (size_t i = 0; i < window.size(); i++) window[i] = i % 2 ? magnitude : -magnitude;
+    int changes = 0;
+    for (int w = 0; w < windows; w++) changes += meter.process(window.data(), window.size());
+    return changes;
+}
+
+static void test_level_meter() {
+    LevelMeter meter;
+    meter.configure(48000);
+
+    // Silence never changes the reading
+    CHECK(feed_level(meter, 0.0f, 40) == 0);
+    CHECK(meter.level() == MeterLevel());
+
+    // Full scale reads as the top step, once
+    CHECK(feed_level(meter, 1.0f, 10) == 1);
+    CHECK(meter.level().rms == LevelMeter::LEVEL_STEPS && meter.level().peak == LevelMeter::LEVEL_STEPS);
+
+    // Back to silence: the bar drops at once, the tick one step per window
+    CHECK(feed_level(meter, 0.0f, 1) == 1);
+    CHECK(meter.level().rms == 0 && meter.level().peak == LevelMeter::LEVEL_STEPS - 1);
+    CHECK(feed_level(meter, 0.0f, 20) == (int)LevelMeter::LEVEL_STEPS - 1);
+    CHECK(meter.level() == MeterLevel());
+
+    // -20 dB is in the fourth 6 dB step above -48 dB
+    CHECK(feed_level(meter, 0.1f, 10) == 1);
+    CHECK(meter.level().rms == 4 && meter.level().peak == 4);
+
+    // A window split over many odd-sized buffers reads the same
+    meter.reset();
+    std::vector<float> samples(48000);
+    for (size_t i = 0; i < samples.size(); i++) samples[i] = i % 2 ? 0.1f : -0.1f;
+    bool changed = false;
+    for (size_t done = 0; done < samples.size(); done += 331) {
+        size_t n = samples.size() - done < 331 ? samples.size() - done : 331;
+        changed |= meter.process(samples.data() + done, n);
+    }
+    CHECK(changed && meter.level().rms == 4);
+
+    // The bar on the right edge only, red at the top step
+    uint32_t pixels[16 * 16] = {};
+    MeterLevel full;
+    full.rms = full.peak = LevelMeter::LEVEL_STEPS;
+    draw_level_bar(pixels, 16, 16, full);
+    CHECK(pixels[0] == 0 && pixels[15 * 16 + 12] == 0);
+    CHECK(pixels[15] == 0xFFE03030 && pixels[15 * 16 + 15] == 0xFF30C040);
+}
+
+int main() {
+    test_gain();
+    test_vad_kernels();
+    test_vad_gate();
+    test_level_kernels();
+    test_level_meter();
+    return test_result();
+}
@@ -0,0 +1,25 @@
+// Cost of tracing one toggle: a stage mark on its own, and a whole trace
+// from begin() through complete().
+
+#include <cstdio>
+
+#include "bench_timer.h"
+#include "latency_stats.h"
+
+const int TOGGLES = 100000;
+const int ROUNDS = 20;
+
+static LatencyRecorder recorder;
+
+int main() {
+    LatencyRecorder::TraceId trace = recorder.begin(latency_now_ns());
+    printf("mark            %6.1f ns\n", best_ns_per_call(ROUNDS, TOGGLES, [&](int) { recorder.mark(trace, STAGE_DISPATCHED); }));
+
+    printf("whole trace     %6.1f ns\n", best_ns_per_call(ROUNDS, TOGGLES, [&](int) {
+        LatencyRecorder::TraceId t = recorder.begin(latency_now_ns());
+        for (int stage = STAGE_DISPATCHED; stage < STAGE_COUNT; stage++) recorder.mark(t, (LatencyStage)stage);
+        recorder.complete(t);
+    }));
+    printf("%llu traces completed\n", (unsigned long long)recorder.completed());
+    return 0;
+}
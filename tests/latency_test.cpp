@@ -0,0 +1,163 @@
+// Latency histogram bucket bounds and percentiles, and the trace ring that
+// feeds it: stages that never ran, reused slots, abandoned traces, the
+// exported CSV.
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "latency_stats.h"
+#include "test_check.h"
+
+// The bucket's upper bound, read back through percentile(). A second,
+// larger value keeps the result from being clamped to the highest one.
+static uint64_t bucket_upper(uint64_t value) {
+    LatencyHistogram h;
+    h.record(value);
+    h.record(UINT64_MAX);
+    return h.percentile(50);
+}
+
+static void test_buckets() {
+    std::vector<uint64_t> values;
+    for (uint64_t v = 0; v < 4096; v++) values.push_back(v);
+    for (int bit = 12; bit < 64; bit++) {
+        uint64_t power = 1ull << bit;
+        for (uint64_t v : { power - 1, power, power + 1, power + power / 3 }) values.push_back(v);
+    }
+
+    uint64_t previous = 0;
+    for (uint64_t v : values) {
+        uint64_t upper = bucket_upper(v);
+        // Exact below 32, otherwise within 1/16 above the value
+        if (v < 32) CHECK(upper == v);
+        CHECK(upper >= v && upper - v <= v / 16);
+        CHECK(upper >= previous);
+        previous = upper;
+    }
+    CHECK(bucket_upper(UINT64_MAX - 1) == UINT64_MAX);
+}
+
+static void test_percentiles() {
+    LatencyHistogram h;
+    CHECK(h.count() == 0 && h.lowest() == 0 && h.highest() == 0 && h.percentile(99) == 0);
+
+    for (uint64_t v = 1; v <= 10000; v++) h.record(v * 1000);
+    CHECK(h.count() == 10000);
+    CHECK(h.lowest() == 1000 && h.highest() == 10000000);
+    const double ps[] = { 0, 1, 50, 99, 99.9 };
+    for (double p : ps) {
+        uint64_t exact = (uint64_t)(p / 100.0 * 10000 + 0.5);
+        if (exact < 1) exact = 1;
+        exact *= 1000;
+        uint64_t reported = h.percentile(p);
+        CHECK(reported >= exact && reported - exact <= exact / 16);
+    }
+    CHECK(h.percentile(100) == h.highest());
+
+    h.reset();
+    CHECK(h.count() == 0 && h.percentile(50) == 0);
+}
+
+static void test_recorder() {
+    static LatencyRecorder recorder; // a few kilobytes, keep it off the stack
+    recorder.mark(0, STAGE_DISPATCHED);
+    recorder.complete(0);
+    CHECK(recorder.completed() == 0);
+
+    // A full trace, and one that stopped at the backend
+    LatencyRecorder::TraceId full = recorder.begin(latency_now_ns());
+    for (int stage = STAGE_DISPATCHED; stage < STAGE_COUNT; stage++) recorder.mark(full, (LatencyStage)stage);
+    recorder.complete(full);
+    LatencyRecorder::TraceId partial = recorder.begin(latency_now_ns());
+    CHECK(partial != full && partial != 0);
+    recorder.mark(partial, STAGE_DISPATCHED);
+    recorder.mark(partial, STAGE_BACKEND_DONE);
+    recorder.complete(partial);
+
+    CHECK(recorder.completed() == 2);
+    CHECK(recorder.histogram(STAGE_DISPATCHED).count() == 2);
+    CHECK(recorder.histogram(STAGE_BACKEND_DONE).count() == 2);
+    CHECK(recorder.histogram(STAGE_SOUND_STARTED).count() == 1);
+    CHECK(recorder.histogram(STAGE_TRAY_UPDATED).count() == 1);
+    CHECK(recorder.histogram(STAGE_TRAY_UPDATED).lowest() >= recorder.histogram(STAGE_DISPATCHED).lowest());
+    CHECK(recorder.dropped_traces() == 0);
+
+    // A slot reused before its trace completed drops that trace
+    LatencyRecorder::TraceId overwritten = recorder.begin(latency_now_ns());
+    LatencyRecorder::TraceId last = overwritten;
+    for (uint32_t i = 0; i < LatencyRecorder::TRACE_SLOTS; i++) last = recorder.begin(latency_now_ns());
+    recorder.complete(overwritten);
+    recorder.complete(last);
+    CHECK(recorder.dropped_traces() == 1 && recorder.completed() == 3);
+
+    std::ostringstream csv;
+    recorder.write_csv(csv);
+    std::string text = csv.str();
+    CHECK(text.compare(0, 48, "stage,count,min_us,p50_us,p99_us,p999_us,max_us\n") == 0);
+    CHECK(text.find("\ndispatched,2,") != std::string::npos); // the last trace has no stages
+    CHECK(text.find("\nsound_started,1,") != std::string::npos);
+    CHECK(text.find("hook_received") == std::string::npos);
+
+    recorder.reset();
+    CHECK(recorder.completed() == 0 && recorder.dropped_traces() == 0);
+}
+
+// The mute worker's paths that never complete a trace: requests folded
+// into a newer one, a change with nothing to do, a full request queue
+static void test_abandon() {
+    static LatencyRecorder recorder;
+    recorder.abandon(0);
+    CHECK(recorder.dropped_traces() == 0);
+
+    LatencyRecorder::TraceId kept = 0;
+    for (int i = 0; i < 3; i++) {
+        recorder.abandon(kept);
+        kept = recorder.begin(latency_now_ns());
+    }
+    recorder.mark(kept, STAGE_DISPATCHED);
+    recorder.complete(kept);
+    CHECK(recorder.completed() == 1 && recorder.dropped_traces() == 2);
+
+    // Abandoned on the hook thread while the UI thread completes others
+    std::thread hook([] {
+        for (int i = 0; i < 1000; i++) recorder.abandon(recorder.begin(latency_now_ns()));
+    });
+    for (int i = 0; i < 1000; i++) recorder.complete(recorder.begin(latency_now_ns()));
+    hook.join();
+    CHECK(recorder.completed() + recorder.dropped_traces() == 2003);
+    CHECK(recorder.dropped_traces() >= 1002);
+
+    std::ostringstream summary;
+    recorder.write_summary(summary);
+    std::string expected = "Toggles measured: " + std::to_string(recorder.completed()) +
+        ", not completed: " + std::to_string(recorder.dropped_traces()) + "\n";
+    CHECK(summary.str().compare(0, expected.size(), expected) == 0);
+
+    recorder.reset();
+    CHECK(recorder.dropped_traces() == 0);
+}
+
+static void test_startup_trace() {
+    StartupTrace trace;
+    for (size_t i = 0; i < StartupTrace::MAX_PHASES + 4; i++) trace.mark("phase");
+    CHECK(trace.size() == StartupTrace::MAX_PHASES);
+
+    uint64_t sum = 0;
+    for (size_t i = 0; i < trace.size(); i++) sum += trace.phase(i).duration_ns;
+    CHECK(sum <= trace.total_ns());
+
+    trace.restart();
+    CHECK(trace.size() == 0 && trace.total_ns() == 0);
+}
+
+int main() {
+    test_buckets();
+    test_percentiles();
+    test_recorder();
+    test_abandon();
+    test_startup_trace();
+    return test_result();
+}
@@ -0,0 +1,43 @@
+// Append rate of the mute event ring, from one thread and from several
+// threads sharing the sequence counter.
+
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "bench_timer.h"
+#include "mute_event_log.h"
+
+const int APPENDS = 1000000;
+const int ROUNDS = 5;
+
+static double appends_per_second(MuteEventLog& log, int thread_count) {
+    MuteEvent event;
+    event.device_id = "{0.0.1.00000000}.{headset}";
+    event.device_name = "Headset Microphone";
+    event.muted = true;
+    event.source = MuteSource::Hotkey;
+
+    double ns = best_ns_per_call(ROUNDS, 1, [&](int) {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < thread_count; t++) {
+            threads.emplace_back([&log, event, thread_count] {
+                for (int i = 0; i < APPENDS / thread_count; i++) log.append(event);
+            });
+        }
+        for (auto& thread : threads) thread.join();
+    });
+    return APPENDS / (ns / 1e9);
+}
+
+int main() {
+    std::vector<uint64_t> memory(MuteEventLog::FILE_SIZE / 8);
+    MuteEventLog log;
+    log.attach(memory.data(), MuteEventLog::FILE_SIZE);
+
+    for (int threads : { 1, 2, 4 }) {
+        printf("%d thread%s %6.2f M appends/s\n", threads, threads == 1 ? " " : "s", appends_per_second(log, threads) / 1e6);
+    }
+    return 0;
+}
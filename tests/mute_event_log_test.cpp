@@ -0,0 +1,152 @@
+// The mute event ring on plain memory: records read back intact and in
+// order, torn records and records from an older lap are skipped, and
+// appends from several threads each land exactly once.
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mute_event_log.h"
+#include "test_check.h"
+
+// Word storage keeps the header's atomic aligned, as a mapping would
+static std::vector<uint64_t> log_memory() {
+    return std::vector<uint64_t>(MuteEventLog::FILE_SIZE / 8);
+}
+
+static MuteEvent event(bool muted, MuteSource source, int64_t time_us) {
+    MuteEvent e;
+    e.device_id = "{0.0.1.00000000}.{headset}";
+    e.device_name = "Headset Microphone";
+    e.was_muted = !muted;
+    e.muted = muted;
+    e.source = source;
+    e.time_us = time_us;
+    return e;
+}
+
+static std::vector<MuteEventRecord> read_back(const std::vector<uint64_t>& memory) {
+    MuteEventReader reader;
+    CHECK(reader.open(memory.data(), MuteEventLog::FILE_SIZE));
+    return reader.records();
+}
+
+static void test_append_and_read() {
+    std::vector<uint64_t> memory = log_memory();
+    MuteEventReader reader;
+    CHECK(!reader.open(memory.data(), MuteEventLog::FILE_SIZE)); // not formatted yet
+    CHECK(!reader.open(memory.data(), MuteEventLog::FILE_SIZE - 1));
+
+    MuteEventLog log;
+    CHECK(!log.attach(memory.data(), MuteEventLog::FILE_SIZE - 1));
+    CHECK(log.attach(memory.data(), MuteEventLog::FILE_SIZE));
+    CHECK(read_back(memory).empty());
+
+    for (MuteSource source : MUTE_SOURCES) log.append(event(true, source, 1000 + (int64_t)source));
+    MuteEvent failed = event(false, MuteSource::Hotkey, 0);
+    failed.failed = true;
+    failed.device_name = "A device name far longer than the thirty-six bytes kept";
+    log.append(failed);
+
+    std::vector<MuteEventRecord> records = read_back(memory);
+    size_t sources = sizeof(MUTE_SOURCES) / sizeof(MUTE_SOURCES[0]);
+    CHECK(records.size() == sources + 1);
+    if (records.size() != sources + 1) return;
+    for (size_t i = 0; i < sources; i++) {
+        CHECK(records[i].sequence == i + 1);
+        CHECK(records[i].time_us == 1000 + (int64_t)i && records[i].source == (uint8_t)MUTE_SOURCES[i]);
+        CHECK(records[i].muted == 1 && records[i].was_muted == 0 && records[i].flags == 0);
+        CHECK(mute_event_device(records[i]) == "Headset Microphone");
+        CHECK(records[i].device_hash == mute_event_hash(failed.device_id.data(), failed.device_id.size()));
+    }
+    const MuteEventRecord& last = records.back();
+    CHECK(last.flags == MUTE_EVENT_FAILED && last.time_us > 0);
+    CHECK(mute_event_device(last) == failed.device_name.substr(0, MUTE_EVENT_DEVICE_NAME));
+
+    // Reattaching keeps the log
+    CHECK(log.attach(memory.data(), MuteEventLog::FILE_SIZE));
+    log.append(event(false, MuteSource::Tray, 5));
+    CHECK(read_back(memory).size() == sources + 2);
+
+    CHECK(std::string(mute_source_name(MuteSource::VoiceActivity)) == "voice");
+    CHECK(std::string(mute_source_name((MuteSource)200)) == "unknown");
+}
+
+static void test_torn_and_stale() {
+    std::vector<uint64_t> memory = log_memory();
+    MuteEventLog log;
+    log.attach(memory.data(), MuteEventLog::FILE_SIZE);
+    for (int i = 0; i < 10; i++) log.append(event(i % 2 == 0, MuteSource::Hotkey, i + 1));
+
+    // A record half written when the process died
+    char* slots = (char*)memory.data() + sizeof(MuteEventLogHeader);
+    slots[4 * sizeof(MuteEventRecord) + 20] ^= 0x40;
+    // A sequence claimed but never written
+    log.append(event(true, MuteSource::Hotkey, 11));
+    memset(slots + 10 * sizeof(MuteEventRecord), 0, sizeof(MuteEventRecord));
+
+    std::vector<MuteEventRecord> records = read_back(memory);
+    CHECK(records.size() == 9);
+    for (const MuteEventRecord& r : records) CHECK(r.sequence != 5 && r.sequence <= 10);
+
+    // A record in the wrong slot, as from a copy of another log
+    log.append(event(true, MuteSource::Hotkey, 12));
+    memcpy(slots + 11 * sizeof(MuteEventRecord), slots, sizeof(MuteEventRecord));
+    CHECK(read_back(memory).size() == 9);
+}
+
+static void test_lap() {
+    std::vector<uint64_t> memory = log_memory();
+    MuteEventLog log;
+    log.attach(memory.data(), MuteEventLog::FILE_SIZE);
+    const uint64_t total = MUTE_EVENT_LOG_CAPACITY + 100;
+    for (uint64_t i = 0; i < total; i++) log.append(event(i % 2 == 0, MuteSource::Control, (int64_t)i + 1));
+
+    // The oldest lap is gone, the rest is in order
+    std::vector<MuteEventRecord> records = read_back(memory);
+    CHECK(records.size() == MUTE_EVENT_LOG_CAPACITY);
+    if (records.empty()) return;
+    CHECK(records.front().sequence == 101 && records.back().sequence == total);
+    for (size_t i = 1; i < records.size(); i++) CHECK(records[i].sequence == records[i - 1].sequence + 1);
+
+    // A reader of an older copy of the header sees no record from the newer lap
+    MuteEventLogHeader& header = *(MuteEventLogHeader*)memory.data();
+    header.next.store(50, std::memory_order_relaxed);
+    CHECK(read_back(memory).empty());
+}
+
+static void test_threads() {
+    std::vector<uint64_t> memory = log_memory();
+    MuteEventLog log;
+    log.attach(memory.data(), MuteEventLog::FILE_SIZE);
+
+    const int THREADS = 4;
+    const int EACH = 5000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++) {
+        threads.emplace_back([&log, t] {
+            for (int i = 0; i < EACH; i++) log.append(event(i % 2 == 0, MuteSource::Tray, (int64_t)t * EACH + i + 1));
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    std::vector<MuteEventRecord> records = read_back(memory);
+    CHECK(records.size() == (size_t)THREADS * EACH);
+    std::vector<bool> seen(THREADS * EACH + 1);
+    for (size_t i = 0; i < records.size(); i++) {
+        CHECK(records[i].sequence == i + 1);
+        int64_t stamp = records[i].time_us;
+        CHECK(stamp >= 1 && stamp <= THREADS * EACH && !seen[stamp]);
+        if (stamp >= 1 && stamp <= THREADS * EACH) seen[stamp] = true;
+    }
+}
+
+int main() {
+    test_append_and_read();
+    test_torn_and_stale();
+    test_lap();
+    test_threads();
+    return test_result();
+}
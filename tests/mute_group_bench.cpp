@@ -0,0 +1,46 @@
+// How far apart the members of a mute group change state: toggles a group
+// of mock devices and reports the first-to-last completion spread and the
+// time of a whole set_mute().
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "bench_timer.h"
+#include "mock_backend.h"
+#include "mute_group.h"
+
+const int TOGGLES = 2000;
+
+static void bench_group(size_t devices) {
+    MockAudioBackend backend;
+    MuteGroup group;
+    for (size_t i = 0; i < devices; i++) {
+        std::string id = "{mock.bench." + std::to_string(i) + "}";
+        backend.add_device(id, "Bench Microphone " + std::to_string(i));
+        group.add(backend.open_device(id), id, false);
+    }
+
+    std::vector<double> spread;
+    std::vector<double> total;
+    MuteGroup::Result result;
+    for (int i = 0; i < TOGGLES; i++) {
+        auto start = std::chrono::steady_clock::now();
+        group.set_mute(i % 2 == 0, result);
+        total.push_back(elapsed_us(start));
+        spread.push_back(std::chrono::duration<double, std::micro>(result.spread).count());
+    }
+
+    printf("%zu devices, %d toggles\n", devices, TOGGLES);
+    print_percentiles("spread", spread);
+    print_percentiles("set_mute", total);
+}
+
+int main() {
+    bench_group(1);
+    bench_group(2);
+    bench_group(4);
+    bench_group(8);
+    return 0;
+}
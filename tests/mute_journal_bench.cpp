@@ -0,0 +1,36 @@
+// What the crash journal adds to a toggle: begin_change and end_change for
+// every member of a group, and note() for a change made elsewhere.
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "bench_timer.h"
+#include "mute_journal.h"
+
+const int TOGGLES = 1000000;
+const int ROUNDS = 10;
+
+int main() {
+    std::vector<uint64_t> storage(MuteJournal::FILE_SIZE / 8 + 1);
+    MuteJournal journal;
+    std::vector<MuteJournalEntry> unfinished;
+    journal.attach(storage.data(), MuteJournal::FILE_SIZE, unfinished);
+
+    for (size_t devices : { 1, 3, 8 }) {
+        std::vector<MuteJournalEntry> group(devices);
+        for (size_t i = 0; i < devices; i++) group[i].id = "{0.0.1.00000000}.{" + std::to_string(i) + "}";
+        journal.bind(group);
+
+        double toggle = best_ns_per_call(ROUNDS, TOGGLES, [&](int i) {
+            bool muted = (i & 1) != 0;
+            for (size_t slot = 0; slot < devices; slot++) journal.begin_change(slot, muted);
+            for (size_t slot = 0; slot < devices; slot++) journal.end_change(slot, muted);
+        });
+        double note = best_ns_per_call(ROUNDS, TOGGLES, [&](int i) { journal.note((size_t)i % devices, (i & 2) != 0); });
+        printf("%zu devices  toggle %6.1f ns  note %5.1f ns\n", devices, toggle, note);
+    }
+    journal.close();
+    return 0;
+}
@@ -0,0 +1,206 @@
+// The crash journal on plain memory: formatting, clean and unclean
+// sessions, pending changes and slot limits. On POSIX systems it is then
+// mapped from a file with MAP_SHARED, as the program maps it, and child
+// processes that toggle and rebind are killed at random points: every
+// journal left behind has to read back as one whole device set.
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "mute_journal.h"
+#include "test_check.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#define MUTE_JOURNAL_FAULT_TEST 1
+#endif
+
+static MuteJournalEntry entry(const std::string& id, bool original_muted, bool muted) {
+    MuteJournalEntry e;
+    e.id = id;
+    e.original_muted = original_muted;
+    e.muted = muted;
+    return e;
+}
+
+static void test_sessions() {
+    // Word storage keeps the atomics aligned, as a mapping would
+    std::vector<uint64_t> storage(MuteJournal::FILE_SIZE / 8 + 1);
+    void* memory = storage.data();
+    memset(memory, 0xA5, MuteJournal::FILE_SIZE);
+
+    MuteJournal journal;
+    std::vector<MuteJournalEntry> unfinished = { entry("stale", false, false) };
+    CHECK(!journal.attach(memory, MuteJournal::FILE_SIZE - 1, unfinished));
+    CHECK(!journal.attached() && unfinished.empty());
+
+    // Garbage is formatted, nothing to reconcile
+    CHECK(journal.attach(memory, MuteJournal::FILE_SIZE, unfinished));
+    CHECK(journal.attached() && unfinished.empty());
+
+    // A clean session leaves nothing behind
+    journal.bind({ entry("{a}", false, false), entry("{b}", true, true) });
+    journal.begin_change(0, true);
+    journal.end_change(0, true);
+    journal.close();
+    CHECK(journal.attach(memory, MuteJournal::FILE_SIZE, unfinished) && unfinished.empty());
+
+    // A killed one returns every device with its last state
+    journal.bind({ entry("{a}", false, false), entry("{b}", true, true), entry("{c}", false, true) });
+    journal.begin_change(0, true);
+    journal.end_change(0, true);
+    journal.note(1, false);
+    journal.begin_change(2, false); // never finished
+    journal.begin_change(7, true);  // past the bound devices, ignored
+    journal.detach();
+    journal.begin_change(0, false); // detached, ignored
+
+    CHECK(journal.attach(memory, MuteJournal::FILE_SIZE, unfinished));
+    CHECK(unfinished.size() == 3);
+    if (unfinished.size() == 3) {
+        CHECK(unfinished[0].id == "{a}" && !unfinished[0].original_muted && unfinished[0].muted && !unfinished[0].pending);
+        CHECK(unfinished[1].id == "{b}" && unfinished[1].original_muted && !unfinished[1].muted);
+        CHECK(unfinished[2].id == "{c}" && unfinished[2].muted && unfinished[2].pending && !unfinished[2].pending_muted);
+    }
+
+    // Still there for a second start that crashes before bind()
+    CHECK(journal.attach(memory, MuteJournal::FILE_SIZE, unfinished) && unfinished.size() == 3);
+
+    // Ids that do not fit are skipped, devices past the last slot dropped
+    std::vector<MuteJournalEntry> many;
+    many.push_back(entry(std::string(MUTE_JOURNAL_MAX_ID + 1, 'x'), false, false));
+    many.push_back(entry(std::string(MUTE_JOURNAL_MAX_ID, 'y'), false, true));
+    for (size_t i = 0; i < MUTE_JOURNAL_SLOTS; i++) many.push_back(entry("{" + std::to_string(i) + "}", false, false));
+    journal.bind(many);
+    CHECK(journal.attach(memory, MuteJournal::FILE_SIZE, unfinished));
+    CHECK(unfinished.size() == MUTE_JOURNAL_SLOTS - 1);
+    if (!unfinished.empty()) CHECK(unfinished[0].id.size() == MUTE_JOURNAL_MAX_ID && unfinished[0].muted);
+    if (unfinished.size() == MUTE_JOURNAL_SLOTS - 1) CHECK(unfinished.back().id == "{5}");
+
+    // Another version is formatted over
+    uint32_t version = MUTE_JOURNAL_VERSION + 1;
+    memcpy((char*)memory + 4, &version, sizeof(version));
+    CHECK(journal.attach(memory, MuteJournal::FILE_SIZE, unfinished) && unfinished.empty());
+}
+
+#if MUTE_JOURNAL_FAULT_TEST
+const int KILLS = 400;
+
+static const std::vector<std::string>& device_set(int which) {
+    static const std::vector<std::string> sets[2] = {
+        { "{0.0.1.00000000}.{headset}", "{0.0.1.00000000}.{webcam}", "{0.0.1.00000000}.{line}" },
+        { "{0.0.1.00000000}.{usb-microphone-with-a-longer-id}", "{0.0.1.00000000}.{x}" },
+    };
+    return sets[which];
+}
+
+// What the program does, forever: bind a group, toggle it, now and then
+// shut down cleanly or switch to the other group
+static void journal_child(void* memory, unsigned seed) {
+    std::mt19937 random(seed);
+    MuteJournal journal;
+    std::vector<MuteJournalEntry> unfinished;
+    journal.attach(memory, MuteJournal::FILE_SIZE, unfinished);
+
+    std::vector<bool> muted;
+    for (int which = 0;; which ^= 1) {
+        std::vector<MuteJournalEntry> devices;
+        muted.clear();
+        for (const std::string& id : device_set(which)) {
+            bool m = random() & 1;
+            devices.push_back(entry(id, m, m));
+            muted.push_back(m);
+        }
+        journal.bind(devices);
+
+        for (int toggle = (int)(random() % 200); toggle > 0; toggle--) {
+            size_t slot = random() % muted.size();
+            if (random() % 4 == 0) {
+                muted[slot] = !muted[slot];
+                journal.note(slot, muted[slot]);
+                continue;
+            }
+            journal.begin_change(slot, !muted[slot]);
+            muted[slot] = !muted[slot];
+            journal.end_change(slot, muted[slot]);
+        }
+        if (random() % 3 == 0) journal.close();
+    }
+}
+
+static void test_killed_sessions() {
+    char path[] = "/tmp/mute_journal_test.XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    if (fd < 0) return;
+    unlink(path);
+    CHECK(ftruncate(fd, MuteJournal::FILE_SIZE) == 0);
+
+    std::mt19937 random(20261016);
+    int with_devices = 0;
+    int pending = 0;
+    for (int kill_round = 0; kill_round < KILLS; kill_round++) {
+        void* memory = mmap(nullptr, MuteJournal::FILE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        CHECK(memory != MAP_FAILED);
+        if (memory == MAP_FAILED) break;
+
+        pid_t child = fork();
+        if (child == 0) {
+            journal_child(memory, (unsigned)random());
+            _exit(0);
+        }
+        munmap(memory, MuteJournal::FILE_SIZE);
+
+        struct timespec wait = { 0, (long)(random() % 2000) * 1000 };
+        nanosleep(&wait, nullptr);
+        kill(child, SIGKILL);
+        int status = 0;
+        waitpid(child, &status, 0);
+
+        // What the next start sees, through a fresh mapping of the file
+        memory = mmap(nullptr, MuteJournal::FILE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (memory == MAP_FAILED) break;
+        MuteJournal journal;
+        std::vector<MuteJournalEntry> unfinished;
+        CHECK(journal.attach(memory, MuteJournal::FILE_SIZE, unfinished));
+
+        // Nothing, or exactly one whole device set in group order
+        if (!unfinished.empty()) {
+            with_devices++;
+            const std::vector<std::string>& set =
+                unfinished[0].id == device_set(0)[0] ? device_set(0) : device_set(1);
+            CHECK(unfinished.size() == set.size());
+            for (size_t i = 0; i < unfinished.size() && i < set.size(); i++) {
+                CHECK(unfinished[i].id == set[i]);
+                // Every change is a flip, so a pending one leads away from the settled state
+                if (unfinished[i].pending) {
+                    pending++;
+                    CHECK(unfinished[i].pending_muted != unfinished[i].muted);
+                }
+            }
+        }
+        munmap(memory, MuteJournal::FILE_SIZE);
+    }
+    close(fd);
+
+    // The kills have to have landed mid-session and mid-change, or nothing was tested
+    CHECK(with_devices > KILLS / 4);
+    CHECK(pending > 0);
+}
+#endif
+
+int main() {
+    test_sessions();
+#if MUTE_JOURNAL_FAULT_TEST
+    test_killed_sessions();
+#endif
+    return test_result();
+}
@@ -0,0 +1,129 @@
+// The path from the keyboard hook to the mute worker: a producer pushing
+// intents into the SPSC ring while the consumer drains and folds them, the
+// way mute_worker_loop does. Whatever the interleaving, every request
+// arrives once and in order, and the folded state equals applying every
+// intent one at a time.
+
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "mute_intent.h"
+#include "spsc_queue.h"
+#include "test_check.h"
+
+struct Request {
+    MuteIntent intent;
+    uint32_t sequence;
+};
+
+static bool apply_one(bool muted, MuteIntent intent) {
+    switch (intent) {
+    case MuteIntent::Toggle: return !muted;
+    case MuteIntent::Mute: return true;
+    case MuteIntent::Unmute: return false;
+    }
+    return muted;
+}
+
+static void test_fold() {
+    const MuteIntent all[] = { MuteIntent::Toggle, MuteIntent::Mute, MuteIntent::Unmute };
+
+    // Every sequence of up to 6 intents, from both starting states
+    for (int length = 0; length <= 6; length++) {
+        int combinations = 1;
+        for (int i = 0; i < length; i++) combinations *= 3;
+
+        for (int c = 0; c < combinations; c++) {
+            MuteChange change;
+            bool expected[2] = { false, true };
+            for (int i = 0, rest = c; i < length; i++, rest /= 3) {
+                change.add(all[rest % 3]);
+                expected[0] = apply_one(expected[0], all[rest % 3]);
+                expected[1] = apply_one(expected[1], all[rest % 3]);
+            }
+            CHECK(change.apply(false) == expected[0]);
+            CHECK(change.apply(true) == expected[1]);
+            if (change.empty()) CHECK(!expected[0] && expected[1]);
+        }
+    }
+
+    MuteChange twice;
+    twice.add(MuteIntent::Toggle);
+    twice.add(MuteIntent::Toggle);
+    CHECK(twice.empty());
+}
+
+static void test_full_queue() {
+    SpscQueue<Request, 4> queue;
+    for (uint32_t i = 0; i < 4; i++) CHECK(queue.push({ MuteIntent::Toggle, i }));
+    CHECK(!queue.push({ MuteIntent::Toggle, 4 }));
+
+    Request request;
+    CHECK(queue.pop(request) && request.sequence == 0);
+    CHECK(queue.push({ MuteIntent::Mute, 4 }));
+    for (uint32_t i = 1; i <= 4; i++) CHECK(queue.pop(request) && request.sequence == i);
+    CHECK(!queue.pop(request) && queue.empty());
+}
+
+// The consumer folds whatever is queued into one change per wake-up, as
+// the worker does, and yields when it finds nothing so bursts build up
+static void test_stress(uint32_t count, unsigned seed) {
+    std::vector<MuteIntent> intents(count);
+    std::mt19937 random(seed);
+    for (auto& intent : intents) {
+        unsigned r = random() % 8;
+        intent = r < 6 ? MuteIntent::Toggle : (r == 6 ? MuteIntent::Mute : MuteIntent::Unmute);
+    }
+
+    bool expected = false;
+    for (MuteIntent intent : intents) expected = apply_one(expected, intent);
+
+    SpscQueue<Request, 64> queue;
+    std::atomic<bool> done{ false };
+
+    std::thread producer([&] {
+        for (uint32_t i = 0; i < count; i++) {
+            while (!queue.push({ intents[i], i })) std::this_thread::yield();
+        }
+        done = true;
+    });
+
+    bool muted = false;
+    uint32_t next = 0;
+    uint32_t batches = 0;
+    bool in_order = true;
+    for (;;) {
+        bool finished = done.load();
+        MuteChange change;
+        Request request;
+        bool any = false;
+        while (queue.pop(request)) {
+            if (request.sequence != next) in_order = false;
+            next++;
+            change.add(request.intent);
+            any = true;
+        }
+        if (any) {
+            muted = change.apply(muted);
+            batches++;
+        }
+        if (finished && queue.empty()) break;
+        if (!any) std::this_thread::yield();
+    }
+    producer.join();
+
+    CHECK(in_order);
+    CHECK(next == count);
+    CHECK(muted == expected);
+    CHECK(batches >= 1 && batches <= count);
+}
+
+int main() {
+    test_fold();
+    test_full_queue();
+    for (unsigned seed = 1; seed <= 20; seed++) test_stress(50000, seed);
+    return test_result();
+}
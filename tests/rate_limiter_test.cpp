@@ -0,0 +1,133 @@
+// Token buckets against a fake clock: burst and refill boundaries to the
+// nanosecond, plain cooldowns, unlimited and out-of-range sources, and
+// threads racing for the tokens of a frozen bucket.
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "rate_limiter.h"
+#include "test_check.h"
+
+static std::atomic<int64_t> fake_now{ 0 };
+
+static int64_t fake_clock() {
+    return fake_now.load(std::memory_order_relaxed);
+}
+
+const int64_t MS = 1000000;
+
+static void test_burst_and_refill() {
+    fake_now = 5000 * MS;
+    RateLimiter limiter(fake_clock);
+    limiter.configure(0, { 100, 3 });
+
+    // A full bucket: three at once, then nothing
+    CHECK(limiter.wait_ns(0) == 0);
+    CHECK(limiter.allow(0) && limiter.allow(0) && limiter.allow(0));
+    CHECK(!limiter.allow(0));
+    CHECK(limiter.wait_ns(0) == 100 * MS);
+
+    // One token per interval, not a nanosecond early
+    fake_now += 100 * MS - 1;
+    CHECK(limiter.wait_ns(0) == 1 && !limiter.allow(0));
+    fake_now += 1;
+    CHECK(limiter.wait_ns(0) == 0 && limiter.allow(0));
+    CHECK(!limiter.allow(0));
+
+    // A long pause refills to the burst and no further
+    fake_now += 10000 * MS;
+    for (int i = 0; i < 3; i++) CHECK(limiter.allow(0));
+    CHECK(!limiter.allow(0));
+
+    // Two intervals later, two tokens
+    fake_now += 200 * MS;
+    CHECK(limiter.allow(0) && limiter.allow(0));
+    CHECK(!limiter.allow(0));
+
+    // Reconfiguring starts over full
+    limiter.configure(0, { 100, 3 });
+    CHECK(limiter.allow(0) && limiter.allow(0) && limiter.allow(0));
+}
+
+static void test_cooldown() {
+    fake_now = 0;
+    RateLimiter limiter(fake_clock);
+    limiter.configure(1, { 250, 1 });
+    limiter.configure(2, { 250, 0 });  // a burst below one is one
+    limiter.configure(3, { 250, -4 });
+
+    for (size_t source = 1; source <= 3; source++) {
+        CHECK(limiter.allow(source));
+        CHECK(!limiter.allow(source));
+        CHECK(limiter.wait_ns(source) == 250 * MS);
+    }
+    fake_now = 249 * MS;
+    for (size_t source = 1; source <= 3; source++) CHECK(!limiter.allow(source));
+    fake_now = 250 * MS;
+    for (size_t source = 1; source <= 3; source++) CHECK(limiter.allow(source) && !limiter.allow(source));
+
+    // Sources are independent
+    RateLimiter other(fake_clock);
+    other.configure(0, { 1000, 1 });
+    other.configure(1, { 1000, 1 });
+    CHECK(other.allow(0) && !other.allow(0));
+    CHECK(other.allow(1));
+}
+
+static void test_unlimited() {
+    fake_now = 0;
+    RateLimiter limiter(fake_clock);
+    // Unconfigured and zero-interval sources never throttle
+    for (int i = 0; i < 1000; i++) CHECK(limiter.allow(4));
+    limiter.configure(5, { 0, 5 });
+    limiter.configure(6, { -10, 1 });
+    for (int i = 0; i < 1000; i++) CHECK(limiter.allow(5) && limiter.allow(6));
+    CHECK(limiter.wait_ns(5) == 0 && limiter.wait_ns(6) == 0);
+
+    // Neither do sources past the table, and configuring one is a no-op
+    limiter.configure(RateLimiter::MAX_SOURCES, { 1000, 1 });
+    for (int i = 0; i < 10; i++) CHECK(limiter.allow(RateLimiter::MAX_SOURCES) && limiter.allow(100));
+    CHECK(limiter.wait_ns(RateLimiter::MAX_SOURCES) == 0);
+
+    // A limit lifted at runtime takes effect at once
+    limiter.configure(7, { 1000, 1 });
+    CHECK(limiter.allow(7) && !limiter.allow(7));
+    limiter.configure(7, { 0, 1 });
+    CHECK(limiter.allow(7) && limiter.allow(7));
+}
+
+// With the clock frozen, racing threads get exactly burst tokens between them
+static void test_race() {
+    const int THREADS = 8;
+    const int BURST = 5;
+    fake_now = 1000 * MS;
+    RateLimiter limiter(fake_clock);
+
+    for (int round = 0; round < 200; round++) {
+        limiter.configure(0, { 1000, BURST });
+        std::atomic<int> ready{ 0 };
+        std::atomic<int> granted{ 0 };
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREADS; t++) {
+            threads.emplace_back([&] {
+                ready++;
+                while (ready.load() < THREADS) std::this_thread::yield();
+                for (int i = 0; i < 4; i++) {
+                    if (limiter.allow(0)) granted++;
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        CHECK(granted.load() == BURST);
+    }
+}
+
+int main() {
+    test_burst_and_refill();
+    test_cooldown();
+    test_unlimited();
+    test_race();
+    return test_result();
+}
@@ -0,0 +1,75 @@
+// logfmt value quoting and the shape of written lines, including lines
+// written from several threads at once.
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "structured_log.h"
+#include "test_check.h"
+
+static std::string value_text(const std::string& value) {
+    std::string line;
+    append_log_value(line, value);
+    return line;
+}
+
+static void test_values() {
+    CHECK(value_text("plain") == "plain");
+    CHECK(value_text("C:\\Users\\mic.wav") == "C:\\Users\\mic.wav");
+    CHECK(value_text("") == "\"\"");
+    CHECK(value_text("USB Mic") == "\"USB Mic\"");
+    CHECK(value_text("a=b") == "\"a=b\"");
+    CHECK(value_text("say \"hi\"") == "\"say \\\"hi\\\"\"");
+    CHECK(value_text("one\r\ntwo\tthree\\") == "\"one\\ntwo three\\\\\"");
+}
+
+static void test_timestamp() {
+    std::string time = log_timestamp();
+    CHECK(time.size() == 24);
+    if (time.size() != 24) return;
+    for (size_t i : { 4, 7 }) CHECK(time[i] == '-');
+    for (size_t i : { 13, 16 }) CHECK(time[i] == ':');
+    CHECK(time[10] == 'T' && time[19] == '.' && time[23] == 'Z');
+}
+
+static void test_lines() {
+    StructuredLog log;
+    log.write(LogLevel::Info, "ignored"); // not enabled yet
+    CHECK(!log.enabled());
+
+    std::ostringstream mirror;
+    CHECK(!log.open("/nonexistent-dir/log.txt", &mirror));
+    CHECK(log.enabled());
+
+    log.write(LogLevel::Error, "device_not_found", { { "device", "USB Mic" }, { "code", "5" } });
+    std::string line = mirror.str();
+    CHECK(line.compare(0, 5, "time=") == 0);
+    CHECK(line.find(" level=error event=device_not_found device=\"USB Mic\" code=5\n") == 29);
+
+    // Lines from several threads come out whole
+    mirror.str("");
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&log, t] {
+            for (int i = 0; i < 500; i++) log.write(LogLevel::Info, "tick", { { "thread", std::to_string(t) } });
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    std::istringstream lines(mirror.str());
+    int count = 0;
+    while (std::getline(lines, line)) {
+        count++;
+        CHECK(line.size() == 60 && line.find(" level=info event=tick thread=") == 29);
+    }
+    CHECK(count == 2000);
+}
+
+int main() {
+    test_values();
+    test_timestamp();
+    test_lines();
+    return test_result();
+}
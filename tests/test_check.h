@@ -0,0 +1,24 @@
+#pragma once
+
+// Checks for the test programs: a failed CHECK prints where and carries on,
+// main() ends with return test_result().
+
+#include <cstdio>
+
+inline int& test_failures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            test_failures()++; \
+        } \
+    } while (0)
+
+inline int test_result() {
+    if (test_failures()) fprintf(stderr, "%d check(s) failed\n", test_failures());
+    return test_failures() ? 1 : 0;
+}
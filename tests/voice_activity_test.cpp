@@ -0,0 +1,91 @@
+// A recorded clip through the same steps as live audio would take: the WAV
+// fixture is decoded, resampled to a capture rate and fed to the voice
+// activity detector in capture-sized chunks, and the gate has to close,
+// open and close again where the clip changes.
+//
+// data/vad_gate.wav is 3 s of 8-bit mono at 8 kHz: low hiss throughout,
+// with a voiced 180 Hz tone and its second harmonic from 1.2 s to 2.0 s.
+
+#include <string>
+#include <vector>
+
+#include "voice_activity.h"
+#include "wav_decoder.h"
+#include "test_check.h"
+
+const unsigned CAPTURE_RATE = 16000;
+const size_t CHUNK = 160 + 37; // not a whole number of detector frames
+
+struct Edge {
+    bool open;
+    unsigned ms; // into the clip, when the chunk that changed it ended
+};
+
+static std::vector<Edge> gate_edges(const PcmSound& sound, const VadSettings& settings) {
+    VoiceActivityDetector vad;
+    vad.configure(sound.sample_rate, settings);
+
+    std::vector<Edge> edges;
+    std::vector<float> chunk(CHUNK);
+    size_t frames = sound.frames();
+    for (size_t done = 0; done < frames;) {
+        size_t n = frames - done < CHUNK ? frames - done : CHUNK;
+        for (size_t i = 0; i < n; i++) chunk[i] = sound.samples[done + i] / 32768.0f;
+        done += n;
+        if (vad.process(chunk.data(), n)) {
+            edges.push_back({ vad.gate_open(), (unsigned)(done * 1000 / sound.sample_rate) });
+        }
+    }
+    return edges;
+}
+
+static bool near(unsigned ms, unsigned expected) {
+    return ms >= expected && ms <= expected + 20;
+}
+
+static void test_fixture_edges() {
+    PcmSound clip;
+    std::string error;
+    CHECK(load_wav_file(MIC_TEST_DATA_DIR "/vad_gate.wav", clip, &error));
+    CHECK(error.empty());
+    CHECK(clip.sample_rate == 8000 && clip.channels == 1 && clip.frames() == 24000);
+
+    PcmSound captured = convert_pcm(clip, CAPTURE_RATE, 1);
+    CHECK(captured.frames() == 48000);
+
+    VadSettings settings;
+    settings.attack_ms = 30;
+    settings.hangover_ms = 100;
+    settings.release_ms = 500;
+
+    // Hiss closes the gate after the release time, the tone opens it within
+    // the attack time, and it closes once hangover and release have passed
+    std::vector<Edge> edges = gate_edges(captured, settings);
+    CHECK(edges.size() == 3);
+    if (edges.size() == 3) {
+        CHECK(!edges[0].open && near(edges[0].ms, 500));
+        CHECK(edges[1].open && near(edges[1].ms, 1200 + 30));
+        CHECK(!edges[2].open && near(edges[2].ms, 2000 + 100 + 500));
+    }
+
+    // The clip at its own rate gives the same edges
+    std::vector<Edge> native = gate_edges(clip, settings);
+    CHECK(native.size() == edges.size());
+    for (size_t i = 0; i < native.size() && i < edges.size(); i++) {
+        unsigned apart = native[i].ms > edges[i].ms ? native[i].ms - edges[i].ms : edges[i].ms - native[i].ms;
+        CHECK(native[i].open == edges[i].open && apart <= 30);
+    }
+}
+
+static void test_missing_fixture() {
+    PcmSound clip;
+    std::string error;
+    CHECK(!load_wav_file(MIC_TEST_DATA_DIR "/no_such_file.wav", clip, &error));
+    CHECK(error == "cannot open file" && clip.empty());
+}
+
+int main() {
+    test_fixture_edges();
+    test_missing_fixture();
+    return test_result();
+}
@@ -0,0 +1,213 @@
+// decode_wav over files built in memory: every supported sample format,
+// the chunk walk, and files that are truncated or lie about chunk sizes.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "wav_decoder.h"
+#include "test_check.h"
+
+struct Bytes {
+    std::vector<uint8_t> bytes;
+
+    void put(const char* tag) { for (int i = 0; i < 4; i++) bytes.push_back((uint8_t)tag[i]); }
+    void u16(uint16_t v) { bytes.push_back((uint8_t)v); bytes.push_back((uint8_t)(v >> 8)); }
+    void u32(uint32_t v) { u16((uint16_t)v); u16((uint16_t)(v >> 16)); }
+};
+
+struct WavBuilder : Bytes {
+    WavBuilder() {
+        put("RIFF");
+        u32(0); // RIFF size, not checked by the decoder
+        put("WAVE");
+    }
+
+    void chunk(const char* tag, const std::vector<uint8_t>& body, uint32_t declared_size) {
+        put(tag);
+        u32(declared_size);
+        for (uint8_t b : body) bytes.push_back(b);
+    }
+
+    void chunk(const char* tag, const std::vector<uint8_t>& body) {
+        chunk(tag, body, (uint32_t)body.size());
+        if (body.size() & 1) bytes.push_back(0);
+    }
+
+    void fmt(uint16_t format, uint16_t channels, uint32_t rate, uint16_t bits) {
+        Bytes body;
+        body.u16(format);
+        body.u16(channels);
+        body.u32(rate);
+        body.u32(rate * channels * (bits / 8));
+        body.u16((uint16_t)(channels * (bits / 8)));
+        body.u16(bits);
+        chunk("fmt ", body.bytes);
+    }
+
+    // WAVE_FORMAT_EXTENSIBLE wrapping format
+    void fmt_extensible(uint16_t format, uint16_t channels, uint32_t rate, uint16_t bits) {
+        Bytes body;
+        body.u16(0xFFFE);
+        body.u16(channels);
+        body.u32(rate);
+        body.u32(rate * channels * (bits / 8));
+        body.u16((uint16_t)(channels * (bits / 8)));
+        body.u16(bits);
+        body.u16(22);   // extension size
+        body.u16(bits); // valid bits
+        body.u32(0);    // channel mask
+        body.u16(format);
+        body.bytes.resize(body.bytes.size() + 14); // rest of the SubFormat GUID
+        chunk("fmt ", body.bytes);
+    }
+};
+
+static std::vector<uint8_t> le16(const std::vector<int16_t>& samples) {
+    std::vector<uint8_t> bytes;
+    for (int16_t s : samples) {
+        bytes.push_back((uint8_t)s);
+        bytes.push_back((uint8_t)((uint16_t)s >> 8));
+    }
+    return bytes;
+}
+
+static bool decode(const WavBuilder& wav, PcmSound& sound, std::string* error = nullptr) {
+    return decode_wav(wav.bytes.data(), wav.bytes.size(), sound, error);
+}
+
+static void test_formats() {
+    const std::vector<int16_t> expected = { 0, 256, -256, 32512, -32768 };
+    PcmSound sound;
+
+    WavBuilder pcm16;
+    pcm16.fmt(1, 1, 44100, 16);
+    pcm16.chunk("data", le16(expected));
+    CHECK(decode(pcm16, sound));
+    CHECK(sound.sample_rate == 44100 && sound.channels == 1);
+    CHECK(sound.samples == expected);
+
+    WavBuilder pcm8;
+    pcm8.fmt(1, 1, 8000, 8);
+    pcm8.chunk("data", { 128, 129, 127, 255, 0 });
+    CHECK(decode(pcm8, sound));
+    CHECK(sound.samples == expected);
+
+    WavBuilder pcm24;
+    pcm24.fmt(1, 1, 48000, 24);
+    pcm24.chunk("data", { 0x55, 0, 0, 0x55, 0, 1, 0x55, 0, 0xFF, 0x55, 0, 0x7F, 0x55, 0, 0x80 });
+    CHECK(decode(pcm24, sound));
+    CHECK(sound.samples == expected);
+
+    WavBuilder pcm32;
+    pcm32.fmt_extensible(1, 1, 48000, 32);
+    pcm32.chunk("data", { 9, 9, 0, 0, 9, 9, 0, 1, 9, 9, 0, 0xFF, 9, 9, 0, 0x7F, 9, 9, 0, 0x80 });
+    CHECK(decode(pcm32, sound));
+    CHECK(sound.samples == expected);
+
+    WavBuilder ieee;
+    ieee.fmt(3, 2, 48000, 32);
+    std::vector<uint8_t> floats;
+    for (float f : { 0.0f, 0.5f, -0.5f, 2.0f }) {
+        uint32_t raw;
+        memcpy(&raw, &f, sizeof(raw));
+        for (int i = 0; i < 4; i++) floats.push_back((uint8_t)(raw >> (8 * i)));
+    }
+    ieee.chunk("data", floats);
+    CHECK(decode(ieee, sound));
+    CHECK(sound.channels == 2 && sound.frames() == 2);
+    CHECK((sound.samples == std::vector<int16_t>{ 0, 16383, -16383, 32767 }));
+
+    WavBuilder adpcm;
+    adpcm.fmt(2, 1, 8000, 4);
+    adpcm.chunk("data", { 1, 2, 3, 4 });
+    std::string error;
+    CHECK(!decode(adpcm, sound, &error) && error == "unsupported sample format");
+}
+
+static void test_chunk_walk() {
+    PcmSound sound;
+    std::string error;
+
+    // Odd-sized chunks are padded, data may come after any number of them
+    WavBuilder padded;
+    padded.chunk("LIST", { 1, 2, 3 });
+    padded.fmt(1, 1, 22050, 16);
+    padded.chunk("fact", { 4, 5, 6, 7, 8 });
+    padded.chunk("data", le16({ 7, -7 }));
+    CHECK(decode(padded, sound));
+    CHECK((sound.samples == std::vector<int16_t>{ 7, -7 }));
+
+    // A data chunk cut short keeps the whole frames that are there
+    WavBuilder truncated;
+    truncated.fmt(1, 2, 22050, 16);
+    truncated.chunk("data", le16({ 1, 2, 3 }), 1000);
+    CHECK(decode(truncated, sound));
+    CHECK((sound.samples == std::vector<int16_t>{ 1, 2 }));
+
+    WavBuilder no_fmt;
+    no_fmt.chunk("data", le16({ 1 }));
+    CHECK(!decode(no_fmt, sound, &error) && error == "missing fmt chunk");
+
+    WavBuilder short_fmt;
+    short_fmt.chunk("fmt ", { 1, 0, 1, 0 });
+    CHECK(!decode(short_fmt, sound, &error) && error == "truncated fmt chunk");
+
+    WavBuilder no_data;
+    no_data.fmt(1, 1, 8000, 16);
+    CHECK(!decode(no_data, sound, &error) && error == "missing data chunk");
+
+    const uint8_t not_wav[] = { 'R', 'I', 'F', 'X', 0, 0, 0, 0, 'W', 'A', 'V', 'E' };
+    CHECK(!decode_wav(not_wav, sizeof(not_wav), sound, &error) && error == "not a RIFF/WAVE file");
+}
+
+// A chunk size near 4 GB used to wrap pos back where it was with a 32-bit
+// size_t and loop forever. Every size that runs past the end stops the walk.
+static void test_oversized_chunks() {
+    PcmSound sound;
+    std::string error;
+
+    for (uint32_t size : { 0xFFFFFFF8u, 0xFFFFFFF4u, 0xFFFFFFFFu, 0x80000000u, 1000u }) {
+        WavBuilder wav;
+        wav.fmt(1, 1, 8000, 16);
+        wav.chunk("junk", { 0, 0, 0, 0, 0, 0, 0, 0 }, size);
+        wav.chunk("data", le16({ 1, 2 }));
+        CHECK(!decode(wav, sound, &error) && error == "missing data chunk");
+    }
+
+    // Every truncation of a valid file terminates
+    WavBuilder valid;
+    valid.chunk("LIST", { 1, 2, 3 });
+    valid.fmt(1, 1, 8000, 16);
+    valid.chunk("data", le16({ 1, 2, 3, 4 }));
+    for (size_t size = 0; size <= valid.bytes.size(); size++) {
+        decode_wav(valid.bytes.data(), size, sound);
+    }
+}
+
+static void test_convert() {
+    PcmSound mono;
+    mono.sample_rate = 8000;
+    mono.channels = 1;
+    mono.samples = { 0, 100, 200, 300 };
+
+    PcmSound stereo = convert_pcm(mono, 16000, 2);
+    CHECK(stereo.sample_rate == 16000 && stereo.channels == 2);
+    CHECK(stereo.frames() == 8);
+    CHECK(stereo.samples[0] == 0 && stereo.samples[1] == 0);
+    CHECK(stereo.samples[2] == 50 && stereo.samples[3] == 50);
+    CHECK(stereo.samples[14] == 300 && stereo.samples[15] == 300);
+
+    PcmSound back = convert_pcm(stereo, 8000, 1);
+    CHECK(back.samples == mono.samples);
+
+    CHECK(convert_pcm(PcmSound(), 48000, 2).empty());
+}
+
+int main() {
+    test_formats();
+    test_chunk_walk();
+    test_oversized_chunks();
+    test_convert();
+    return test_result();
+}